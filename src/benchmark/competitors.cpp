@@ -0,0 +1,388 @@
+#include "../interprocess/spsc-queue-impl.h"
+#include "../intraprocess/spsc-queue-impl.h"
+#include "histogram.h"
+#include "pacer.h"
+#include "utils.h"
+
+#if __has_include(<boost/lockfree/spsc_queue.hpp>)
+#include <boost/lockfree/spsc_queue.hpp>
+#define HAVE_BOOST_LOCKFREE 1
+#endif
+#if defined(LOCKFREE_HAVE_FOLLY)
+#include <folly/ProducerConsumerQueue.h>
+#endif
+#if __has_include(<rigtorp/SPSCQueue.h>)
+#include <rigtorp/SPSCQueue.h>
+#define HAVE_RIGTORP 1
+#endif
+#if __has_include(<readerwriterqueue/readerwriterqueue.h>)
+#include <readerwriterqueue/readerwriterqueue.h>
+#define HAVE_MOODYCAMEL 1
+#elif __has_include(<readerwriterqueue.h>)
+#include <readerwriterqueue.h>
+#define HAVE_MOODYCAMEL 1
+#endif
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/* Runs the same two workloads against this toolkit's SPSC queues and the
+ * established ones we could adopt instead:
+ *
+ *   competitors [--queues toolkit,shm,boost,folly,rigtorp,moodycamel]
+ *               [--payload 8|64|256] [--messages 10000000]
+ *               [--round-trips 1000000] [--queue-size 65536] [--cpus P,C]
+ *               [--csv]
+ *
+ *   throughput   the producer pushes --messages payloads as fast as it can,
+ *                spinning on full, the consumer pops them and checks their
+ *                order; messages per second between the first and the last
+ *                pop
+ *   round trip   ping-pong through two queues of the same kind, one payload
+ *                in flight; percentiles of the round-trip time in ns
+ *
+ * Every queue gets the same payload type, the same usable capacity and the
+ * same two pinned threads, and is driven through the same try_push/try_pop
+ * adapter, so only the queue differs. Third-party queues are compiled in
+ * when their headers are found, see the competitors feature in vcpkg.json
+ * and LOCKFREE_FETCH_COMPETITORS in src/benchmark/CMakeLists.txt; the
+ * others are reported as unavailable.
+ */
+
+using namespace RingBuffer;
+
+namespace {
+struct Options {
+  std::vector<std::string> queues = {"toolkit", "shm",     "boost",
+                                     "folly",   "rigtorp", "moodycamel"};
+  std::size_t payload = 8;
+  std::uint64_t messages = 10'000'000;
+  std::uint64_t round_trips = 1'000'000;
+  std::size_t queue_size = 65536;
+  int producer_cpu = -1;
+  int consumer_cpu = -1;
+  bool csv = false;
+};
+
+template <std::size_t N> struct Message {
+  std::uint64_t seq;
+  std::array<std::byte, N - sizeof(std::uint64_t)> pad;
+};
+
+// The adapters: usable capacity of exactly queue_size elements each
+
+template <typename P> class ToolkitQueue {
+  Intraprocess::SpscQueue<P> m_q;
+
+public:
+  explicit ToolkitQueue(const std::size_t size) : m_q(size) {}
+  bool try_push(const P &p) { return m_q.enqueue(p); }
+  bool try_pop(P &p) { return m_q.dequeue(p); }
+};
+
+// Both endpoints of a shared memory queue, mapped into this one process
+template <typename P> class ShmQueue {
+  inline static int s_instances = 0;
+  std::string m_name;
+  Interprocess::SpscQueue m_consumer;
+  Interprocess::SpscQueue m_producer;
+  std::string m_buffer;
+
+public:
+  // Sized for about queue_size records, each carries a 4-byte length
+  explicit ShmQueue(const std::size_t size)
+      : m_name("lockfree-competitors-" + std::to_string(getpid()) + "-" +
+               std::to_string(s_instances++)),
+        m_consumer(m_name, true,
+                   static_cast<int>((size + 1) * (sizeof(P) + sizeof(int)))),
+        m_producer(m_name) {}
+  bool try_push(const P &p) {
+    return m_producer.enqueue(std::as_bytes(std::span(&p, 1)));
+  }
+  bool try_pop(P &p) {
+    if (!m_consumer.dequeue(m_buffer))
+      return false;
+    std::memcpy(&p, m_buffer.data(), sizeof(P));
+    return true;
+  }
+};
+
+#if defined(HAVE_BOOST_LOCKFREE)
+template <typename P> class BoostQueue {
+  boost::lockfree::spsc_queue<P> m_q;
+
+public:
+  explicit BoostQueue(const std::size_t size) : m_q(size) {}
+  bool try_push(const P &p) { return m_q.push(p); }
+  bool try_pop(P &p) { return m_q.pop(p); }
+};
+#endif
+
+#if defined(LOCKFREE_HAVE_FOLLY)
+template <typename P> class FollyQueue {
+  // Keeps one slot free, like ours
+  folly::ProducerConsumerQueue<P> m_q;
+
+public:
+  explicit FollyQueue(const std::size_t size)
+      : m_q(static_cast<std::uint32_t>(size + 1)) {}
+  bool try_push(const P &p) { return m_q.write(p); }
+  bool try_pop(P &p) { return m_q.read(p); }
+};
+#endif
+
+#if defined(HAVE_RIGTORP)
+template <typename P> class RigtorpQueue {
+  rigtorp::SPSCQueue<P> m_q;
+
+public:
+  explicit RigtorpQueue(const std::size_t size) : m_q(size) {}
+  bool try_push(const P &p) { return m_q.try_push(p); }
+  bool try_pop(P &p) {
+    P *front = m_q.front();
+    if (front == nullptr)
+      return false;
+    p = *front;
+    m_q.pop();
+    return true;
+  }
+};
+#endif
+
+#if defined(HAVE_MOODYCAMEL)
+template <typename P> class MoodycamelQueue {
+  // Rounds its blocks up to powers of two, so it may hold a few more
+  moodycamel::ReaderWriterQueue<P> m_q;
+
+public:
+  explicit MoodycamelQueue(const std::size_t size) : m_q(size) {}
+  bool try_push(const P &p) { return m_q.try_enqueue(p); }
+  bool try_pop(P &p) { return m_q.try_dequeue(p); }
+};
+#endif
+
+struct Result {
+  double msgs_per_sec = 0;
+  std::uint64_t out_of_order = 0;
+  Histogram round_trip;
+};
+
+Options parse_options(const int argc, char *argv[]) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--queues") {
+      opts.queues = split(option_value(argc, argv, i));
+    } else if (arg == "--payload") {
+      opts.payload = std::stoull(std::string(option_value(argc, argv, i)));
+      if (opts.payload != 8 && opts.payload != 64 && opts.payload != 256)
+        throw std::invalid_argument("--payload takes 8, 64 or 256");
+    } else if (arg == "--messages") {
+      opts.messages = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--round-trips") {
+      opts.round_trips = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--queue-size") {
+      opts.queue_size = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--cpus") {
+      const auto cpus = split(option_value(argc, argv, i));
+      if (cpus.size() != 2)
+        throw std::invalid_argument("--cpus takes PRODUCER,CONSUMER");
+      opts.producer_cpu = std::stoi(cpus[0]);
+      opts.consumer_cpu = std::stoi(cpus[1]);
+    } else if (arg == "--csv") {
+      opts.csv = true;
+    } else {
+      throw std::invalid_argument("Unknown option " + std::string(arg));
+    }
+  }
+  return opts;
+}
+
+template <typename Queue, typename P>
+void measure_throughput(const Options &opts, const TscClock &clock,
+                        Result &result) {
+  auto q = std::make_unique<Queue>(opts.queue_size);
+  std::atomic<bool> go{false};
+  std::thread producer([&] {
+    pin_to_cpu(opts.producer_cpu);
+    P p{};
+    while (!go.load(std::memory_order_acquire)) {
+    }
+    for (std::uint64_t seq = 1; seq <= opts.messages; ++seq) {
+      p.seq = seq;
+      while (!q->try_push(p)) {
+        Detail::cpu_relax();
+      }
+    }
+  });
+
+  pin_to_cpu(opts.consumer_cpu);
+  P p{};
+  go.store(true, std::memory_order_release);
+  while (!q->try_pop(p)) {
+  }
+  const std::uint64_t t_start = clock.now();
+  for (std::uint64_t seq = 2; seq <= opts.messages; ++seq) {
+    while (!q->try_pop(p)) {
+    }
+    if (p.seq != seq)
+      ++result.out_of_order;
+  }
+  const std::uint64_t t_end = clock.now();
+  producer.join();
+  const auto ns = std::max<std::uint64_t>(clock.to_ns(t_end - t_start), 1);
+  result.msgs_per_sec = (opts.messages - 1) / (ns / 1e9);
+}
+
+template <typename Queue, typename P>
+void measure_round_trip(const Options &opts, const TscClock &clock,
+                        Result &result) {
+  auto ping = std::make_unique<Queue>(opts.queue_size);
+  auto pong = std::make_unique<Queue>(opts.queue_size);
+  // The echo side runs on the consumer CPU, the timing side on the producer
+  std::thread echo([&] {
+    pin_to_cpu(opts.consumer_cpu);
+    P p{};
+    for (std::uint64_t i = 0; i < opts.round_trips; ++i) {
+      while (!ping->try_pop(p)) {
+      }
+      while (!pong->try_push(p)) {
+      }
+    }
+  });
+
+  pin_to_cpu(opts.producer_cpu);
+  result.round_trip.reset();
+  P p{};
+  for (std::uint64_t seq = 1; seq <= opts.round_trips; ++seq) {
+    p.seq = seq;
+    const std::uint64_t t0 = clock.now();
+    while (!ping->try_push(p)) {
+    }
+    while (!pong->try_pop(p)) {
+    }
+    result.round_trip.record(clock.to_ns(clock.now() - t0));
+    if (p.seq != seq)
+      ++result.out_of_order;
+  }
+  echo.join();
+  // Back to either CPU for the next queue
+  pin_to_cpu(opts.consumer_cpu);
+}
+
+constexpr struct {
+  double value;
+  const char *label;
+} percentiles[] = {{50, "rtt-p50"}, {99, "rtt-p99"}, {99.9, "rtt-p99.9"}};
+
+void print_header(const Options &opts) {
+  if (opts.csv) {
+    std::cout << "queue,payload_bytes,msgs_per_sec,rtt_p50_ns,rtt_p99_ns,"
+                 "rtt_p99.9_ns,rtt_max_ns\n";
+    return;
+  }
+  std::cout << "# " << opts.payload << "-byte payloads, queue size "
+            << opts.queue_size << ", " << opts.messages
+            << " messages for throughput, " << opts.round_trips
+            << " round trips for latency in ns\n"
+            << std::setw(11) << "queue" << std::setw(14) << "msgs/s";
+  for (const auto &p : percentiles) {
+    std::cout << std::setw(11) << p.label;
+  }
+  std::cout << std::setw(11) << "rtt-max" << "\n";
+}
+
+void print_row(const Options &opts, const std::string &queue,
+               const Result &result) {
+  const char *sep = opts.csv ? "," : "";
+  const int width = opts.csv ? 0 : 11;
+  std::cout << std::setw(width) << queue << sep;
+  if (opts.csv)
+    std::cout << opts.payload << sep;
+  std::cout << std::fixed << std::setprecision(0)
+            << std::setw(opts.csv ? 0 : 14) << result.msgs_per_sec;
+  for (const auto &p : percentiles) {
+    std::cout << sep << std::setw(width)
+              << result.round_trip.value_at(p.value);
+  }
+  std::cout << sep << std::setw(width) << result.round_trip.max << "\n";
+  if (result.out_of_order != 0)
+    std::cerr << queue << ": " << result.out_of_order
+              << " messages arrived out of order\n";
+}
+
+template <typename Queue, typename P>
+void run(const Options &opts, const TscClock &clock,
+         const std::string &queue) {
+  auto result = std::make_unique<Result>();
+  measure_throughput<Queue, P>(opts, clock, *result);
+  measure_round_trip<Queue, P>(opts, clock, *result);
+  print_row(opts, queue, *result);
+}
+
+template <typename P>
+void run_all(const Options &opts, const TscClock &clock) {
+  for (const auto &queue : opts.queues) {
+    if (queue == "toolkit") {
+      run<ToolkitQueue<P>, P>(opts, clock, queue);
+    } else if (queue == "shm") {
+      run<ShmQueue<P>, P>(opts, clock, queue);
+#if defined(HAVE_BOOST_LOCKFREE)
+    } else if (queue == "boost") {
+      run<BoostQueue<P>, P>(opts, clock, queue);
+#endif
+#if defined(LOCKFREE_HAVE_FOLLY)
+    } else if (queue == "folly") {
+      run<FollyQueue<P>, P>(opts, clock, queue);
+#endif
+#if defined(HAVE_RIGTORP)
+    } else if (queue == "rigtorp") {
+      run<RigtorpQueue<P>, P>(opts, clock, queue);
+#endif
+#if defined(HAVE_MOODYCAMEL)
+    } else if (queue == "moodycamel") {
+      run<MoodycamelQueue<P>, P>(opts, clock, queue);
+#endif
+    } else if (queue == "boost" || queue == "folly" || queue == "rigtorp" ||
+               queue == "moodycamel") {
+      std::cerr << queue << ": not available in this build\n";
+    } else {
+      throw std::invalid_argument("Unknown queue " + queue);
+    }
+  }
+}
+} // namespace
+
+int main(const int argc, char *argv[]) {
+  try {
+    const Options opts = parse_options(argc, argv);
+    const TscClock clock;
+    print_header(opts);
+    if (opts.payload == 8)
+      run_all<Message<8>>(opts, clock);
+    else if (opts.payload == 64)
+      run_all<Message<64>>(opts, clock);
+    else
+      run_all<Message<256>>(opts, clock);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
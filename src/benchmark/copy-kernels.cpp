@@ -0,0 +1,123 @@
+#include "../interprocess/copy-kernels.h"
+#include "../interprocess/spsc-queue-impl.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Interprocess;
+
+namespace {
+constexpr std::size_t msg_sizes[] = {64,       256,       1 << 10,
+                                     4 << 10, 16 << 10, 64 << 10};
+constexpr std::size_t bytes_per_run = std::size_t{4} << 30;
+
+const char *kernel_name(const CopyKernel kernel) {
+  switch (kernel) {
+  case CopyKernel::Memcpy:
+    return "memcpy";
+  case CopyKernel::Avx2:
+    return "avx2";
+  case CopyKernel::Avx512:
+    return "avx512";
+  case CopyKernel::Streaming:
+    return "streaming";
+  default:
+    return "auto";
+  }
+}
+
+// Copies msg_size chunks into a destination much larger than the LLC, the way
+// the producer writes into a ring the consumer drains on another core
+void bench_kernels() {
+  std::vector<char> src(msg_sizes[std::size(msg_sizes) - 1], 'x');
+  std::vector<char> dst(std::size_t{256} << 20);
+  std::cout << "kernel bandwidth (GB/s)\n" << std::setw(10) << "size";
+  for (const auto kernel : {CopyKernel::Memcpy, CopyKernel::Avx2,
+                            CopyKernel::Avx512, CopyKernel::Streaming}) {
+    std::cout << std::setw(11) << kernel_name(kernel);
+  }
+  std::cout << "\n";
+  for (const auto msg_size : msg_sizes) {
+    std::cout << std::setw(10) << msg_size;
+    for (const auto kernel : {CopyKernel::Memcpy, CopyKernel::Avx2,
+                              CopyKernel::Avx512, CopyKernel::Streaming}) {
+      if (!copy_kernel_supported(kernel)) {
+        std::cout << std::setw(11) << "n/a";
+        continue;
+      }
+      const auto copy = copy_function(kernel);
+      std::size_t offset = 0;
+      const auto t0 = std::chrono::steady_clock::now();
+      for (std::size_t copied = 0; copied < bytes_per_run;
+           copied += msg_size) {
+        if (offset + msg_size > dst.size())
+          offset = 0;
+        copy(dst.data() + offset, src.data(), msg_size);
+        offset += msg_size;
+      }
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - t0;
+      std::cout << std::setw(11) << std::fixed << std::setprecision(2)
+                << bytes_per_run / elapsed.count() / 1e9;
+    }
+    std::cout << "\n";
+  }
+}
+
+// End-to-end: a producer and a consumer thread on an Interprocess::SpscQueue
+void bench_queue(const std::string &label, const CopyOptions &copy,
+                 const std::size_t msg_size) {
+  const std::string name = "copy-kernels-bench";
+  constexpr int queue_size = 4 << 20;
+  const std::size_t msg_count = bytes_per_run / 4 / msg_size;
+  auto q_con = SpscQueue(name, true, queue_size,
+                         {.record_alignment = 64, .copy = copy});
+  auto q_prd = SpscQueue(name, false, 0, {.copy = copy});
+
+  const auto t0 = std::chrono::steady_clock::now();
+  std::thread consumer([&] {
+    std::string received;
+    for (std::size_t i = 0; i < msg_count;) {
+      if (q_con.dequeue(received))
+        ++i;
+    }
+  });
+  const std::string payload(msg_size, 'x');
+  for (std::size_t i = 0; i < msg_count;) {
+    if (q_prd.enqueue(payload))
+      ++i;
+  }
+  consumer.join();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - t0;
+  std::cout << std::setw(10) << msg_size << std::setw(28) << label
+            << std::setw(12) << std::fixed << std::setprecision(2)
+            << msg_count / elapsed.count() / 1e6 << "M msg/sec"
+            << std::setw(10) << msg_count * msg_size / elapsed.count() / 1e9
+            << " GB/s\n";
+}
+} // namespace
+
+int main() {
+  bench_kernels();
+  std::cout << "\nInterprocess::SpscQueue (record_alignment = 64)\n";
+  for (const auto msg_size : msg_sizes) {
+    bench_queue("memcpy", {}, msg_size);
+    bench_queue("auto", {.kernel = CopyKernel::Auto}, msg_size);
+    bench_queue("auto + prefetch",
+                {.kernel = CopyKernel::Auto, .prefetch_next = true}, msg_size);
+    bench_queue("auto + streaming >= 4KiB",
+                {.kernel = CopyKernel::Auto,
+                 .streaming_threshold = 4 << 10,
+                 .prefetch_next = true},
+                msg_size);
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+#include "../intraprocess/work-stealing-pool-impl.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+/* Fork-join scaling of WorkStealingPool: a recursive parallel sum and a
+ * parallel quicksort, each run on 1, 2, 4, ... workers and compared with the
+ * serial algorithm.
+ *
+ *   fork-join [--threads 1,2,4,8] [--sum-size N] [--sort-size N]
+ */
+namespace {
+constexpr std::size_t sum_grain = 16 << 10;
+constexpr std::ptrdiff_t sort_grain = 4 << 10;
+
+std::uint64_t parallel_sum(WorkStealingPool &pool, const std::uint64_t *data,
+                           const std::size_t n) {
+  if (n <= sum_grain)
+    return std::accumulate(data, data + n, std::uint64_t{0});
+  std::uint64_t left = 0;
+  WorkStealingPool::TaskGroup group(pool);
+  group.run([&] { left = parallel_sum(pool, data, n / 2); });
+  const std::uint64_t right = parallel_sum(pool, data + n / 2, n - n / 2);
+  group.wait();
+  return left + right;
+}
+
+void parallel_quicksort(WorkStealingPool &pool, int *first, int *last) {
+  while (last - first > sort_grain) {
+    const int pivot = first[(last - first) / 2];
+    int *mid1 = std::partition(first, last, [&](int v) { return v < pivot; });
+    int *mid2 = std::partition(mid1, last, [&](int v) { return v == pivot; });
+    WorkStealingPool::TaskGroup group(pool);
+    group.run([&pool, first, mid1] { parallel_quicksort(pool, first, mid1); });
+    // Sort the right half ourselves instead of spawning and idling
+    parallel_quicksort(pool, mid2, last);
+    group.wait();
+    return;
+  }
+  std::sort(first, last);
+}
+
+template <typename F> double seconds(F &&fn) {
+  const auto t0 = std::chrono::steady_clock::now();
+  fn();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+void print_row(const std::string &name, const std::size_t threads,
+               const double secs, const double serial_secs) {
+  std::cout << std::setw(8) << name << std::setw(9) << threads << std::setw(12)
+            << std::fixed << std::setprecision(4) << secs << std::setw(10)
+            << std::setprecision(2) << serial_secs / secs << "x\n";
+}
+} // namespace
+
+int main(const int argc, char *argv[]) {
+  std::vector<std::size_t> thread_counts;
+  std::size_t sum_size = 200'000'000;
+  std::size_t sort_size = 20'000'000;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string_view arg = argv[i];
+      if (arg == "--threads") {
+        thread_counts.clear();
+        for (const auto &count : split(option_value(argc, argv, i))) {
+          thread_counts.push_back(std::stoull(count));
+        }
+      } else if (arg == "--sum-size") {
+        sum_size = std::stoull(std::string(option_value(argc, argv, i)));
+      } else if (arg == "--sort-size") {
+        sort_size = std::stoull(std::string(option_value(argc, argv, i)));
+      } else {
+        throw std::invalid_argument("Unknown option " + std::string(arg));
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+  if (thread_counts.empty()) {
+    for (std::size_t n = 1; n <= std::thread::hardware_concurrency(); n *= 2) {
+      thread_counts.push_back(n);
+    }
+  }
+
+  std::vector<std::uint64_t> values(sum_size);
+  std::iota(values.begin(), values.end(), 0);
+  std::vector<int> unsorted(sort_size);
+  std::mt19937 rng(42);
+  std::ranges::generate(unsorted, rng);
+
+  std::uint64_t expected_sum = 0;
+  const double serial_sum = seconds([&] {
+    expected_sum = std::accumulate(values.begin(), values.end(),
+                                   std::uint64_t{0});
+  });
+  std::vector<int> sorted = unsorted;
+  const double serial_sort = seconds([&] { std::ranges::sort(sorted); });
+
+  std::cout << std::setw(8) << "job" << std::setw(9) << "threads"
+            << std::setw(12) << "seconds" << std::setw(11) << "speedup\n";
+  print_row("sum", 0, serial_sum, serial_sum);
+  print_row("sort", 0, serial_sort, serial_sort);
+  for (const auto threads : thread_counts) {
+    WorkStealingPool pool(threads);
+    std::uint64_t sum = 0;
+    const double sum_secs =
+        seconds([&] { sum = parallel_sum(pool, values.data(), values.size()); });
+    std::vector<int> data = unsorted;
+    const double sort_secs = seconds([&] {
+      parallel_quicksort(pool, data.data(), data.data() + data.size());
+    });
+    if (sum != expected_sum || data != sorted) {
+      std::cerr << "Wrong result with " << threads << " threads\n";
+      return EXIT_FAILURE;
+    }
+    print_row("sum", threads, sum_secs, serial_sum);
+    print_row("sort", threads, sort_secs, serial_sort);
+  }
+  return 0;
+}
@@ -0,0 +1,79 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace RingBuffer {
+
+/* A log-linear latency histogram: values below 16 get a bucket each, every
+ * power of two above that is split into 16 buckets, so a reported value is
+ * at most 1/16 above the recorded one. It has a fixed size and no pointers,
+ * so a child process can fill it in shared memory and the parent reads it.
+ */
+struct Histogram {
+  static constexpr int SUB_BITS = 4;
+  static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+  static constexpr int BUCKETS = SUB_BUCKETS * (64 - SUB_BITS + 1);
+
+  std::uint64_t counts[BUCKETS];
+  std::uint64_t total;
+  std::uint64_t max;
+
+  static int bucket_of(const std::uint64_t value) {
+    if (value < SUB_BUCKETS)
+      return static_cast<int>(value);
+    const int shift = static_cast<int>(std::bit_width(value)) - 1 - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS +
+           static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+  }
+
+  // Smallest value that lands in bucket
+  static std::uint64_t lower_bound(const int bucket) {
+    if (bucket < SUB_BUCKETS)
+      return bucket;
+    const int shift = bucket / SUB_BUCKETS - 1;
+    return static_cast<std::uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS)
+           << shift;
+  }
+
+  void reset() { std::memset(this, 0, sizeof(*this)); }
+
+  void record(const std::uint64_t value) {
+    ++counts[bucket_of(value)];
+    ++total;
+    max = std::max(max, value);
+  }
+
+  void merge(const Histogram &other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+      counts[i] += other.counts[i];
+    }
+    total += other.total;
+    max = std::max(max, other.max);
+  }
+
+  /// @param percentile e.g., 99.9
+  /// @return the highest value of the bucket the percentile falls into,
+  /// capped at the largest recorded value, 0 if nothing was recorded
+  [[nodiscard]] std::uint64_t value_at(const double percentile) const {
+    if (total == 0)
+      return 0;
+    const auto rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * total)));
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+      seen += counts[i];
+      if (seen >= rank)
+        return i + 1 < BUCKETS ? std::min(lower_bound(i + 1) - 1, max) : max;
+    }
+    return max;
+  }
+};
+
+} // namespace RingBuffer
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,434 @@
+#include "../interprocess/spsc-queue-impl.h"
+#include "histogram.h"
+#include "utils.h"
+
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/* A self-contained Interprocess::SpscQueue benchmark. For every combination
+ * of queue size and message size the parent creates (and owns) the segment,
+ * then forks a producer and a consumer child, optionally pinned to CPUs:
+ *
+ *   parent ---- owns the queue segment and an anonymous shared mapping
+ *    |          with the phase controls and results
+ *    +-- producer: stamps each message with {sequence number, send time}
+ *    +-- consumer: checks the order, records end-to-end latency
+ *
+ * A phase runs for a fixed duration or a fixed message count. The consumer's
+ * latency histogram and counters come back through the shared mapping. The
+ * parent reaps both children; if one of them crashes or the phase times out
+ * it kills the other, and the segment is removed either way because only the
+ * parent owns it.
+ *
+ *   interprocess-bench [--msg-sizes 16,64,256] [--queue-sizes 65536,1048576]
+ *                      [--duration-ms 2000 | --count N] [--warmup N]
+ *                      [--cpus P,C] [--alignment 1|8|64] [--drain]
+ *                      [--timeout-ms 60000] [--csv]
+ */
+
+using namespace RingBuffer;
+using namespace RingBuffer::Interprocess;
+
+namespace {
+volatile std::sig_atomic_t interrupted = 0;
+
+void handle_interrupt(int) { interrupted = 1; }
+
+struct Options {
+  std::vector<std::size_t> msg_sizes = {16, 64, 256, 1024, 4096};
+  std::vector<std::size_t> queue_sizes = {64 << 10, 1 << 20};
+  // Fixed-count phases if count > 0, fixed-duration phases otherwise
+  std::uint64_t count = 0;
+  std::uint64_t duration_ms = 2000;
+  std::uint64_t warmup = 10'000;
+  std::uint64_t timeout_ms = 60'000;
+  int producer_cpu = -1;
+  int consumer_cpu = -1;
+  int alignment = 1;
+  bool drain = false;
+  bool csv = false;
+};
+
+// Leads every message
+struct MessageHeader {
+  std::uint64_t seq; // 1, 2, ...
+  std::uint64_t sent_ns;
+};
+
+struct alignas(64) Control {
+  std::uint64_t go;
+  std::uint64_t stop;
+};
+struct alignas(64) ProducerStats {
+  std::uint64_t ready;
+  std::uint64_t sent;
+  std::uint64_t done;
+};
+struct alignas(64) ConsumerStats {
+  std::uint64_t ready;
+  std::uint64_t received;
+  std::uint64_t out_of_order;
+  // Between the last warmup message and the last message
+  std::uint64_t elapsed_ns;
+  Histogram latency;
+};
+// Lives in a MAP_SHARED | MAP_ANONYMOUS mapping inherited by both children
+struct PhaseResults {
+  Control control;
+  ProducerStats producer;
+  ConsumerStats consumer;
+};
+
+struct Phase {
+  std::size_t queue_size;
+  std::size_t msg_size;
+};
+
+std::uint64_t now_ns() {
+  // steady_clock is CLOCK_MONOTONIC on Linux, comparable across processes
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <typename T> std::uint64_t load(T &word) {
+  return std::atomic_ref(word).load(std::memory_order_acquire);
+}
+
+template <typename T> void store(T &word, const std::uint64_t value) {
+  std::atomic_ref(word).store(value, std::memory_order_release);
+}
+
+std::vector<std::size_t> parse_list(const std::string_view arg) {
+  std::vector<std::size_t> values;
+  for (const auto &value : split(arg)) {
+    values.push_back(std::stoull(value));
+  }
+  return values;
+}
+
+Options parse_options(const int argc, char *argv[]) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--msg-sizes") {
+      opts.msg_sizes = parse_list(option_value(argc, argv, i));
+    } else if (arg == "--queue-sizes") {
+      opts.queue_sizes = parse_list(option_value(argc, argv, i));
+    } else if (arg == "--count") {
+      opts.count = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--duration-ms") {
+      opts.duration_ms = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--warmup") {
+      opts.warmup = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--timeout-ms") {
+      opts.timeout_ms = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--cpus") {
+      const auto cpus = parse_list(option_value(argc, argv, i));
+      if (cpus.size() != 2)
+        throw std::invalid_argument("--cpus takes PRODUCER,CONSUMER");
+      opts.producer_cpu = static_cast<int>(cpus[0]);
+      opts.consumer_cpu = static_cast<int>(cpus[1]);
+    } else if (arg == "--alignment") {
+      opts.alignment = std::stoi(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--drain") {
+      opts.drain = true;
+    } else if (arg == "--csv") {
+      opts.csv = true;
+    } else {
+      throw std::invalid_argument("Unknown option " + std::string(arg));
+    }
+  }
+  for (const auto msg_size : opts.msg_sizes) {
+    if (msg_size < sizeof(MessageHeader))
+      throw std::invalid_argument("Messages must be at least " +
+                                  std::to_string(sizeof(MessageHeader)) +
+                                  " bytes");
+  }
+  return opts;
+}
+
+// Runs in the child: dies with the parent, leaves SIGINT to the parent and
+// never returns into the parent's stack
+template <typename F> pid_t fork_child(const int cpu, F &&body) {
+  const pid_t pid = fork();
+  if (pid != 0)
+    return pid;
+  prctl(PR_SET_PDEATHSIG, SIGKILL);
+  std::signal(SIGINT, SIG_IGN);
+  std::signal(SIGTERM, SIG_IGN);
+  pin_to_cpu(cpu);
+  int status = EXIT_SUCCESS;
+  try {
+    body();
+  } catch (const std::exception &e) {
+    std::cerr << "child " << getpid() << ": " << e.what() << "\n";
+    status = EXIT_FAILURE;
+  }
+  _exit(status);
+}
+
+void run_producer(const std::string &name, const Options &opts,
+                  const Phase &phase, PhaseResults &results) {
+  auto q = SpscQueue(name);
+  std::string payload(phase.msg_size, 'x');
+  const std::uint64_t count =
+      opts.count > 0 ? opts.count : std::numeric_limits<std::uint64_t>::max();
+  store(results.producer.ready, 1);
+  while (load(results.control.go) == 0) {
+  }
+  std::uint64_t sent = 0;
+  while (sent < count && load(results.control.stop) == 0) {
+    const MessageHeader header{sent + 1, now_ns()};
+    std::memcpy(payload.data(), &header, sizeof(header));
+    if (q.enqueue(payload))
+      ++sent;
+  }
+  store(results.producer.sent, sent);
+  store(results.producer.done, 1);
+}
+
+void run_consumer(const std::string &name, const Options &opts,
+                  PhaseResults &results) {
+  auto q = SpscQueue(name);
+  auto &stats = results.consumer;
+  // Recorded locally, copied into the shared mapping at the end
+  auto latency = std::make_unique<Histogram>();
+  latency->reset();
+  std::uint64_t received = 0;
+  std::uint64_t out_of_order = 0;
+  store(stats.ready, 1);
+  while (load(results.control.go) == 0) {
+  }
+  std::uint64_t t_start = now_ns();
+  std::uint64_t t_last = t_start;
+
+  auto on_message = [&](const void *data) {
+    MessageHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    t_last = now_ns();
+    if (header.seq != received + 1)
+      ++out_of_order;
+    ++received;
+    if (received == opts.warmup)
+      t_start = t_last;
+    else if (received > opts.warmup)
+      latency->record(t_last - header.sent_ns);
+  };
+  std::string buffer;
+  while (true) {
+    bool got;
+    if (opts.drain) {
+      got = q.consume_all([&](const std::span<const std::byte> msg) {
+        on_message(msg.data());
+      }) > 0;
+    } else {
+      got = q.dequeue(buffer);
+      if (got)
+        on_message(buffer.data());
+    }
+    if (!got && load(results.producer.done) != 0 &&
+        received == load(results.producer.sent))
+      break;
+  }
+  stats.latency = *latency;
+  stats.out_of_order = out_of_order;
+  stats.elapsed_ns = t_last - t_start;
+  store(stats.received, received);
+}
+
+// Forks both children and supervises them until they exit
+bool run_phase(const Options &opts, const Phase &phase,
+               PhaseResults &results) {
+  std::memset(&results, 0, sizeof(results));
+  const std::string name = "lockfree-bench-" + std::to_string(getpid());
+  const auto owner =
+      SpscQueue(name, true, static_cast<int>(phase.queue_size),
+                {.record_alignment = opts.alignment});
+
+  pid_t children[2];
+  children[0] = fork_child(opts.producer_cpu, [&] {
+    run_producer(name, opts, phase, results);
+  });
+  children[1] =
+      fork_child(opts.consumer_cpu, [&] { run_consumer(name, opts, results); });
+
+  using namespace std::chrono;
+  const auto t_fork = steady_clock::now();
+  auto t_go = t_fork;
+  bool ok = true;
+  int alive = 2;
+  while (alive > 0) {
+    for (auto &child : children) {
+      int status;
+      if (child <= 0 || waitpid(child, &status, WNOHANG) != child)
+        continue;
+      child = 0;
+      --alive;
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        std::cerr << "A child " << (WIFSIGNALED(status) ? "was killed by signal "
+                                                        : "exited with ")
+                  << (WIFSIGNALED(status) ? WTERMSIG(status)
+                                          : WEXITSTATUS(status))
+                  << "\n";
+        ok = false;
+      }
+    }
+    const auto now = steady_clock::now();
+    if (ok && now - t_fork > milliseconds(opts.timeout_ms)) {
+      std::cerr << "Phase timed out\n";
+      ok = false;
+    }
+    if (!ok) {
+      for (const auto child : children) {
+        if (child > 0)
+          kill(child, SIGKILL);
+      }
+    }
+    if (load(results.control.go) == 0 && load(results.producer.ready) != 0 &&
+        load(results.consumer.ready) != 0) {
+      t_go = now;
+      store(results.control.go, 1);
+    }
+    if (load(results.control.go) != 0 && load(results.control.stop) == 0 &&
+        (interrupted ||
+         (opts.count == 0 && now - t_go >= milliseconds(opts.duration_ms))))
+      store(results.control.stop, 1);
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  if (ok && results.consumer.out_of_order != 0) {
+    std::cerr << results.consumer.out_of_order
+              << " messages arrived out of order\n";
+    ok = false;
+  }
+  return ok;
+}
+
+constexpr struct {
+  double value;
+  const char *label;
+} percentiles[] = {
+    {50, "p50"}, {90, "p90"}, {99, "p99"}, {99.9, "p99.9"}, {99.99, "p99.99"}};
+
+void print_header(const Options &opts) {
+  if (opts.csv) {
+    std::cout << "queue_size,msg_size,messages,msgs_per_sec,bytes_per_sec,"
+                 "p50_ns,p90_ns,p99_ns,p99.9_ns,p99.99_ns,max_ns\n";
+    return;
+  }
+  std::cout << "# Interprocess::SpscQueue, record_alignment "
+            << opts.alignment << ", "
+            << (opts.count > 0
+                    ? std::to_string(opts.count) + " messages"
+                    : std::to_string(opts.duration_ms) + " ms")
+            << " per phase, " << opts.warmup << " warmup messages, cpus "
+            << opts.producer_cpu << "," << opts.consumer_cpu
+            << (opts.drain ? ", consume_all()" : ", dequeue()") << "\n"
+            << std::setw(10) << "queue" << std::setw(8) << "msg"
+            << std::setw(12) << "messages" << std::setw(11) << "M msg/s"
+            << std::setw(10) << "MB/s";
+  for (const auto &p : percentiles) {
+    std::cout << std::setw(9) << p.label;
+  }
+  std::cout << std::setw(10) << "max(ns)\n";
+}
+
+void print_row(const Options &opts, const Phase &phase,
+               const PhaseResults &results) {
+  const auto &stats = results.consumer;
+  const std::uint64_t measured =
+      stats.received > opts.warmup ? stats.received - opts.warmup : 0;
+  const double seconds = stats.elapsed_ns / 1e9;
+  const double msgs_per_sec = seconds > 0 ? measured / seconds : 0;
+  std::vector<std::uint64_t> latencies;
+  for (const auto &p : percentiles) {
+    latencies.push_back(stats.latency.value_at(p.value));
+  }
+  latencies.push_back(stats.latency.max);
+
+  if (opts.csv) {
+    std::cout << phase.queue_size << "," << phase.msg_size << ","
+              << stats.received << "," << std::fixed << std::setprecision(0)
+              << msgs_per_sec << "," << msgs_per_sec * phase.msg_size;
+    for (const auto latency : latencies) {
+      std::cout << "," << latency;
+    }
+  } else {
+    std::cout << std::setw(10) << phase.queue_size << std::setw(8)
+              << phase.msg_size << std::setw(12) << stats.received
+              << std::setw(11) << std::fixed << std::setprecision(2)
+              << msgs_per_sec / 1e6 << std::setw(10) << std::setprecision(0)
+              << msgs_per_sec * phase.msg_size / 1e6;
+    for (std::size_t i = 0; i < latencies.size(); ++i) {
+      std::cout << std::setw(i + 1 < latencies.size() ? 9 : 10)
+                << latencies[i];
+    }
+  }
+  std::cout << "\n" << std::defaultfloat;
+}
+} // namespace
+
+int main(const int argc, char *argv[]) {
+  Options opts;
+  try {
+    opts = parse_options(argc, argv);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+  std::signal(SIGINT, handle_interrupt);
+  std::signal(SIGTERM, handle_interrupt);
+
+  void *mapping = mmap(nullptr, sizeof(PhaseResults), PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    perror("mmap()");
+    return EXIT_FAILURE;
+  }
+  auto &results = *static_cast<PhaseResults *>(mapping);
+
+  print_header(opts);
+  int status = EXIT_SUCCESS;
+  for (const auto queue_size : opts.queue_sizes) {
+    for (const auto msg_size : opts.msg_sizes) {
+      if (interrupted)
+        break;
+      const Phase phase{queue_size, msg_size};
+      // Leave room for a wrap marker, padding and a free alignment unit
+      if (2 * (msg_size + 64) > queue_size) {
+        std::cerr << "Skipping " << msg_size << "-byte messages on a "
+                  << queue_size << "-byte queue\n";
+        continue;
+      }
+      try {
+        if (run_phase(opts, phase, results))
+          print_row(opts, phase, results);
+        else
+          status = EXIT_FAILURE;
+      } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        status = EXIT_FAILURE;
+      }
+    }
+  }
+  munmap(mapping, sizeof(PhaseResults));
+  return status;
+}
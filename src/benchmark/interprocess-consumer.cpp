@@ -4,22 +4,51 @@
 
 
 #include <csignal>
+#include <cstring>
 #include <iostream>
+#include <string_view>
 
 using namespace RingBuffer;
 
-using SpscQueueImpl = Interprocess::SpscQueueBeta;
-// using SpscQueueImpl = Interprocess::SpscQueue;
+template <typename Queue> void run(const bool drain) {
+  auto q = Queue("test", true, 171);
+  consumer_func(q, drain);
+}
 
-int main() {
+int main(const int argc, char *argv[]) {
 
   if (signal(SIGINT, handle_signal) == SIG_ERR ||
       signal(SIGTERM, handle_signal) == SIG_ERR) {
     perror("signal()");
     return EXIT_FAILURE;
   }
-  auto q = SpscQueueImpl("test", true, 171);
-  consumer_func(q);
+  // --drain: sweep with consume_all() instead of dequeue()
+  // --queue spsc|beta: the implementation under test, the producer must be
+  // started with the same one
+  bool drain = false;
+  std::string_view queue = "beta";
+  try {
+    for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "--drain") == 0)
+        drain = true;
+      else if (std::strcmp(argv[i], "--queue") == 0)
+        queue = option_value(argc, argv, i);
+      else
+        throw std::invalid_argument("Unknown option " + std::string(argv[i]));
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (queue == "spsc") {
+    run<Interprocess::SpscQueue>(drain);
+  } else if (queue == "beta") {
+    run<Interprocess::SpscQueueBeta>(drain);
+  } else {
+    std::cerr << "Unknown --queue " << queue << "\n";
+    return EXIT_FAILURE;
+  }
   std::cout << "Exited gracefully\n";
   return 0;
 }
@@ -3,22 +3,47 @@
 #include "utils.h"
 
 #include <csignal>
+#include <cstring>
 #include <iostream>
+#include <string_view>
 
 using namespace RingBuffer;
 
-using SpscQueueImpl = Interprocess::SpscQueueBeta;
-// using SpscQueueImpl = Interprocess::SpscQueue;
+template <typename Queue> void run() {
+  // The consumer owns the segment, its size is read from the segment header
+  auto q = Queue("test");
+  producer_func(q);
+}
 
-int main() {
+int main(const int argc, char *argv[]) {
   if (signal(SIGINT, handle_signal) == SIG_ERR ||
       signal(SIGTERM, handle_signal) == SIG_ERR) {
     perror("signal()");
     return EXIT_FAILURE;
   }
 
-  auto q = SpscQueueImpl("test", false, 171);
-  producer_func(q);
+  // --queue spsc|beta: the same implementation as the consumer's
+  std::string_view queue = "beta";
+  try {
+    for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "--queue") == 0)
+        queue = option_value(argc, argv, i);
+      else
+        throw std::invalid_argument("Unknown option " + std::string(argv[i]));
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (queue == "spsc") {
+    run<Interprocess::SpscQueue>();
+  } else if (queue == "beta") {
+    run<Interprocess::SpscQueueBeta>();
+  } else {
+    std::cerr << "Unknown --queue " << queue << "\n";
+    return EXIT_FAILURE;
+  }
   std::cout << "Exited gracefully\n";
   return 0;
 }
@@ -1,3 +1,4 @@
+#include "../intraprocess/policy-queue-impl.h"
 #include "utils.h"
 
 #include <csignal>
@@ -5,30 +6,55 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <string_view>
 #include <thread>
 
 using namespace RingBuffer;
 
-//template <typename T> using SpscQueueImpl = Intraprocess::SpscQueueBeta<T>;
-template <typename T>  using SpscQueueImpl = Intraprocess::SpscQueue<T>;
-
 constexpr size_t q_size = INT16_MAX;
 
-int main() {
+template <typename Queue> void run(const bool drain) {
+  Queue q{1'000'000};
+  std::thread thread_consumer(consumer_func<Queue, uint64_t>, std::ref(q),
+                              drain);
+  std::thread thread_producer(producer_func<Queue, uint64_t>, std::ref(q));
+
+  thread_consumer.join();
+  thread_producer.join();
+}
+
+int main(const int argc, char *argv[]) {
   if (signal(SIGINT, handle_signal) == SIG_ERR ||
       signal(SIGTERM, handle_signal) == SIG_ERR) {
     perror("signal()");
     return EXIT_FAILURE;
   }
 
-  SpscQueueImpl<uint64_t> q{1'000'000};
-  std::thread thread_consumer(consumer_func<SpscQueueImpl<uint64_t>, uint64_t>,
-                              std ::ref(q));
-  std::thread thread_producer(producer_func<SpscQueueImpl<uint64_t>, uint64_t>,
-                              std::ref(q));
+  // --drain: the consumer sweeps with consume_all() instead of dequeue()
+  // --queue spsc|beta|masked|masked-cached: the implementation under test
+  bool drain = false;
+  std::string_view queue = "spsc";
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--drain") == 0)
+      drain = true;
+    else if (std::strcmp(argv[i], "--queue") == 0 && i + 1 < argc)
+      queue = argv[++i];
+  }
 
-  thread_consumer.join();
-  thread_producer.join();
+  using namespace Intraprocess::QueuePolicy;
+  if (queue == "spsc") {
+    run<Intraprocess::SpscQueue<uint64_t>>(drain);
+  } else if (queue == "beta") {
+    run<Intraprocess::SpscQueueBeta<uint64_t>>(drain);
+  } else if (queue == "masked") {
+    run<Intraprocess::PolicyQueue<uint64_t, HeapStorage, MaskIndex<>>>(drain);
+  } else if (queue == "masked-cached") {
+    run<Intraprocess::PolicyQueue<uint64_t, HugePageStorage,
+                                  MaskIndex<true>>>(drain);
+  } else {
+    std::cerr << "Unknown --queue " << queue << std::endl;
+    return EXIT_FAILURE;
+  }
   std::cout << "Exited gracefully" << std::endl;
   return 0;
-}
\ No newline at end of file
+}
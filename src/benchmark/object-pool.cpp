@@ -0,0 +1,130 @@
+#include "../intraprocess/object-pool-impl.h"
+#include "../intraprocess/spsc-queue-impl.h"
+#include "utils.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+/* Producer/consumer churn: the producer allocates a message, hands the
+ * pointer to the consumer through SpscQueue<Message *>, the consumer frees
+ * it. Allocation and release therefore always happen on different threads,
+ * the case general-purpose allocators handle worst. Compared are
+ * new/delete, ObjectPool directly and ObjectPool behind per-thread Caches.
+ *
+ *   object-pool [--messages N] [--in-flight N]
+ *
+ * To compare with jemalloc (or any other malloc), preload it, which
+ * replaces the new/delete row:
+ *
+ *   LD_PRELOAD=/usr/lib/x86_64-linux-gnu/libjemalloc.so.2 ./object-pool
+ */
+namespace {
+struct Message {
+  std::uint64_t id;
+  char payload[120];
+
+  explicit Message(const std::uint64_t i) : id(i) { payload[0] = 0; }
+};
+
+template <typename Alloc, typename Free>
+double churn(const std::uint64_t messages, const std::size_t in_flight,
+             Alloc &&alloc, Free &&free) {
+  SpscQueue<Message *> q(in_flight);
+  const auto t0 = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    for (std::uint64_t i = 0; i < messages; ++i) {
+      Message *msg;
+      while ((msg = alloc(0, i)) == nullptr) {
+        std::this_thread::yield();
+      }
+      while (!q.enqueue(msg)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  Message *msg;
+  for (std::uint64_t i = 0; i < messages; ++i) {
+    while (!q.dequeue(msg)) {
+      std::this_thread::yield();
+    }
+    if (msg->id != i) {
+      std::cerr << "Out of order message " << msg->id << "\n";
+      std::exit(EXIT_FAILURE);
+    }
+    free(1, msg);
+  }
+  producer.join();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+void print_row(const std::string &name, const std::uint64_t messages,
+               const double secs) {
+  std::cout << std::setw(14) << name << std::setw(12) << std::fixed
+            << std::setprecision(4) << secs << std::setw(12)
+            << std::setprecision(1) << secs * 1e9 / messages << "\n";
+}
+} // namespace
+
+int main(const int argc, char *argv[]) {
+  std::uint64_t messages = 10'000'000;
+  std::size_t in_flight = 1024;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string_view arg = argv[i];
+      if (arg == "--messages") {
+        messages = std::stoull(std::string(option_value(argc, argv, i)));
+      } else if (arg == "--in-flight") {
+        in_flight = std::stoull(std::string(option_value(argc, argv, i)));
+      } else {
+        throw std::invalid_argument("Unknown option " + std::string(arg));
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  std::cout << std::setw(14) << "allocator" << std::setw(12) << "seconds"
+            << std::setw(12) << "ns/msg\n";
+  print_row("new/delete", messages,
+            churn(
+                messages, in_flight,
+                [](int, const std::uint64_t i) { return new Message(i); },
+                [](int, const Message *msg) { delete msg; }));
+
+  // Queue slots plus one Cache batch per side, so the producer never starves
+  ObjectPool<Message> pool(in_flight + 2 * 64);
+  print_row("pool", messages,
+            churn(
+                messages, in_flight,
+                [&](int, const std::uint64_t i) { return pool.create(i); },
+                [&](int, Message *msg) { pool.destroy(msg); }));
+
+  {
+    ObjectPool<Message>::Cache caches[2] = {ObjectPool<Message>::Cache(pool),
+                                            ObjectPool<Message>::Cache(pool)};
+    print_row("pool+cache", messages,
+              churn(
+                  messages, in_flight,
+                  [&](const int side, const std::uint64_t i) {
+                    return caches[side].create(i);
+                  },
+                  [&](const int side, Message *msg) {
+                    caches[side].destroy(msg);
+                  }));
+  }
+  return 0;
+}
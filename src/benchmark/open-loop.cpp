@@ -0,0 +1,302 @@
+#include "../interprocess/broadcast-queue-impl.h"
+#include "../interprocess/mpsc-queue-impl.h"
+#include "../interprocess/spsc-queue-beta-impl.h"
+#include "../interprocess/spsc-queue-impl.h"
+#include "../intraprocess/byte-queue-impl.h"
+#include "../intraprocess/mpmc-queue-impl.h"
+#include "../intraprocess/policy-queue-impl.h"
+#include "../intraprocess/spsc-queue-beta-impl.h"
+#include "../intraprocess/spsc-queue-impl.h"
+#include "histogram.h"
+#include "pacer.h"
+#include "utils.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/* An open-loop latency benchmark. producer_func() in utils.h enqueues as fast
+ * as it can and so only shows saturation throughput; here the producer
+ * follows a Pacer schedule at a fixed offered rate, steady or Poisson, and
+ * stamps every message with its intended send time. The consumer records
+ * latency from that intended time, so a stalled producer or a full queue
+ * shows up in the percentiles instead of silently lowering the rate
+ * (coordinated omission). Every queue runs at every rate of the sweep:
+ *
+ *   open-loop [--rates 100000,500000,1000000] [--duration-ms 1000]
+ *             [--arrivals steady|poisson] [--queue-size 4096]
+ *             [--queues spsc,beta,masked,mpmc,byte,shm,...] [--warmup N]
+ *             [--cpus P,C] [--csv]
+ *
+ * The shared memory queues, shm, shm-beta, shm-mpsc and shm-broadcast, are
+ * mapped twice by this process, once per end, so that both ends go through
+ * their own mapping as separate processes would.
+ */
+
+using namespace RingBuffer;
+
+namespace {
+struct Options {
+  std::vector<double> rates = {100'000, 500'000, 1'000'000, 2'000'000};
+  std::uint64_t duration_ms = 1000;
+  Arrivals arrivals = Arrivals::Steady;
+  std::size_t queue_size = 4096;
+  std::vector<std::string> queues = {
+      "spsc", "beta", "masked", "mpmc", "byte",
+      "shm", "shm-beta", "shm-mpsc", "shm-broadcast"};
+  std::uint64_t warmup = 10'000;
+  int producer_cpu = -1;
+  int consumer_cpu = -1;
+  bool csv = false;
+};
+
+// The whole message
+struct Stamp {
+  std::uint64_t seq; // 1, 2, ...
+  std::uint64_t intended_tick;
+};
+
+struct RateResult {
+  std::uint64_t received = 0;
+  std::uint64_t out_of_order = 0;
+  std::uint64_t elapsed_ns = 0;
+  Histogram latency;
+};
+
+template <typename M> Stamp stamp_of(const M &msg) {
+  if constexpr (std::is_same_v<std::remove_cvref_t<M>, Stamp>) {
+    return msg;
+  } else {
+    Stamp stamp;
+    std::memcpy(&stamp, std::ranges::data(msg), sizeof(stamp));
+    return stamp;
+  }
+}
+
+// Element queues take the Stamp itself, byte queues its bytes
+template <typename Queue> bool send(Queue &q, const Stamp &stamp) {
+  if constexpr (requires { q.enqueue(stamp); })
+    return q.enqueue(stamp);
+  else
+    return q.enqueue(std::as_bytes(std::span(&stamp, 1)));
+}
+
+Options parse_options(const int argc, char *argv[]) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--rates") {
+      opts.rates.clear();
+      for (const auto &rate : split(option_value(argc, argv, i))) {
+        opts.rates.push_back(std::stod(rate));
+      }
+    } else if (arg == "--duration-ms") {
+      opts.duration_ms = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--arrivals") {
+      const auto arrivals = option_value(argc, argv, i);
+      if (arrivals != "steady" && arrivals != "poisson")
+        throw std::invalid_argument("--arrivals takes steady or poisson");
+      opts.arrivals =
+          arrivals == "steady" ? Arrivals::Steady : Arrivals::Poisson;
+    } else if (arg == "--queue-size") {
+      opts.queue_size = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--queues") {
+      opts.queues = split(option_value(argc, argv, i));
+    } else if (arg == "--warmup") {
+      opts.warmup = std::stoull(std::string(option_value(argc, argv, i)));
+    } else if (arg == "--cpus") {
+      const auto cpus = split(option_value(argc, argv, i));
+      if (cpus.size() != 2)
+        throw std::invalid_argument("--cpus takes PRODUCER,CONSUMER");
+      opts.producer_cpu = std::stoi(cpus[0]);
+      opts.consumer_cpu = std::stoi(cpus[1]);
+    } else if (arg == "--csv") {
+      opts.csv = true;
+    } else {
+      throw std::invalid_argument("Unknown option " + std::string(arg));
+    }
+  }
+  return opts;
+}
+
+/// Runs one rate: the producer thread sends rate * duration messages on
+/// schedule through producer_q, this thread receives them from consumer_q
+/// (the same queue, or the other end of a shared memory one).
+template <typename ProducerQueue, typename ConsumerQueue>
+void measure(const Options &opts, const TscClock &clock, const double rate,
+             ProducerQueue &producer_q, ConsumerQueue &consumer_q,
+             RateResult &result) {
+  const auto count = std::max<std::uint64_t>(
+      opts.warmup + 1,
+      static_cast<std::uint64_t>(rate * opts.duration_ms / 1000));
+  std::atomic<bool> go{false};
+  std::thread producer([&] {
+    pin_to_cpu(opts.producer_cpu);
+    Pacer pacer(clock, rate, opts.arrivals);
+    while (!go.load(std::memory_order_acquire)) {
+    }
+    pacer.start();
+    for (std::uint64_t seq = 1; seq <= count; ++seq) {
+      const std::uint64_t due = pacer.next();
+      pacer.wait_until(due);
+      // Full: retry, the message stays stamped with when it was due
+      while (!send(producer_q, Stamp{seq, due})) {
+        Detail::cpu_relax();
+      }
+    }
+  });
+
+  pin_to_cpu(opts.consumer_cpu);
+  result.latency.reset();
+  std::uint64_t t_start = 0;
+  std::uint64_t t_last = 0;
+  auto on_message = [&](const Stamp &stamp) {
+    t_last = clock.now();
+    if (stamp.seq != result.received + 1)
+      ++result.out_of_order;
+    ++result.received;
+    // Without warmup the window opens with the first message
+    if (result.received == std::max<std::uint64_t>(opts.warmup, 1))
+      t_start = t_last;
+    if (result.received > opts.warmup)
+      result.latency.record(
+          clock.to_ns(t_last > stamp.intended_tick
+                          ? t_last - stamp.intended_tick
+                          : 0));
+  };
+  go.store(true, std::memory_order_release);
+  while (result.received < count) {
+    consumer_q.consume_up_to(64, [&](const auto &msg) {
+      on_message(stamp_of(msg));
+    });
+  }
+  producer.join();
+  result.elapsed_ns = clock.to_ns(t_last - t_start);
+}
+
+constexpr struct {
+  double value;
+  const char *label;
+} percentiles[] = {
+    {50, "p50"}, {90, "p90"}, {99, "p99"}, {99.9, "p99.9"}, {99.99, "p99.99"}};
+
+void print_header(const Options &opts) {
+  if (opts.csv) {
+    std::cout << "queue,offered_msgs_per_sec,achieved_msgs_per_sec,"
+                 "p50_ns,p90_ns,p99_ns,p99.9_ns,p99.99_ns,max_ns\n";
+    return;
+  }
+  std::cout << "# open loop, "
+            << (opts.arrivals == Arrivals::Steady ? "steady" : "poisson")
+            << " arrivals, " << opts.duration_ms << " ms per rate, "
+            << opts.warmup << " warmup messages, queue size "
+            << opts.queue_size << ", latency in ns from the intended send "
+            << "time\n"
+            << std::setw(14) << "queue" << std::setw(12) << "offered"
+            << std::setw(12) << "achieved";
+  for (const auto &p : percentiles) {
+    std::cout << std::setw(10) << p.label;
+  }
+  std::cout << std::setw(11) << "max\n";
+}
+
+void print_row(const Options &opts, const std::string &queue,
+               const double rate, const RateResult &result) {
+  const std::uint64_t measured =
+      result.received > opts.warmup ? result.received - opts.warmup : 0;
+  const double achieved =
+      result.elapsed_ns > 0 ? measured / (result.elapsed_ns / 1e9) : 0;
+  const char *sep = opts.csv ? "," : "";
+  const int width = opts.csv ? 0 : 10;
+  std::cout << std::setw(opts.csv ? 0 : 14) << queue << sep << std::fixed
+            << std::setprecision(0) << std::setw(opts.csv ? 0 : 12) << rate
+            << sep << std::setw(opts.csv ? 0 : 12) << achieved;
+  for (const auto &p : percentiles) {
+    std::cout << sep << std::setw(width) << result.latency.value_at(p.value);
+  }
+  std::cout << sep << std::setw(width) << result.latency.max << "\n";
+  if (result.out_of_order != 0)
+    std::cerr << queue << ": " << result.out_of_order
+              << " messages arrived out of order\n";
+}
+
+void sweep(const Options &opts, const TscClock &clock,
+           const std::string &queue) {
+  using namespace Intraprocess::QueuePolicy;
+  auto result = std::make_unique<RateResult>();
+  const std::string name = "lockfree-open-loop-" + std::to_string(getpid());
+  const int shm_size = static_cast<int>(opts.queue_size * 32);
+  for (const double rate : opts.rates) {
+    *result = {};
+    if (queue == "spsc") {
+      Intraprocess::SpscQueue<Stamp> q(opts.queue_size);
+      measure(opts, clock, rate, q, q, *result);
+    } else if (queue == "beta") {
+      Intraprocess::SpscQueueBeta<Stamp> q(opts.queue_size);
+      measure(opts, clock, rate, q, q, *result);
+    } else if (queue == "masked") {
+      Intraprocess::PolicyQueue<Stamp, HeapStorage, MaskIndex<true>> q(
+          opts.queue_size);
+      measure(opts, clock, rate, q, q, *result);
+    } else if (queue == "mpmc") {
+      // Unbounded, queue_size only sizes its node pool
+      Intraprocess::MpmcQueue<Stamp> q({.pooled_nodes = opts.queue_size});
+      measure(opts, clock, rate, q, q, *result);
+    } else if (queue == "byte") {
+      Intraprocess::ByteQueue q(opts.queue_size * 32);
+      measure(opts, clock, rate, q, q, *result);
+    } else if (queue == "shm") {
+      auto consumer_q = Interprocess::SpscQueue(name, true, shm_size);
+      auto producer_q = Interprocess::SpscQueue(name);
+      measure(opts, clock, rate, producer_q, consumer_q, *result);
+    } else if (queue == "shm-beta") {
+      auto consumer_q = Interprocess::SpscQueueBeta(name, true, shm_size);
+      auto producer_q = Interprocess::SpscQueueBeta(name);
+      measure(opts, clock, rate, producer_q, consumer_q, *result);
+    } else if (queue == "shm-mpsc") {
+      // One producer, so one lane of the whole size
+      auto consumer_q = Interprocess::MpscQueue(name, true, shm_size, 1);
+      auto producer_q = Interprocess::MpscQueue(name);
+      measure(opts, clock, rate, producer_q, consumer_q, *result);
+    } else if (queue == "shm-broadcast") {
+      // The producer owns a broadcast segment, one subscriber reads it
+      auto producer_q = Interprocess::BroadcastQueue(name, true, shm_size);
+      auto consumer_q = Interprocess::BroadcastQueue(name);
+      measure(opts, clock, rate, producer_q, consumer_q, *result);
+    } else {
+      throw std::invalid_argument("Unknown queue " + queue);
+    }
+    print_row(opts, queue, rate, *result);
+  }
+}
+} // namespace
+
+int main(const int argc, char *argv[]) {
+  try {
+    const Options opts = parse_options(argc, argv);
+    const TscClock clock;
+    print_header(opts);
+    for (const auto &queue : opts.queues) {
+      sweep(opts, clock, queue);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include "../detail/platform.h"
+
+#include <cstdint>
+#include <random>
+
+namespace RingBuffer {
+
+/* A cheap timestamp source for pacing and latency measurement: ticks of
+ * Detail::tsc_now(), the TSC on x86 and steady_clock nanoseconds elsewhere,
+ * converted with the calibration of Detail::tsc_ticks_per_ns(). Ticks are
+ * only comparable within one machine with an invariant TSC, which every x86
+ * server of the last decade has.
+ */
+class TscClock {
+  double m_ticks_per_ns = Detail::tsc_ticks_per_ns();
+
+public:
+  [[nodiscard]] std::uint64_t now() const { return Detail::tsc_now(); }
+
+  [[nodiscard]] std::uint64_t to_ns(const std::uint64_t ticks) const {
+    return static_cast<std::uint64_t>(ticks / m_ticks_per_ns);
+  }
+
+  [[nodiscard]] std::uint64_t from_ns(const double ns) const {
+    return static_cast<std::uint64_t>(ns * m_ticks_per_ns);
+  }
+};
+
+enum class Arrivals {
+  // Evenly spaced messages, 1/rate apart
+  Steady,
+  // Exponentially distributed gaps with mean 1/rate, i.e., bursty
+  Poisson,
+};
+
+/* The schedule of an open-loop producer: next() returns when the next
+ * message is due, independent of when the previous one actually went out.
+ * A producer that stalls (queue full, preempted) therefore sends the
+ * messages that fell due meanwhile back to back, and a consumer measuring
+ * latency from the intended send time sees the whole stall instead of only
+ * the one message that hit it, which corrects coordinated omission.
+ */
+class Pacer {
+  const TscClock &m_clock;
+  Arrivals m_arrivals;
+  double m_mean_gap_ticks;
+  double m_due;
+  std::mt19937_64 m_rng;
+  std::exponential_distribution<double> m_gap{1.0};
+
+public:
+  /// @param rate messages per second
+  Pacer(const TscClock &clock, const double rate, const Arrivals arrivals,
+        const std::uint64_t seed = 42)
+      : m_clock(clock), m_arrivals(arrivals),
+        m_mean_gap_ticks(static_cast<double>(clock.from_ns(1e9 / rate))),
+        m_due(static_cast<double>(clock.now())), m_rng(seed) {}
+
+  /// Restarts the schedule at the current time.
+  void start() { m_due = static_cast<double>(m_clock.now()); }
+
+  /// Intended send time of the next message, in clock ticks.
+  std::uint64_t next() {
+    m_due += m_arrivals == Arrivals::Steady
+                 ? m_mean_gap_ticks
+                 : m_mean_gap_ticks * m_gap(m_rng);
+    return static_cast<std::uint64_t>(m_due);
+  }
+
+  /// Spins until due, returns at once if it is in the past.
+  void wait_until(const std::uint64_t due) const {
+    while (m_clock.now() < due) {
+      Detail::cpu_relax();
+    }
+  }
+};
+
+} // namespace RingBuffer
+
+#endif // PACER_H
@@ -6,7 +6,7 @@
 using namespace RingBuffer;
 
 int main() {
-  auto q = Interprocess::SpscQueue("asdf123", false, (17 + 4) * 2);
+  auto q = Interprocess::SpscQueue("asdf123");
   const std::string bytes = "Hello world!";
   for (int i = 0; i < 11000; ++i) {
     auto payload = bytes + std::to_string(i);
@@ -6,10 +6,19 @@
 #include "../intraprocess/spsc-queue-impl.h"
 #include "../ringbuffer-interface.h"
 
+#include <sched.h>
+
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <cstring>
 #include <iomanip>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <type_traits>
+#include <vector>
 
 static volatile int ev_flag = 0;
 
@@ -24,6 +33,37 @@ struct Payload {
 
 inline void handle_signal(int) { ev_flag = 1; }
 
+// Splits a comma-separated option value, "a,,b" gives "a", "" and "b"
+inline std::vector<std::string> split(const std::string_view arg) {
+  std::vector<std::string> values;
+  std::size_t begin = 0;
+  while (begin <= arg.size()) {
+    const std::size_t end = std::min(arg.find(',', begin), arg.size());
+    values.emplace_back(arg.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return values;
+}
+
+/// Returns the value of the option argv[i] and advances i past it.
+/// @throw std::invalid_argument if argv[i] is the last argument
+inline std::string_view option_value(const int argc, char *argv[], int &i) {
+  if (i + 1 >= argc)
+    throw std::invalid_argument(std::string(argv[i]) + " needs a value");
+  return argv[++i];
+}
+
+// Pins the calling thread, a negative cpu leaves it unpinned
+inline void pin_to_cpu(const int cpu) {
+  if (cpu < 0)
+    return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (sched_setaffinity(0, sizeof(set), &set) != 0)
+    perror(("sched_setaffinity(" + std::to_string(cpu) + ")").c_str());
+}
+
 template <typename TImpl, typename T>
 void producer_func(IRingBuffer<TImpl, T> &q) {
   using namespace std::chrono;
@@ -42,26 +82,31 @@ void producer_func(IRingBuffer<TImpl, T> &q) {
   }
 }
 
+// Extracts the message id from whatever the queue hands out: the element
+// itself, a copy of the record, or a view of it for consume_all()
+template <typename M> uint64_t message_id(const M &raw_msg) {
+  uint64_t msg;
+  if constexpr (std::is_same_v<M, uint64_t>) {
+    msg = raw_msg;
+  } else if constexpr (std::is_same_v<M, std::string> ||
+                       std::is_same_v<M, std::span<const std::byte>>) {
+    std::memcpy(&msg, raw_msg.data(), sizeof(msg));
+  } else {
+    static_assert(always_false<M>, "Unsupported message type");
+  }
+  return msg;
+}
+
+/// @param drain sweep the queue with consume_all() instead of dequeue()ing
+/// one message at a time
 template <typename TImpl, typename T>
-void consumer_func(IRingBuffer<TImpl, T> &q) {
+void consumer_func(IRingBuffer<TImpl, T> &q, const bool drain = false) {
   using namespace std::chrono;
   auto t0 = duration_cast<milliseconds>(system_clock::now().time_since_epoch())
                 .count();
   uint64_t t0_id = 0;
   uint64_t prev_msg = 0;
-  while (!ev_flag) {
-    T raw_msg;
-    if (!q.dequeue(raw_msg))
-      continue;
-
-    uint64_t msg;
-    if constexpr (std::is_same_v<T, uint64_t>) {
-      msg = raw_msg;
-    } else if constexpr (std::is_same_v<T, std::string>) {
-      std::memcpy(&msg, raw_msg.data(), sizeof(msg));
-    } else {
-      static_assert(always_false<T>, "Unsupported message type");
-    }
+  auto on_message = [&](const uint64_t msg) {
     if (prev_msg + 1 != msg) {
       std::cerr << "Unexpected message id: " << msg
                 << ", prev_msg: " << prev_msg << ", q.head():" << q.head()
@@ -70,12 +115,12 @@ void consumer_func(IRingBuffer<TImpl, T> &q) {
     }
     prev_msg = msg;
     if (msg % 10'000'000 != 0)
-      continue;
+      return;
     const auto t1 =
         duration_cast<milliseconds>(system_clock::now().time_since_epoch())
             .count();
     if (t1 - t0 < 5000)
-      continue;
+      return;
 
     std::cout << "msg: " << msg << ", throughput: " << std::fixed
               << std::setprecision(2)
@@ -84,6 +129,17 @@ void consumer_func(IRingBuffer<TImpl, T> &q) {
               << std::defaultfloat;
     t0 = t1;
     t0_id = msg;
+  };
+  while (!ev_flag) {
+    if (drain) {
+      q.consume_all(
+          [&](const auto &raw_msg) { on_message(message_id(raw_msg)); });
+      continue;
+    }
+    T raw_msg;
+    if (!q.dequeue(raw_msg))
+      continue;
+    on_message(message_id(raw_msg));
   }
 }
 
@@ -0,0 +1,191 @@
+#ifndef DETAIL_HAZARD_POINTERS_H
+#define DETAIL_HAZARD_POINTERS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/* Refer to
+ * - M. M. Michael, "Hazard Pointers: Safe Memory Reclamation for Lock-Free
+ *   Objects", IEEE TPDS 2004
+ */
+
+/* Safe memory reclamation for lock-free structures whose nodes are unlinked
+ * by one thread while others may still be reading them. Before
+ * dereferencing a shared pointer a thread publishes it in one of its hazard
+ * slots; a node that was unlinked is retire()d instead of freed, and is only
+ * handed to its reclaimer once no hazard slot holds it:
+ *
+ *   HazardDomain<2> domain;                       // one per structure
+ *   HazardDomain<2>::Guard guard(domain);         // one per operation
+ *   Node *node = guard.protect(0, shared_head);   // safe to dereference
+ *   ...unlink node...
+ *   guard.retire(node, &free_node, context);      // freed later
+ *
+ * A Guard borrows one of MAX_RECORDS records (hazard slots plus a list of
+ * retired nodes) for the duration of an operation, so threads need no
+ * registration and may come and go; the record and its retired nodes pass
+ * on to the next Guard that borrows it. A record scans all hazard slots
+ * once it holds SCAN_THRESHOLD retired nodes, which bounds the garbage to
+ * SCAN_THRESHOLD + MAX_RECORDS * HAZARDS nodes per record.
+ */
+namespace RingBuffer::Detail {
+
+template <std::size_t HAZARDS> class HazardDomain {
+public:
+  static constexpr std::size_t MAX_RECORDS = 128;
+  static constexpr std::size_t SCAN_THRESHOLD = 64;
+
+  /// Called with the retired pointer and the context passed to retire()
+  /// once no thread can reach the pointer anymore.
+  using Reclaimer = void (*)(void *ptr, void *context);
+
+private:
+  struct Retired {
+    void *ptr;
+    Reclaimer reclaim;
+    void *context;
+  };
+
+  struct alignas(64) Record {
+    std::atomic<bool> busy{false};
+    std::atomic<void *> hazards[HAZARDS]{};
+    // Only touched by the Guard holding the record, kept across scans so
+    // that steady state does not allocate
+    std::vector<Retired> retired;
+    std::vector<void *> scratch;
+  };
+
+  Record m_records[MAX_RECORDS];
+
+  void scan(Record &record) {
+    // Pairs with the seq_cst store in protect(): a reader either published
+    // its hazard before we read the slots, or it re-reads the source after
+    // the node was unlinked and retries
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<void *> &hazards = record.scratch;
+    hazards.clear();
+    for (Record &r : m_records) {
+      for (auto &hazard : r.hazards) {
+        if (void *ptr = hazard.load(std::memory_order_acquire))
+          hazards.push_back(ptr);
+      }
+    }
+    std::ranges::sort(hazards);
+    std::size_t kept = 0;
+    for (const Retired &node : record.retired) {
+      if (std::ranges::binary_search(hazards, node.ptr))
+        record.retired[kept++] = node;
+      else
+        node.reclaim(node.ptr, node.context);
+    }
+    record.retired.resize(kept);
+  }
+
+public:
+  /// Borrows a record for one operation. Guards are cheap to create, but
+  /// a thread must not hold more than one Guard of the same domain at a
+  /// time, and at most MAX_RECORDS Guards can be alive at once (further
+  /// ones wait).
+  class Guard {
+  private:
+    HazardDomain &m_domain;
+    std::size_t m_index;
+    Record *m_record;
+
+    static inline thread_local std::size_t tl_hint =
+        std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+  public:
+    explicit Guard(HazardDomain &domain) : m_domain(domain) {
+      for (std::size_t i = tl_hint;; ++i) {
+        Record &record = domain.m_records[i % MAX_RECORDS];
+        if (!record.busy.load(std::memory_order_relaxed) &&
+            !record.busy.exchange(true, std::memory_order_acquire)) {
+          m_index = i % MAX_RECORDS;
+          m_record = &record;
+          // Likely free again the next time this thread comes along
+          tl_hint = m_index;
+          return;
+        }
+        if (i % MAX_RECORDS == MAX_RECORDS - 1)
+          std::this_thread::yield();
+      }
+    }
+
+    Guard(const Guard &) = delete;
+
+    Guard &operator=(const Guard &) = delete;
+
+    ~Guard() {
+      for (auto &hazard : m_record->hazards) {
+        hazard.store(nullptr, std::memory_order_release);
+      }
+      m_record->busy.store(false, std::memory_order_release);
+    }
+
+    /// Loads src and publishes it in hazard slot i; the returned pointer
+    /// stays valid until the slot is overwritten or cleared, or the Guard
+    /// goes away.
+    template <typename P> P *protect(const std::size_t i,
+                                     const std::atomic<P *> &src) {
+      P *ptr = src.load(std::memory_order_acquire);
+      while (true) {
+        m_record->hazards[i].store(ptr, std::memory_order_seq_cst);
+        P *again = src.load(std::memory_order_acquire);
+        if (again == ptr)
+          return ptr;
+        ptr = again;
+      }
+    }
+
+    void clear(const std::size_t i) {
+      m_record->hazards[i].store(nullptr, std::memory_order_release);
+    }
+
+    /// Hands ptr, already unreachable for new readers, to the domain;
+    /// reclaim(ptr, context) runs once no hazard slot holds it, on whichever
+    /// thread happens to scan this record.
+    void retire(void *ptr, const Reclaimer reclaim, void *context) {
+      m_record->retired.push_back({ptr, reclaim, context});
+      if (m_record->retired.size() >= SCAN_THRESHOLD)
+        m_domain.scan(*m_record);
+    }
+
+    /// Index of the borrowed record, in [0, MAX_RECORDS). A structure may
+    /// keep per-record state of its own, it is never shared by two live
+    /// Guards.
+    [[nodiscard]] std::size_t index() const { return m_index; }
+  };
+
+  HazardDomain() = default;
+
+  HazardDomain(const HazardDomain &) = delete;
+
+  HazardDomain &operator=(const HazardDomain &) = delete;
+
+  /// No Guard may be alive anymore: reclaims everything still retired.
+  ~HazardDomain() {
+    for (Record &record : m_records) {
+      for (const Retired &node : record.retired) {
+        node.reclaim(node.ptr, node.context);
+      }
+    }
+  }
+
+  /// Number of retired nodes not reclaimed yet. Only meaningful while no
+  /// Guard is alive.
+  [[nodiscard]] std::size_t retired_approx() const {
+    std::size_t n = 0;
+    for (const Record &record : m_records) {
+      n += record.retired.size();
+    }
+    return n;
+  }
+};
+} // namespace RingBuffer::Detail
+
+#endif // DETAIL_HAZARD_POINTERS_H
@@ -0,0 +1,82 @@
+#ifndef DETAIL_OVERWRITE_RING_H
+#define DETAIL_OVERWRITE_RING_H
+
+#include "seqlock.h"
+
+#include <atomic>
+#include <cstdint>
+
+/* The overwrite-oldest ring shared by Intraprocess::OverwriteQueue and
+ * Interprocess::OverwriteQueue: capacity (a power of two) seqlocked slots
+ * plus a count of messages written so far.
+ *
+ * Message n goes to slot n & (capacity - 1), so after the k-th write to a
+ * slot its seq is 2k and the slot holds message (k - 1) * capacity + slot.
+ * The producer never looks at consumers: it overwrites the slot and bumps
+ * written. A consumer expecting message n knows from the slot's seq whether
+ * n is not written yet (seq too small), readable (seq matches) or already
+ * overwritten (seq too large). In the last case it skips to the oldest
+ * message still in the ring and counts the gap as dropped.
+ */
+namespace RingBuffer::Detail {
+
+template <typename T> struct OverwriteRing {
+  SeqlockSlot<T> *slots;
+  std::uint64_t mask; // capacity - 1
+  std::uint64_t &written;
+};
+
+/// Producer side, never fails or waits.
+template <typename T>
+void overwrite_ring_push(const OverwriteRing<T> &ring, const T &value) {
+  const std::atomic_ref written(ring.written);
+  // Only the producer writes `written`
+  const std::uint64_t n = written.load(std::memory_order_relaxed);
+  seqlock_store(ring.slots[n & ring.mask], value);
+  written.store(n + 1, std::memory_order_release);
+}
+
+/// Consumer side.
+/// @param cursor the next message the consumer expects, advanced on success
+/// and when the consumer falls behind
+/// @param dropped incremented by the number of messages overwritten before
+/// the consumer could read them
+/// @return false if message cursor has not been written yet
+template <typename T>
+bool overwrite_ring_pop(const OverwriteRing<T> &ring, std::uint64_t &cursor,
+                        std::uint64_t &dropped, T &value) {
+  const std::uint64_t capacity = ring.mask + 1;
+  while (true) {
+    auto &slot = ring.slots[cursor & ring.mask];
+    const std::uint64_t expected_seq = 2 * (cursor / capacity + 1);
+    const std::uint64_t seq =
+        std::atomic_ref(slot.seq).load(std::memory_order_acquire);
+    // Not written yet, or the producer is writing it right now
+    if (seq < expected_seq)
+      return false;
+    std::uint64_t read_seq;
+    if (seq == expected_seq && seqlock_try_load(slot, value, read_seq) &&
+        read_seq == expected_seq) {
+      ++cursor;
+      return true;
+    }
+    // Lapped: resume at the oldest message that has not been overwritten
+    const std::uint64_t written =
+        std::atomic_ref(ring.written).load(std::memory_order_acquire);
+    const std::uint64_t oldest = written > capacity ? written - capacity : 0;
+    const std::uint64_t resume = oldest > cursor ? oldest : cursor + 1;
+    dropped += resume - cursor;
+    cursor = resume;
+  }
+}
+
+inline std::uint64_t overwrite_ring_capacity(const std::uint64_t requested) {
+  std::uint64_t capacity = 1;
+  while (capacity < requested) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+} // namespace RingBuffer::Detail
+
+#endif // DETAIL_OVERWRITE_RING_H
@@ -0,0 +1,118 @@
+#ifndef DETAIL_PLATFORM_H
+#define DETAIL_PLATFORM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+/* Small platform shims shared by the containers: a spin-loop hint, a cheap
+ * timestamp counter and anonymous memory backed by huge pages.
+ */
+namespace RingBuffer::Detail {
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield");
+#elif defined(_MSC_VER)
+  _mm_pause();
+#endif
+}
+
+inline std::uint64_t steady_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/// The TSC on x86, steady_clock nanoseconds elsewhere. Ticks of different
+/// threads and processes are comparable as long as the TSC is invariant,
+/// which it is on every x86 server of the last decade.
+inline std::uint64_t tsc_now() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+  return __rdtsc();
+#else
+  return steady_ns();
+#endif
+}
+
+/// TSC ticks per nanosecond, calibrated against steady_clock for 10 ms on
+/// the first call, to convert ticks for display and for the benchmarks'
+/// pacing. 1.0 where tsc_now() already counts nanoseconds.
+inline double tsc_ticks_per_ns() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+  static const double ticks_per_ns = [] {
+    const std::uint64_t ns0 = steady_ns();
+    const std::uint64_t ticks0 = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const std::uint64_t ticks1 = __rdtsc();
+    const std::uint64_t ns1 = steady_ns();
+    return static_cast<double>(ticks1 - ticks0) / (ns1 - ns0);
+  }();
+  return ticks_per_ns;
+#else
+  return 1.0;
+#endif
+}
+
+inline std::uint64_t tsc_to_ns(const std::uint64_t ticks) {
+  return static_cast<std::uint64_t>(ticks / tsc_ticks_per_ns());
+}
+
+constexpr std::size_t HUGE_PAGE_SIZE = 2 << 20;
+
+/// Maps at least size bytes of zeroed anonymous memory, rounded up to whole
+/// 2 MiB pages: explicit huge pages if the system has some reserved,
+/// otherwise regular pages with transparent huge pages requested.
+/// @return nullptr where anonymous mappings are not available, the caller
+/// then falls back to the heap
+/// @throw std::bad_alloc if the mapping fails
+inline void *map_huge_pages(const std::size_t size, std::size_t &mapped_size) {
+#if defined(MAP_ANONYMOUS)
+  mapped_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  void *addr = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+  addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+  if (addr == MAP_FAILED) {
+    addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if defined(MADV_HUGEPAGE)
+    if (addr != MAP_FAILED)
+      madvise(addr, mapped_size, MADV_HUGEPAGE);
+#endif
+  }
+  if (addr == MAP_FAILED)
+    throw std::bad_alloc();
+  return addr;
+#else
+  (void) size;
+  mapped_size = 0;
+  return nullptr;
+#endif
+}
+
+inline void unmap_huge_pages(void *addr, const std::size_t mapped_size) {
+#if defined(MAP_ANONYMOUS)
+  munmap(addr, mapped_size);
+#else
+  (void) addr;
+  (void) mapped_size;
+#endif
+}
+} // namespace RingBuffer::Detail
+
+#endif // DETAIL_PLATFORM_H
@@ -0,0 +1,96 @@
+#ifndef DETAIL_SEQLOCK_H
+#define DETAIL_SEQLOCK_H
+
+#include "platform.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/* The seqlock protocol shared by Intraprocess::Seqlock and
+ * Interprocess::Seqlock. A slot is a sequence counter plus the value stored as
+ * 64-bit words:
+ *
+ *   +-----------+---------+---------+-----+
+ *   | seq       | word 0  | word 1  | ... |
+ *   +-----------+---------+---------+-----+
+ *
+ * The single writer of a slot makes seq odd, stores the words and makes seq
+ * even again, so it never waits for anybody. A reader copies the words
+ * between two reads of seq and retries if seq was odd or changed, i.e., if
+ * the copy may be torn. The words are accessed through relaxed atomics, so
+ * the racy copy is well-defined, and seq / 2 is the version of the value.
+ *
+ * Everything operates on plain integers through std::atomic_ref, so that the
+ * same code runs on the heap and in shared memory.
+ */
+namespace RingBuffer::Detail {
+
+template <typename T>
+constexpr std::size_t seqlock_words = (sizeof(T) + 7) / sizeof(std::uint64_t);
+
+template <typename T> struct alignas(64) SeqlockSlot {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "A seqlock copies T bytewise, T must be trivially copyable");
+  std::uint64_t seq;
+  std::uint64_t words[seqlock_words<T>];
+};
+
+/// Publishes value, only one thread/process may write a given slot at a time.
+template <typename T>
+void seqlock_store(SeqlockSlot<T> &slot, const T &value) {
+  std::uint64_t buffer[seqlock_words<T>] = {};
+  std::memcpy(buffer, &value, sizeof(T));
+  const std::atomic_ref seq(slot.seq);
+  const auto version = seq.load(std::memory_order_relaxed);
+  seq.store(version + 1, std::memory_order_relaxed);
+  // Readers that see any of the words below also see the odd seq
+  std::atomic_thread_fence(std::memory_order_release);
+  for (std::size_t i = 0; i < seqlock_words<T>; ++i) {
+    std::atomic_ref(slot.words[i]).store(buffer[i], std::memory_order_relaxed);
+  }
+  seq.store(version + 2, std::memory_order_release);
+}
+
+/// One read attempt, false if the copy may be torn and has to be retried.
+/// @param seq_out the even sequence number value belongs to, 0 if nothing was
+/// published yet
+template <typename T>
+bool seqlock_try_load(SeqlockSlot<T> &slot, T &value, std::uint64_t &seq_out) {
+  const std::atomic_ref seq(slot.seq);
+  const auto before = seq.load(std::memory_order_acquire);
+  if (before & 1)
+    return false;
+  std::uint64_t buffer[seqlock_words<T>];
+  for (std::size_t i = 0; i < seqlock_words<T>; ++i) {
+    buffer[i] = std::atomic_ref(slot.words[i]).load(std::memory_order_relaxed);
+  }
+  // Keeps the word loads above from sinking below the second read of seq
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (seq.load(std::memory_order_relaxed) != before)
+    return false;
+  std::memcpy(&value, buffer, sizeof(T));
+  seq_out = before;
+  return true;
+}
+
+/// Reads a consistent copy, retrying while the writer is mid-update.
+/// @return the version of value, 0 if nothing was published yet
+template <typename T>
+std::uint64_t seqlock_load(SeqlockSlot<T> &slot, T &value) {
+  std::uint64_t seq;
+  while (!seqlock_try_load(slot, value, seq)) {
+    cpu_relax();
+  }
+  return seq / 2;
+}
+
+/// The version of the newest value, without reading it.
+template <typename T> std::uint64_t seqlock_version(SeqlockSlot<T> &slot) {
+  return std::atomic_ref(slot.seq).load(std::memory_order_acquire) / 2;
+}
+} // namespace RingBuffer::Detail
+
+#endif // DETAIL_SEQLOCK_H
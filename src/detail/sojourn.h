@@ -0,0 +1,211 @@
+#ifndef DETAIL_SOJOURN_H
+#define DETAIL_SOJOURN_H
+
+#include "platform.h"
+#include "seqlock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/* Sojourn-time sampling shared by QueuePolicy::SojournSampling and
+ * Interprocess::SpscQueue: how long a message sat in the queue, from just
+ * before the producer published it to just after the consumer took it.
+ *
+ * Both ends count their messages. The producer stamps every Nth message with
+ * tsc_now() in a ring of seqlock slots before it publishes it; a queue is
+ * FIFO, so when the consumer's count reaches a multiple of N it knows which
+ * stamp belongs to the message it just took and records the difference in a
+ * LatencyHistogram.
+ *
+ * The consumer reads the stamps before it releases the messages, so the
+ * producer is never more than a queue's worth of messages ahead of a stamp
+ * still to be read. The ring therefore holds ceil(max_messages / N) + 1
+ * stamps, see size_for(), and no sample is lost however deep the queue
+ * gets. A stamp that is missing anyway, e.g., because the consumer attached
+ * after the producer had started, is counted as dropped.
+ *
+ * Everything is plain integers accessed through std::atomic_ref, so a
+ * SojournLog works on the heap as well as zero-filled in shared memory, and
+ * may be read by any thread or process while the queue runs. The stamps
+ * follow the log directly, a SojournLog is only ever placed in a buffer of
+ * size_for() bytes.
+ */
+namespace RingBuffer::Detail {
+
+/* A log-linear histogram of TSC ticks: values below 8 get a bucket each,
+ * every power of two above that is split into 8 buckets, so a reported value
+ * is at most 1/8 above the recorded one. One writer, any number of readers.
+ */
+struct LatencyHistogram {
+  static constexpr int SUB_BITS = 3;
+  static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+  static constexpr int BUCKETS = SUB_BUCKETS * (64 - SUB_BITS + 1);
+
+  std::uint64_t counts[BUCKETS];
+  std::uint64_t total;
+  std::uint64_t max;
+
+  static int bucket_of(const std::uint64_t value) {
+    if (value < SUB_BUCKETS)
+      return static_cast<int>(value);
+    const int shift = static_cast<int>(std::bit_width(value)) - 1 - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS +
+           static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+  }
+
+  // Smallest value that lands in bucket
+  static std::uint64_t lower_bound(const int bucket) {
+    if (bucket < SUB_BUCKETS)
+      return bucket;
+    const int shift = bucket / SUB_BUCKETS - 1;
+    return static_cast<std::uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS)
+           << shift;
+  }
+
+  static std::uint64_t read(const std::uint64_t &field) {
+    return std::atomic_ref(const_cast<std::uint64_t &>(field))
+        .load(std::memory_order_relaxed);
+  }
+
+  static void bump(std::uint64_t &field) {
+    std::atomic_ref(field).store(field + 1, std::memory_order_relaxed);
+  }
+
+  /// Writer only.
+  void record(const std::uint64_t ticks) {
+    bump(counts[bucket_of(ticks)]);
+    bump(total);
+    if (ticks > max)
+      std::atomic_ref(max).store(ticks, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t count() const { return read(total); }
+
+  [[nodiscard]] std::uint64_t max_ticks() const { return read(max); }
+
+  /// @param percentile e.g., 99.9
+  /// @return the highest value of the bucket the percentile falls into,
+  /// capped at the largest recorded value, 0 if nothing was recorded. Taken
+  /// while the writer runs, the result mixes slightly different moments
+  [[nodiscard]] std::uint64_t ticks_at(const double percentile) const {
+    std::uint64_t snapshot[BUCKETS];
+    std::uint64_t sum = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+      snapshot[i] = read(counts[i]);
+      sum += snapshot[i];
+    }
+    const std::uint64_t largest = max_ticks();
+    if (sum == 0)
+      return 0;
+    const auto rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * sum)));
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+      seen += snapshot[i];
+      if (seen >= rank)
+        return i + 1 < BUCKETS ? std::min(lower_bound(i + 1) - 1, largest)
+                               : largest;
+    }
+    return largest;
+  }
+
+  [[nodiscard]] std::uint64_t ns_at(const double percentile) const {
+    return tsc_to_ns(ticks_at(percentile));
+  }
+
+  [[nodiscard]] std::uint64_t max_ns() const { return tsc_to_ns(max_ticks()); }
+};
+
+struct SojournStamp {
+  // 1-based number of the stamped message
+  std::uint64_t message;
+  std::uint64_t tick;
+};
+
+struct SojournLog {
+  using Stamp = SeqlockSlot<SojournStamp>;
+
+  // Sampling period, a power of two, set before either end starts
+  std::uint64_t every;
+  // Length of the stamp ring behind the log, set with every
+  std::uint64_t stamps;
+  // Messages samples were dropped for, see above. Written by the consumer
+  std::uint64_t dropped;
+  // Written by the producer only
+  alignas(64) std::uint64_t produced;
+  // Written by the consumer only
+  alignas(64) std::uint64_t consumed;
+  alignas(64) LatencyHistogram histogram;
+
+  /// Rounds sample_every up to a power of two.
+  static std::uint64_t period(const std::uint64_t sample_every) {
+    return std::bit_ceil(std::max<std::uint64_t>(sample_every, 1));
+  }
+
+  static std::uint64_t stamps_for(const std::uint64_t max_messages,
+                                  const std::uint64_t sample_every) {
+    const std::uint64_t n = period(sample_every);
+    return (max_messages + n - 1) / n + 1;
+  }
+
+  /// Bytes of a log, stamps included, for a queue that holds at most
+  /// max_messages at a time.
+  static std::size_t size_for(const std::uint64_t max_messages,
+                              const std::uint64_t sample_every) {
+    return sizeof(SojournLog) +
+           stamps_for(max_messages, sample_every) * sizeof(Stamp);
+  }
+
+  /// On zero-filled memory of size_for(max_messages, sample_every) bytes.
+  void init(const std::uint64_t max_messages,
+            const std::uint64_t sample_every) {
+    every = period(sample_every);
+    stamps = stamps_for(max_messages, sample_every);
+  }
+
+  Stamp &stamp_of(const std::uint64_t message) {
+    return reinterpret_cast<Stamp *>(this + 1)[message / every % stamps];
+  }
+
+  /// Producer, for each message before it is published.
+  void on_produced() {
+    const std::uint64_t n = produced + 1;
+    std::atomic_ref(produced).store(n, std::memory_order_relaxed);
+    if ((n & (every - 1)) == 0)
+      seqlock_store(stamp_of(n), SojournStamp{n, tsc_now()});
+  }
+
+  /// Consumer, after it took count messages but before it releases them.
+  void on_consumed(const std::uint64_t count) {
+    const std::uint64_t first = consumed + 1;
+    const std::uint64_t last = consumed + count;
+    std::atomic_ref(consumed).store(last, std::memory_order_relaxed);
+    std::uint64_t message = (first + every - 1) & ~(every - 1);
+    if (message > last)
+      return;
+    const std::uint64_t now = tsc_now();
+    for (; message <= last; message += every) {
+      SojournStamp stamp;
+      std::uint64_t seq;
+      if (seqlock_try_load(stamp_of(message), stamp, seq) &&
+          stamp.message == message) {
+        histogram.record(now > stamp.tick ? now - stamp.tick : 0);
+      } else {
+        std::atomic_ref(dropped).store(dropped + 1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  [[nodiscard]] std::uint64_t dropped_samples() const {
+    return LatencyHistogram::read(dropped);
+  }
+};
+// The stamp ring starts right behind the log
+static_assert(sizeof(SojournLog) % alignof(SojournLog::Stamp) == 0);
+} // namespace RingBuffer::Detail
+
+#endif // DETAIL_SOJOURN_H
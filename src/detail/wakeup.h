@@ -0,0 +1,53 @@
+#ifndef DETAIL_WAKEUP_H
+#define DETAIL_WAKEUP_H
+
+#include <atomic>
+#include <cstdint>
+
+/* The sleep/wake handshake shared by Intraprocess::Notifier and
+ * Interprocess::Notifier. One word says whether the consumer is about to
+ * block on the notifier's file descriptor:
+ *
+ *   consumer                          producer
+ *   --------                          --------
+ *   word = SLEEPING                   publish the message (tail)
+ *   seq_cst fence                     seq_cst fence
+ *   poll the queue once more          if word == SLEEPING:
+ *   if still empty: block on the fd       word = AWAKE, signal the fd
+ *
+ * The two fences make sure at least one side sees the other's store: either
+ * the consumer's last poll finds the message, or the producer finds the
+ * consumer sleeping and signals it. While the consumer is awake the producer
+ * pays one fence and one load per message, no syscall.
+ */
+namespace RingBuffer::Detail {
+
+constexpr std::uint32_t WAKEUP_AWAKE = 0;
+constexpr std::uint32_t WAKEUP_SLEEPING = 1;
+
+/// Consumer side: announces that the consumer is about to block. The caller
+/// must poll the queue once more afterwards and only block if it is empty.
+inline void wakeup_arm(std::uint32_t &word) {
+  std::atomic_ref(word).store(WAKEUP_SLEEPING, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+/// Consumer side: the consumer found work after wakeup_arm() and does not
+/// block after all, saves the producer a pointless signal.
+inline void wakeup_disarm(std::uint32_t &word) {
+  std::atomic_ref(word).store(WAKEUP_AWAKE, std::memory_order_relaxed);
+}
+
+/// Producer side, after publishing a message.
+/// @return true if the consumer is (about to be) blocked and the caller must
+/// signal it, at most once per wakeup_arm()
+inline bool wakeup_take(std::uint32_t &word) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const std::atomic_ref w(word);
+  return w.load(std::memory_order_relaxed) == WAKEUP_SLEEPING &&
+         w.exchange(WAKEUP_AWAKE, std::memory_order_relaxed) ==
+             WAKEUP_SLEEPING;
+}
+} // namespace RingBuffer::Detail
+
+#endif // DETAIL_WAKEUP_H
@@ -0,0 +1,314 @@
+#ifndef INTERPROCESS_BLOB_ARENA_IMPL_H
+#define INTERPROCESS_BLOB_ARENA_IMPL_H
+
+#include "byte-sequence.h"
+#include "segment-header.h"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+/* A shared memory arena for payloads too large to go through a ring, e.g.,
+ * images or full book dumps. The producer writes a blob into the arena once
+ * and sends only its 16-byte BlobHandle through, e.g., an
+ * Interprocess::SpscQueue; the consumer reads the blob in place and
+ * release()s it:
+ *
+ *   +---------------+-------+-----------+-----------+-----------------------+
+ *   | SegmentHeader | carve | free[0]   | free[1]   | blocks ...    | (not  |
+ *   |               |       | (256 B)   | (512 B)   | {BlockHeader, | carved|
+ *   |               |       |           |           |  blob bytes}  |  yet) |
+ *   +---------------+-------+-----------+-----------+-----------------------+
+ *                                                                   ↑
+ *                                                                 carve
+ *
+ * Blocks come in power-of-two size classes from 256 bytes up. Each class
+ * keeps a lock-free Treiber stack of free blocks whose head packs the
+ * block's index with a tag bumped on every change, against ABA. A class
+ * with an empty stack carves a new block off the untouched end of the
+ * arena. Freed blocks stay in their class, so the arena must be sized for
+ * the peak mix of blob sizes. Handles are offsets, valid in every process
+ * regardless of where it mapped the segment.
+ *
+ * Any number of processes may allocate and release concurrently. Blocks
+ * held by a process that crashes are not reclaimed.
+ */
+namespace RingBuffer::Interprocess {
+
+/// Names one blob in a BlobArena, trivially copyable so it can be sent as
+/// bytes through any queue.
+struct BlobHandle {
+  // Offset of the block from the start of the arena's blocks
+  std::uint64_t offset;
+  // Bytes of the blob, at most the block's capacity
+  std::uint64_t size;
+};
+static_assert(sizeof(BlobHandle) == 16);
+
+class BlobArena {
+private:
+  static constexpr std::uint64_t DEFAULT_ARENA_SIZE = 64 << 20;
+  static constexpr std::uint64_t MIN_BLOCK = 256;
+  static constexpr int NUM_CLASSES = 32;
+  static constexpr std::uint32_t NIL = UINT32_MAX;
+  static constexpr std::uint32_t BLOCK_FREE = 0;
+  static constexpr std::uint32_t BLOCK_LIVE = 1;
+
+  struct alignas(64) ControlLine {
+    std::uint64_t value;
+  };
+  struct alignas(64) BlockHeader {
+    std::uint32_t size_class;
+    std::uint32_t state;
+    // Free list link, index of the next free block or NIL
+    std::uint32_t next;
+  };
+  static constexpr int m_carve_offset = sizeof(SegmentHeader);
+  static constexpr int m_free_offset = m_carve_offset + sizeof(ControlLine);
+
+  std::uint64_t m_arena_size = 0;
+  std::uint64_t m_header_size = 0;
+  char *m_base_ptr = nullptr;
+  bool m_ownership;
+  std::string m_mapped_file_name;
+  size_t m_total_size = 0;
+  PayloadCopier m_copier;
+  std::unique_ptr<boost::interprocess::shared_memory_object> m_shm_obj;
+  std::unique_ptr<boost::interprocess::mapped_region> m_region;
+
+  [[nodiscard]] std::uint64_t &control(const int offset) const {
+    return reinterpret_cast<ControlLine *>(m_base_ptr + offset)->value;
+  }
+
+  [[nodiscard]] std::uint64_t &free_head(const int size_class) const {
+    return control(m_free_offset + size_class * sizeof(ControlLine));
+  }
+
+  [[nodiscard]] BlockHeader &block(const std::uint64_t offset) const {
+    return *reinterpret_cast<BlockHeader *>(m_base_ptr + m_header_size +
+                                            offset);
+  }
+
+  static std::uint64_t block_size(const int size_class) {
+    return MIN_BLOCK << size_class;
+  }
+
+  /// @return NUM_CLASSES if no class is large enough
+  static int class_of(const std::uint64_t blob_size) {
+    const std::uint64_t needed = blob_size + sizeof(BlockHeader);
+    if (needed > block_size(NUM_CLASSES - 1))
+      return NUM_CLASSES;
+    return std::bit_width((needed - 1) / MIN_BLOCK);
+  }
+
+  static std::uint64_t pack(const std::uint64_t offset,
+                            const std::uint64_t tag) {
+    return tag << 32 | offset / MIN_BLOCK;
+  }
+
+  /// @return NIL if the class has no free block
+  std::uint32_t pop(const int size_class) {
+    const std::atomic_ref head(free_head(size_class));
+    std::uint64_t old = head.load(std::memory_order_acquire);
+    while (static_cast<std::uint32_t>(old) != NIL) {
+      const std::uint64_t idx = static_cast<std::uint32_t>(old);
+      // May read the link of a block someone else just popped; the tag makes
+      // the CAS fail then
+      const std::uint32_t next =
+          std::atomic_ref(block(idx * MIN_BLOCK).next)
+              .load(std::memory_order_relaxed);
+      if (head.compare_exchange_weak(old, ((old >> 32) + 1) << 32 | next,
+                                     std::memory_order_acquire,
+                                     std::memory_order_acquire))
+        return static_cast<std::uint32_t>(idx);
+    }
+    return NIL;
+  }
+
+  void push(const int size_class, const std::uint64_t offset) {
+    const std::atomic_ref head(free_head(size_class));
+    std::uint64_t old = head.load(std::memory_order_relaxed);
+    do {
+      std::atomic_ref(block(offset).next)
+          .store(static_cast<std::uint32_t>(old), std::memory_order_relaxed);
+    } while (!head.compare_exchange_weak(old, pack(offset, (old >> 32) + 1),
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed));
+  }
+
+  /// @return false if the untouched end of the arena is too small
+  bool carve(const std::uint64_t size, std::uint64_t &offset) {
+    const std::atomic_ref carved(control(m_carve_offset));
+    offset = carved.load(std::memory_order_relaxed);
+    do {
+      if (offset + size > m_arena_size)
+        return false;
+    } while (!carved.compare_exchange_weak(offset, offset + size,
+                                           std::memory_order_relaxed));
+    return true;
+  }
+
+  [[nodiscard]] BlockHeader &checked_block(const BlobHandle &handle) const {
+    if (handle.offset % MIN_BLOCK != 0 ||
+        handle.offset + sizeof(BlockHeader) > m_arena_size)
+      throw std::out_of_range("Blob handle outside of the arena");
+    BlockHeader &header = block(handle.offset);
+    if (header.size_class >= NUM_CLASSES ||
+        handle.size > block_size(static_cast<int>(header.size_class)) -
+                          sizeof(BlockHeader))
+      throw std::out_of_range("Blob handle does not match its block");
+    return header;
+  }
+
+  void map_region(const SegmentOptions &options) {
+    namespace bip = boost::interprocess;
+    m_region =
+        std::make_unique<bip::mapped_region>(*m_shm_obj, bip::read_write);
+    m_base_ptr = static_cast<char *>(m_region->get_address());
+    m_total_size = m_region->get_size();
+    if (options.lock_pages)
+      lock_pages(m_base_ptr, m_total_size);
+    if (options.prefault)
+      prefault(m_base_ptr, m_total_size);
+  }
+
+public:
+  /// @param name name of the shared memory object
+  /// @param ownership the owner creates, initializes and eventually removes
+  /// the segment; other endpoints attach to a segment the owner created.
+  /// Both may allocate and release blobs
+  /// @param arena_size_bytes bytes available for blocks, rounded up to a
+  /// multiple of 256 and at most 1 TiB; attachers read it from the header
+  /// @param options prefault/mlock settings and the kernel write() copies
+  /// blobs in with, e.g., CopyKernel::Streaming for blobs the consumer reads
+  /// once
+  explicit BlobArena(const std::string &name, const bool ownership = false,
+                     const std::size_t arena_size_bytes = 0,
+                     const SegmentOptions &options = {})
+      : m_ownership(ownership), m_mapped_file_name(name),
+        m_copier(options.copy) {
+    namespace bip = boost::interprocess;
+    const std::uint64_t page = page_size();
+    m_header_size =
+        (m_free_offset + NUM_CLASSES * sizeof(ControlLine) + page - 1) /
+        page * page;
+    if (m_ownership) {
+      m_arena_size = arena_size_bytes > 0 ? arena_size_bytes
+                                          : DEFAULT_ARENA_SIZE;
+      m_arena_size = (m_arena_size + MIN_BLOCK - 1) / MIN_BLOCK * MIN_BLOCK;
+      if (m_arena_size / MIN_BLOCK >= NIL)
+        throw std::invalid_argument("arena_size_bytes exceeds 1 TiB");
+      m_shm_obj = std::make_unique<bip::shared_memory_object>(
+          bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
+      m_shm_obj->truncate(static_cast<long>(m_header_size + m_arena_size));
+      map_region(options);
+      std::memset(m_base_ptr, 0, m_header_size);
+      for (int size_class = 0; size_class < NUM_CLASSES; ++size_class) {
+        free_head(size_class) = NIL;
+      }
+      publish_header(m_base_ptr, SegmentKind::BlobArena, m_header_size,
+                     m_arena_size, MIN_BLOCK);
+      return;
+    }
+
+    m_shm_obj = std::make_unique<bip::shared_memory_object>(
+        bip::open_only, m_mapped_file_name.c_str(), bip::read_write);
+    map_region(options);
+    const auto &header =
+        read_header(m_base_ptr, m_total_size, SegmentKind::BlobArena, name);
+    if (header.header_size != m_header_size ||
+        header.params[0] != MIN_BLOCK)
+      throw std::runtime_error("Unexpected geometry of [" + name + "]");
+    m_arena_size = header.queue_size;
+    if (arena_size_bytes > 0 && arena_size_bytes != m_arena_size)
+      throw std::runtime_error(
+          "arena_size_bytes does not match the size of [" + name +
+          "]: " + std::to_string(m_arena_size));
+  }
+
+  // Disable copy operations.
+  BlobArena(const BlobArena &) = delete;
+
+  BlobArena &operator=(const BlobArena &) = delete;
+
+  ~BlobArena() { dispose(); }
+
+  /// Reserves a block for a blob of size_bytes bytes, to be filled through
+  /// data() and passed on as handle.
+  /// @return false if neither the size class nor the rest of the arena has
+  /// room for it; nothing was allocated then
+  bool allocate(const std::size_t size_bytes, BlobHandle &handle) {
+    const int size_class = class_of(size_bytes);
+    if (size_class >= NUM_CLASSES)
+      return false;
+    std::uint64_t offset;
+    if (const std::uint32_t idx = pop(size_class); idx != NIL)
+      offset = std::uint64_t{idx} * MIN_BLOCK;
+    else if (!carve(block_size(size_class), offset))
+      return false;
+    BlockHeader &header = block(offset);
+    header.size_class = static_cast<std::uint32_t>(size_class);
+    std::atomic_ref(header.state).store(BLOCK_LIVE, std::memory_order_relaxed);
+    handle = {offset, size_bytes};
+    return true;
+  }
+
+  /// allocate() plus one copy of msg_bytes into the arena.
+  template <ByteSequence U>
+  bool write(const U &msg_bytes, BlobHandle &handle) {
+    const auto bytes = as_byte_span(msg_bytes);
+    if (!allocate(bytes.size(), handle))
+      return false;
+    m_copier.to_shm(data(handle).data(), bytes.data(), bytes.size());
+    return true;
+  }
+
+  /// The blob's bytes, in place. The writes of whoever filled them are
+  /// visible once its handle arrived through a queue.
+  [[nodiscard]] std::span<std::byte> data(const BlobHandle &handle) const {
+    return {reinterpret_cast<std::byte *>(&checked_block(handle) + 1),
+            handle.size};
+  }
+
+  /// Hands the block back to its size class, from any process.
+  /// @throw std::logic_error if the blob was released already
+  void release(const BlobHandle &handle) {
+    BlockHeader &header = checked_block(handle);
+    if (std::atomic_ref(header.state)
+            .exchange(BLOCK_FREE, std::memory_order_relaxed) != BLOCK_LIVE)
+      throw std::logic_error("Blob released twice");
+    push(static_cast<int>(header.size_class), handle.offset);
+  }
+
+  /// Bytes available for blocks.
+  [[nodiscard]] std::size_t capacity() const { return m_arena_size; }
+
+  /// Bytes carved into blocks so far, free or not. Once this approaches
+  /// capacity(), allocations depend on blocks being released.
+  [[nodiscard]] std::size_t carved_bytes() const {
+    return std::atomic_ref(control(m_carve_offset))
+        .load(std::memory_order_relaxed);
+  }
+
+  void dispose() {
+    m_region.reset();
+    m_shm_obj.reset();
+    if (m_ownership) {
+      boost::interprocess::shared_memory_object::remove(
+          m_mapped_file_name.c_str());
+    }
+    m_base_ptr = nullptr;
+  }
+};
+} // namespace RingBuffer::Interprocess
+
+#endif // INTERPROCESS_BLOB_ARENA_IMPL_H
@@ -0,0 +1,473 @@
+#ifndef INTERPROCESS_BROADCAST_QUEUE_IMPL_H
+#define INTERPROCESS_BROADCAST_QUEUE_IMPL_H
+
+#include "../ringbuffer-interface.h"
+#include "byte-sequence.h"
+#include "segment-header.h"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+
+/* A single-producer-multi-consumer broadcast ring in shared memory: the
+ * producer process writes each message once and every subscriber process
+ * reads it through its own cursor.
+ *
+ *   +---------------+---------------+--------------------------+----------+
+ *   | SegmentHeader | tail, oldest  | subscriber slots         | payload  |
+ *   |               | (producer)    | {pid, cursor} x 64       | area     |
+ *   +---------------+---------------+--------------------------+----------+
+ *
+ * Positions are monotonically increasing 64-bit byte offsets, the payload
+ * area is indexed with position % queue_size. Records use the same framing as
+ * SpscQueue ([int length][payload], FLAG_WRAPPED when a record would not fit
+ * before the end of the ring), so a new lap always starts on a record
+ * boundary.
+ *
+ * Subscribers register by claiming a slot (CAS on its pid) and join at the
+ * current tail. With BroadcastPolicy::BlockOnSlowest the producer refuses to
+ * overwrite bytes the slowest live subscriber has not read yet. With
+ * BroadcastPolicy::OverwriteSlowest the producer never waits; it advances
+ * `oldest` before touching any byte, and a subscriber that finds its
+ * position below `oldest` after copying a record knows it was lapped. The
+ * subscriber then counts an overrun and resynchronizes on the next lap start.
+ */
+namespace RingBuffer::Interprocess {
+
+enum class BroadcastPolicy : std::uint64_t {
+  BlockOnSlowest = 0,
+  OverwriteSlowest = 1,
+};
+
+class BroadcastQueue : public IRingBuffer<BroadcastQueue, std::string> {
+public:
+  static constexpr int MAX_SUBSCRIBERS = 64;
+
+private:
+  static constexpr int FLAG_WRAPPED = -1;
+  static constexpr int DEFAULT_QUEUE_SIZE = 1 << 20;
+  static constexpr std::uint64_t NO_CURSOR =
+      std::numeric_limits<std::uint64_t>::max();
+
+  struct alignas(64) ProducerLine {
+    std::uint64_t tail;
+    std::uint64_t oldest;
+  };
+  struct alignas(64) SubscriberSlot {
+    std::uint64_t pid; // 0 if the slot is free
+    std::uint64_t cursor;
+  };
+  static constexpr int m_producer_offset = sizeof(SegmentHeader);
+  static constexpr int m_slots_offset =
+      m_producer_offset + sizeof(ProducerLine);
+  static constexpr int m_header_size =
+      m_slots_offset + sizeof(SubscriberSlot) * MAX_SUBSCRIBERS;
+
+  std::uint64_t m_queue_size = 0;
+  char *m_base_ptr = nullptr;
+  bool m_ownership;
+  std::string m_mapped_file_name;
+  size_t m_total_size = 0;
+  BroadcastPolicy m_policy = BroadcastPolicy::BlockOnSlowest;
+  std::unique_ptr<boost::interprocess::shared_memory_object> m_shm_obj;
+  std::unique_ptr<boost::interprocess::mapped_region> m_region;
+
+  // Producer side: local copy of the tail and a cached lower bound of all
+  // subscriber cursors, so that the slots are only scanned when the ring
+  // looks full
+  std::uint64_t m_tail = 0;
+  std::uint64_t m_cached_min_cursor = 0;
+  // Subscriber side
+  int m_slot = -1;
+  std::uint64_t m_cursor = 0;
+  std::uint64_t m_overruns = 0;
+  // OverwriteSlowest consume_up_to() copies records here before handing them
+  // out
+  std::string m_scratch;
+
+  [[nodiscard]] ProducerLine &producer_line() const {
+    return *reinterpret_cast<ProducerLine *>(m_base_ptr + m_producer_offset);
+  }
+
+  [[nodiscard]] SubscriberSlot &slot(const int idx) const {
+    const auto slots =
+        reinterpret_cast<SubscriberSlot *>(m_base_ptr + m_slots_offset);
+    return slots[idx];
+  }
+
+  [[nodiscard]] char *data_base() const { return m_base_ptr + m_header_size; }
+
+  void map_region(const SegmentOptions &options) {
+    namespace bip = boost::interprocess;
+    m_region =
+        std::make_unique<bip::mapped_region>(*m_shm_obj, bip::read_write);
+    m_base_ptr = static_cast<char *>(m_region->get_address());
+    m_total_size = m_region->get_size();
+    if (options.lock_pages)
+      lock_pages(m_base_ptr, m_total_size);
+    if (options.prefault)
+      prefault(m_base_ptr, m_total_size);
+  }
+
+  // Lowest cursor of all registered subscribers, NO_CURSOR if there is none
+  [[nodiscard]] std::uint64_t min_cursor() const {
+    std::uint64_t min = NO_CURSOR;
+    for (int i = 0; i < MAX_SUBSCRIBERS; ++i) {
+      if (std::atomic_ref(slot(i).pid).load(std::memory_order_acquire) == 0)
+        continue;
+      const std::uint64_t cursor =
+          std::atomic_ref(slot(i).cursor).load(std::memory_order_acquire);
+      if (cursor < min)
+        min = cursor;
+    }
+    return min;
+  }
+
+  // Subscribers that register later join at (or after) the current tail, so
+  // without any subscriber the tail itself is a valid lower bound
+  void refresh_min_cursor() {
+    // Pairs with join(): either this scan sees the joining subscriber's
+    // cursor, or the subscriber sees our latest tail and joins there
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::uint64_t min = min_cursor();
+    m_cached_min_cursor = min == NO_CURSOR ? m_tail : min;
+  }
+
+  void join() {
+    const std::uint64_t pid = current_pid();
+    for (int i = 0; i < MAX_SUBSCRIBERS; ++i) {
+      std::uint64_t expected = 0;
+      if (std::atomic_ref(slot(i).pid)
+              .compare_exchange_strong(expected, pid,
+                                       std::memory_order_acq_rel)) {
+        m_slot = i;
+        break;
+      }
+    }
+    if (m_slot < 0)
+      throw std::runtime_error("No free subscriber slot in [" +
+                               m_mapped_file_name + "]");
+    // Join at the tail, and retry until the tail did not move while the
+    // cursor was published. Then no BlockOnSlowest producer can lap us: a
+    // scan that missed our cursor only saw tails up to the one we joined at
+    const std::atomic_ref tail(producer_line().tail);
+    const std::atomic_ref cursor(slot(m_slot).cursor);
+    do {
+      m_cursor = tail.load(std::memory_order_acquire);
+      cursor.store(m_cursor, std::memory_order_seq_cst);
+    } while (tail.load(std::memory_order_seq_cst) != m_cursor);
+  }
+
+  // Moves a lapped subscriber to the oldest lap start that is still intact
+  void resync(const std::uint64_t oldest, const std::uint64_t tail) {
+    ++m_overruns;
+    const std::uint64_t from = oldest > m_cursor ? oldest : m_cursor + 1;
+    const std::uint64_t lap_start =
+        (from + m_queue_size - 1) / m_queue_size * m_queue_size;
+    m_cursor = lap_start < tail ? lap_start : tail;
+  }
+
+  // Whether a record of msg_length fits at offset, a length read from a
+  // ring that is being lapped may be garbage
+  [[nodiscard]] bool valid_length(const std::uint64_t offset,
+                                  const int msg_length) const {
+    return msg_length >= 0 &&
+           offset + sizeof(int) + msg_length <= m_queue_size;
+  }
+
+  // Copies the next record before tail into buffer and advances m_cursor
+  // past it, resynchronizing if we were lapped. Does not publish the cursor.
+  bool read_next(std::string &buffer, const std::uint64_t tail) {
+    const auto &line = producer_line();
+    while (m_cursor != tail) {
+      const std::uint64_t offset = m_cursor % m_queue_size;
+      if (m_queue_size - offset < sizeof(int)) {
+        m_cursor += m_queue_size - offset;
+        continue;
+      }
+      const char *record = data_base() + offset;
+      int msg_length;
+      std::memcpy(&msg_length, record, sizeof(int));
+      // Bound the length before copying and only trust it after the oldest
+      // check below
+      const bool valid = valid_length(offset, msg_length);
+      if (valid) {
+        if (buffer.size() != static_cast<size_t>(msg_length)) {
+          buffer.resize(msg_length);
+        }
+        std::memcpy(buffer.data(), record + sizeof(int), msg_length);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (const std::uint64_t oldest =
+              std::atomic_ref(line.oldest).load(std::memory_order_relaxed);
+          m_cursor < oldest || (!valid && msg_length != FLAG_WRAPPED)) {
+        resync(oldest, tail);
+        continue;
+      }
+      if (msg_length == FLAG_WRAPPED) {
+        m_cursor += m_queue_size - offset;
+        continue;
+      }
+      m_cursor += sizeof(int) + msg_length;
+      return true;
+    }
+    return false;
+  }
+
+  // Publishes consumed records, skipped wrap markers and resyncs, if any
+  void publish_cursor() const {
+    if (std::atomic_ref(slot(m_slot).cursor)
+            .load(std::memory_order_relaxed) != m_cursor)
+      std::atomic_ref(slot(m_slot).cursor)
+          .store(m_cursor, std::memory_order_release);
+  }
+
+public:
+  /// @param queue_name name of the shared memory object
+  /// @param ownership true for the (single) producer, which creates and
+  /// eventually removes the segment; false for a subscriber
+  /// @param queue_size_bytes size of the payload area, read from the segment
+  /// header by subscribers
+  /// @param policy what the producer does when the slowest subscriber is a
+  /// full ring behind, fixed by the owner
+  explicit BroadcastQueue(
+      const std::string &queue_name, const bool ownership = false,
+      const int queue_size_bytes = 0,
+      const BroadcastPolicy policy = BroadcastPolicy::BlockOnSlowest,
+      const SegmentOptions &options = {})
+      : m_ownership(ownership), m_mapped_file_name(queue_name) {
+    namespace bip = boost::interprocess;
+    if (m_ownership) {
+      m_queue_size =
+          queue_size_bytes > 0 ? queue_size_bytes : DEFAULT_QUEUE_SIZE;
+      m_policy = policy;
+      m_shm_obj = std::make_unique<bip::shared_memory_object>(
+          bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
+      m_shm_obj->truncate(static_cast<long>(m_header_size + m_queue_size));
+      map_region(options);
+      std::memset(m_base_ptr, 0, m_total_size);
+      for (int i = 0; i < MAX_SUBSCRIBERS; ++i) {
+        slot(i).cursor = NO_CURSOR;
+      }
+      publish_header(m_base_ptr, SegmentKind::BroadcastQueue, m_header_size,
+                     m_queue_size, static_cast<std::uint64_t>(m_policy));
+      return;
+    }
+
+    m_shm_obj = std::make_unique<bip::shared_memory_object>(
+        bip::open_only, m_mapped_file_name.c_str(), bip::read_write);
+    map_region(options);
+    const auto &header = read_header(m_base_ptr, m_total_size,
+                                     SegmentKind::BroadcastQueue, queue_name);
+    if (header.header_size != m_header_size)
+      throw std::runtime_error("Unexpected header size of [" + queue_name +
+                               "]");
+    m_queue_size = header.queue_size;
+    m_policy = static_cast<BroadcastPolicy>(header.params[0]);
+    join();
+  }
+
+  // Disable copy operations.
+  BroadcastQueue(const BroadcastQueue &) = delete;
+
+  BroadcastQueue &operator=(const BroadcastQueue &) = delete;
+
+  ~BroadcastQueue() { dispose(); }
+
+  // Publishes a message to every subscriber. Returns false if the message can
+  // never fit, or if the policy is BlockOnSlowest and the slowest subscriber
+  // has not made room yet.
+  template <ByteSequence U> bool enqueue_impl(U &&msg_bytes) {
+    const auto bytes = as_byte_span(msg_bytes);
+    const int msg_length = static_cast<int>(bytes.size());
+    const std::uint64_t element_length = sizeof(int) + msg_length;
+    if (element_length > m_queue_size)
+      return false;
+
+    const std::uint64_t offset = m_tail % m_queue_size;
+    const std::uint64_t skip =
+        m_queue_size - offset < element_length ? m_queue_size - offset : 0;
+    const std::uint64_t start = m_tail + skip;
+    const std::uint64_t new_tail = start + element_length;
+
+    if (m_policy == BroadcastPolicy::BlockOnSlowest &&
+        new_tail - m_cached_min_cursor > m_queue_size) {
+      refresh_min_cursor();
+      if (new_tail - m_cached_min_cursor > m_queue_size) {
+        reap_subscribers();
+        refresh_min_cursor();
+        if (new_tail - m_cached_min_cursor > m_queue_size)
+          return false;
+      }
+    }
+
+    // Invalidate whatever we are about to overwrite before overwriting it,
+    // subscribers re-check oldest after copying a record
+    if (new_tail > m_queue_size) {
+      std::atomic_ref(producer_line().oldest)
+          .store(new_tail - m_queue_size, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    char *data = data_base();
+    if (skip >= sizeof(int)) {
+      constexpr int flag = FLAG_WRAPPED;
+      std::memcpy(data + offset, &flag, sizeof(int));
+    }
+    const std::uint64_t start_offset = start % m_queue_size;
+    std::memcpy(data + start_offset, &msg_length, sizeof(int));
+    std::memcpy(data + start_offset + sizeof(int), bytes.data(),
+                msg_length);
+    m_tail = new_tail;
+    std::atomic_ref(producer_line().tail)
+        .store(new_tail, std::memory_order_release);
+    return true;
+  }
+
+  bool dequeue_impl(std::string &buffer) {
+    const bool dequeued = read_next(buffer, std::atomic_ref(producer_line().tail)
+                                                .load(std::memory_order_acquire));
+    publish_cursor();
+    return dequeued;
+  }
+
+  /// Subscriber only: hands up to max_items messages to fn as
+  /// std::span<const std::byte>, then publishes the cursor once. With
+  /// BlockOnSlowest the producer cannot overwrite anything past our
+  /// published cursor, so fn looks at the ring in place. With
+  /// OverwriteSlowest each message is copied and validated first, fn never
+  /// sees a torn record.
+  template <typename F>
+  std::size_t consume_up_to_impl(const std::size_t max_items, F &&fn) {
+    const std::uint64_t tail =
+        std::atomic_ref(producer_line().tail).load(std::memory_order_acquire);
+    std::size_t count = 0;
+    if (m_policy == BroadcastPolicy::BlockOnSlowest) {
+      while (count < max_items && m_cursor != tail) {
+        const std::uint64_t offset = m_cursor % m_queue_size;
+        if (m_queue_size - offset < sizeof(int)) {
+          m_cursor += m_queue_size - offset;
+          continue;
+        }
+        const char *record = data_base() + offset;
+        int msg_length;
+        std::memcpy(&msg_length, record, sizeof(int));
+        // Records past our published cursor stay put, but check that we were
+        // not lapped before it was published, as read_next() does
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (const std::uint64_t oldest =
+                std::atomic_ref(producer_line().oldest)
+                    .load(std::memory_order_relaxed);
+            m_cursor < oldest || (msg_length != FLAG_WRAPPED &&
+                                  !valid_length(offset, msg_length))) {
+          resync(oldest, tail);
+          continue;
+        }
+        if (msg_length == FLAG_WRAPPED) {
+          m_cursor += m_queue_size - offset;
+          continue;
+        }
+        try {
+          fn(std::span<const std::byte>(
+              reinterpret_cast<const std::byte *>(record + sizeof(int)),
+              msg_length));
+        } catch (...) {
+          publish_cursor();
+          throw;
+        }
+        m_cursor += sizeof(int) + msg_length;
+        ++count;
+      }
+    } else {
+      std::uint64_t cursor = m_cursor;
+      while (count < max_items && read_next(m_scratch, tail)) {
+        try {
+          fn(std::span<const std::byte>(
+              reinterpret_cast<const std::byte *>(m_scratch.data()),
+              m_scratch.size()));
+        } catch (...) {
+          // read_next() already moved past the copy, read it again next time
+          m_cursor = cursor;
+          publish_cursor();
+          throw;
+        }
+        cursor = m_cursor;
+        ++count;
+      }
+    }
+    publish_cursor();
+    return count;
+  }
+
+  /// Producer only: frees the slots of subscriber processes that died without
+  /// unregistering, so that they no longer hold back BlockOnSlowest.
+  /// @return number of slots freed
+  int reap_subscribers() const {
+    int reaped = 0;
+    for (int i = 0; i < MAX_SUBSCRIBERS; ++i) {
+      std::uint64_t pid =
+          std::atomic_ref(slot(i).pid).load(std::memory_order_acquire);
+      if (pid == 0 || process_alive(pid))
+        continue;
+      std::atomic_ref(slot(i).cursor)
+          .store(NO_CURSOR, std::memory_order_relaxed);
+      if (std::atomic_ref(slot(i).pid)
+              .compare_exchange_strong(pid, 0, std::memory_order_acq_rel))
+        ++reaped;
+    }
+    return reaped;
+  }
+
+  /// Number of registered subscribers, including ones that died but were not
+  /// reaped yet.
+  [[nodiscard]] int subscriber_count() const {
+    int count = 0;
+    for (int i = 0; i < MAX_SUBSCRIBERS; ++i) {
+      if (std::atomic_ref(slot(i).pid).load(std::memory_order_relaxed) != 0)
+        ++count;
+    }
+    return count;
+  }
+
+  /// Subscriber only: how many times this subscriber was lapped by the
+  /// producer and skipped ahead.
+  [[nodiscard]] std::uint64_t overruns() const { return m_overruns; }
+
+  [[nodiscard]] BroadcastPolicy policy() const { return m_policy; }
+
+  [[nodiscard]] int head_impl() const {
+    return static_cast<int>(m_cursor % m_queue_size);
+  }
+
+  [[nodiscard]] int tail_impl() const {
+    return static_cast<int>(std::atomic_ref(producer_line().tail)
+                                .load(std::memory_order_relaxed) %
+                            m_queue_size);
+  }
+
+  void dispose() {
+    if (m_base_ptr != nullptr && m_slot >= 0) {
+      // Leave: the producer stops waiting for us
+      std::atomic_ref(slot(m_slot).cursor)
+          .store(NO_CURSOR, std::memory_order_relaxed);
+      std::atomic_ref(slot(m_slot).pid).store(0, std::memory_order_release);
+      m_slot = -1;
+    }
+    m_region.reset();
+    m_shm_obj.reset();
+    if (m_ownership) {
+      boost::interprocess::shared_memory_object::remove(
+          m_mapped_file_name.c_str());
+    }
+    m_base_ptr = nullptr;
+  }
+};
+} // namespace RingBuffer::Interprocess
+#endif // INTERPROCESS_BROADCAST_QUEUE_IMPL_H
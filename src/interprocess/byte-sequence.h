@@ -0,0 +1,53 @@
+#ifndef INTERPROCESS_BYTE_SEQUENCE_H
+#define INTERPROCESS_BYTE_SEQUENCE_H
+
+#include <cstddef>
+#include <cstring>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+namespace RingBuffer::Interprocess {
+
+/// A NUL-terminated string, sent without its terminator just as when it was
+/// converted to std::string.
+template <typename U>
+concept CString = std::is_convertible_v<U, const char *> &&
+                  !std::is_null_pointer_v<std::remove_cvref_t<U>>;
+
+/// Anything the interprocess queues can copy a message from without first
+/// building a std::string: std::string, std::string_view, std::vector<char>,
+/// std::span<const std::byte>, C strings and alike. Other raw arrays are
+/// rejected, as_byte_span() could not tell where their message ends.
+template <typename U>
+concept ByteSequence =
+    CString<U> ||
+    (std::ranges::contiguous_range<U> && std::ranges::sized_range<U> &&
+     sizeof(std::ranges::range_value_t<U>) == 1 &&
+     std::is_trivially_copyable_v<std::ranges::range_value_t<U>> &&
+     !std::is_array_v<std::remove_cvref_t<U>>);
+
+/// The fragments of one message, written back to back into a single record.
+using Fragments = std::span<const std::span<const std::byte>>;
+
+/// The bytes of a message. A const char array is taken to be a string
+/// literal and loses its last byte, the terminating NUL, other C strings end
+/// at their first NUL.
+template <typename U>
+  requires ByteSequence<U>
+std::span<const std::byte> as_byte_span(U &&msg_bytes) {
+  using Bare = std::remove_reference_t<U>;
+  if constexpr (std::is_array_v<Bare> &&
+                std::is_same_v<std::remove_extent_t<Bare>, const char>) {
+    return std::as_bytes(std::span(msg_bytes, std::extent_v<Bare> - 1));
+  } else if constexpr (CString<U>) {
+    const char *str = msg_bytes;
+    return std::as_bytes(std::span(str, std::strlen(str)));
+  } else {
+    return std::as_bytes(std::span(std::ranges::data(msg_bytes),
+                                   std::ranges::size(msg_bytes)));
+  }
+}
+} // namespace RingBuffer::Interprocess
+
+#endif // INTERPROCESS_BYTE_SEQUENCE_H
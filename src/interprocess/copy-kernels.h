@@ -0,0 +1,241 @@
+#ifndef INTERPROCESS_COPY_KERNELS_H
+#define INTERPROCESS_COPY_KERNELS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                             \
+    (defined(__GNUC__) || defined(__clang__))
+#define RINGBUFFER_X86_COPY_KERNELS 1
+#include <immintrin.h>
+#endif
+
+/* Payload copy kernels for the interprocess queues. The producer's copy into
+ * shared memory is read exactly once, by another core, so for large payloads
+ * pulling those lines into the producer's own cache only evicts its working
+ * set. The kernels are:
+ *
+ *   Memcpy     std::memcpy, the default
+ *   Avx2       32-byte vector loads/stores
+ *   Avx512     64-byte vector loads/stores
+ *   Streaming  non-temporal 32-byte stores that bypass the producer's cache,
+ *              followed by an sfence so that a later release store still
+ *              publishes them
+ *   Auto       the widest vector kernel the CPU supports
+ *
+ * Vector kernels are compiled with per-function target attributes and picked
+ * at runtime after probing the CPU, so the binary still runs on CPUs without
+ * AVX. Unsupported kernels (and every kernel on non-x86 or MSVC builds) fall
+ * back to std::memcpy.
+ */
+namespace RingBuffer::Interprocess {
+
+enum class CopyKernel : std::uint8_t {
+  Memcpy,
+  Avx2,
+  Avx512,
+  Streaming,
+  Auto,
+};
+
+using CopyFunction = void (*)(void *dst, const void *src, std::size_t n);
+
+inline void copy_memcpy(void *dst, const void *src, const std::size_t n) {
+  std::memcpy(dst, src, n);
+}
+
+#if defined(RINGBUFFER_X86_COPY_KERNELS)
+__attribute__((target("avx2"))) inline void
+copy_avx2(void *dst, const void *src, const std::size_t n) {
+  auto d = static_cast<char *>(dst);
+  auto s = static_cast<const char *>(src);
+  if (n < 32) {
+    std::memcpy(d, s, n);
+    return;
+  }
+  const char *const end = s + n;
+  for (; s + 128 <= end; s += 128, d += 128) {
+    const auto v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+    const auto v1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 32));
+    const auto v2 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 64));
+    const auto v3 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 96));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d), v0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 32), v1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 64), v2);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 96), v3);
+  }
+  for (; s + 32 <= end; s += 32, d += 32) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(d),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s)));
+  }
+  // The last, possibly overlapping, vector covers the remainder
+  if (s != end) {
+    const auto back = end - s;
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(d + back - 32),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(end - 32)));
+  }
+}
+
+__attribute__((target("avx512f"))) inline void
+copy_avx512(void *dst, const void *src, const std::size_t n) {
+  auto d = static_cast<char *>(dst);
+  auto s = static_cast<const char *>(src);
+  if (n < 64) {
+    std::memcpy(d, s, n);
+    return;
+  }
+  const char *const end = s + n;
+  for (; s + 256 <= end; s += 256, d += 256) {
+    const auto v0 = _mm512_loadu_si512(s);
+    const auto v1 = _mm512_loadu_si512(s + 64);
+    const auto v2 = _mm512_loadu_si512(s + 128);
+    const auto v3 = _mm512_loadu_si512(s + 192);
+    _mm512_storeu_si512(d, v0);
+    _mm512_storeu_si512(d + 64, v1);
+    _mm512_storeu_si512(d + 128, v2);
+    _mm512_storeu_si512(d + 192, v3);
+  }
+  for (; s + 64 <= end; s += 64, d += 64) {
+    _mm512_storeu_si512(d, _mm512_loadu_si512(s));
+  }
+  if (s != end) {
+    const auto back = end - s;
+    _mm512_storeu_si512(d + back - 64, _mm512_loadu_si512(end - 64));
+  }
+}
+
+__attribute__((target("avx2"))) inline void
+copy_streaming(void *dst, const void *src, const std::size_t n) {
+  auto d = static_cast<char *>(dst);
+  auto s = static_cast<const char *>(src);
+  // Non-temporal stores need a 32-byte aligned destination
+  const std::size_t head =
+      std::min<std::size_t>(n, -reinterpret_cast<std::uintptr_t>(d) & 31);
+  std::memcpy(d, s, head);
+  d += head;
+  s += head;
+  std::size_t left = n - head;
+  for (; left >= 128; left -= 128, s += 128, d += 128) {
+    const auto v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+    const auto v1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 32));
+    const auto v2 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 64));
+    const auto v3 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 96));
+    _mm256_stream_si256(reinterpret_cast<__m256i *>(d), v0);
+    _mm256_stream_si256(reinterpret_cast<__m256i *>(d + 32), v1);
+    _mm256_stream_si256(reinterpret_cast<__m256i *>(d + 64), v2);
+    _mm256_stream_si256(reinterpret_cast<__m256i *>(d + 96), v3);
+  }
+  for (; left >= 32; left -= 32, s += 32, d += 32) {
+    _mm256_stream_si256(
+        reinterpret_cast<__m256i *>(d),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s)));
+  }
+  std::memcpy(d, s, left);
+  // Streaming stores are weakly ordered even on x86, a release store that
+  // publishes them must not overtake them
+  _mm_sfence();
+}
+#endif
+
+/// Whether the running CPU (and this build) can execute kernel.
+inline bool copy_kernel_supported(const CopyKernel kernel) {
+  switch (kernel) {
+  case CopyKernel::Memcpy:
+  case CopyKernel::Auto:
+    return true;
+#if defined(RINGBUFFER_X86_COPY_KERNELS)
+  case CopyKernel::Avx2:
+  case CopyKernel::Streaming:
+    return __builtin_cpu_supports("avx2");
+  case CopyKernel::Avx512:
+    return __builtin_cpu_supports("avx512f");
+#endif
+  default:
+    return false;
+  }
+}
+
+/// Resolves kernel to a function, falling back to std::memcpy if the CPU
+/// cannot run it.
+inline CopyFunction copy_function(const CopyKernel kernel) {
+#if defined(RINGBUFFER_X86_COPY_KERNELS)
+  if (kernel == CopyKernel::Auto)
+    return copy_function(copy_kernel_supported(CopyKernel::Avx512)
+                             ? CopyKernel::Avx512
+                             : CopyKernel::Avx2);
+  if (!copy_kernel_supported(kernel))
+    return copy_memcpy;
+  switch (kernel) {
+  case CopyKernel::Avx2:
+    return copy_avx2;
+  case CopyKernel::Avx512:
+    return copy_avx512;
+  case CopyKernel::Streaming:
+    return copy_streaming;
+  default:
+    break;
+  }
+#endif
+  return copy_memcpy;
+}
+
+/// Prefetches the cache line holding addr for reading.
+inline void prefetch_read(const void *addr) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(addr, 0, 3);
+#endif
+}
+
+struct CopyOptions {
+  // Kernel used for payloads below streaming_threshold, and by the consumer
+  CopyKernel kernel = CopyKernel::Memcpy;
+  // The producer switches to CopyKernel::Streaming from this many payload
+  // bytes on, i.e. for messages the consumer reads once and this core never
+  // touches again. Disabled by default
+  std::size_t streaming_threshold = std::numeric_limits<std::size_t>::max();
+  // The consumer prefetches the next record while handing out the current one
+  bool prefetch_next = false;
+};
+
+/// A CopyOptions resolved against the running CPU once, at construction.
+class PayloadCopier {
+  CopyFunction m_bulk = copy_memcpy;
+  CopyFunction m_streaming = copy_memcpy;
+  std::size_t m_streaming_threshold = std::numeric_limits<std::size_t>::max();
+
+public:
+  PayloadCopier() = default;
+
+  explicit PayloadCopier(const CopyOptions &options)
+      : m_bulk(copy_function(options.kernel)),
+        m_streaming(copy_function(CopyKernel::Streaming)),
+        m_streaming_threshold(options.streaming_threshold) {}
+
+  /// Copies a payload into shared memory.
+  void to_shm(void *dst, const void *src, const std::size_t n) const {
+    if (n >= m_streaming_threshold)
+      m_streaming(dst, src, n);
+    else
+      m_bulk(dst, src, n);
+  }
+
+  /// Copies a payload out of shared memory. Never streams, the caller is
+  /// about to read what it dequeued.
+  void from_shm(void *dst, const void *src, const std::size_t n) const {
+    m_bulk(dst, src, n);
+  }
+};
+} // namespace RingBuffer::Interprocess
+
+#endif // INTERPROCESS_COPY_KERNELS_H
@@ -0,0 +1,431 @@
+#ifndef INTERPROCESS_JOURNAL_QUEUE_IMPL_H
+#define INTERPROCESS_JOURNAL_QUEUE_IMPL_H
+
+#include "../ringbuffer-interface.h"
+#include "byte-sequence.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* A file-backed, append-only variant of Interprocess::SpscQueue.
+ *
+ * The journal is a directory of fixed-size segment files, each one mapped with
+ * mmap(). The writer appends records ([int length][payload], the same framing
+ * as SpscQueue) with plain stores into the mapping, so the hot path never
+ * issues a write() syscall. When a record does not fit into the current
+ * segment the writer creates the next segment, then seals the current one.
+ *
+ *   <journal_dir>/00000000000000000000.journal
+ *   <journal_dir>/00000000000000000001.journal
+ *   <journal_dir>/<cursor_name>.cursor
+ *
+ * Each reader keeps a durable cursor (segment sequence + offset, packed into
+ * one word) in its own small mapped file. Because everything lives in the
+ * page cache, a crashed writer or reader loses nothing: a restarted writer
+ * seals every older segment, resumes after the last committed record and
+ * a restarted reader replays from its cursor. msync() is only issued by
+ * checkpoint(), which protects against power loss / OS crash, for the
+ * current segment and every segment sealed since the last checkpoint.
+ */
+namespace RingBuffer::Interprocess {
+class JournalQueue : public IRingBuffer<JournalQueue, std::string> {
+private:
+  static constexpr std::uint64_t SEGMENT_MAGIC = 0x4c464a524e4c5347; // LFJRNLSG
+  static constexpr std::uint64_t CURSOR_MAGIC = 0x4c464a524e4c4356;  // LFJRNLCV
+  static constexpr std::uint32_t VERSION = 1;
+  // A cursor position is (segment << OFFSET_BITS) | offset
+  static constexpr int OFFSET_BITS = 32;
+  static constexpr std::uint64_t OFFSET_MASK =
+      (std::uint64_t{1} << OFFSET_BITS) - 1;
+
+  // Each field the writer and readers race on sits on its own cache line, the
+  // payload area starts after the header.
+  struct SegmentHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t data_size;
+    std::uint64_t sequence;
+    alignas(64) std::uint64_t tail;   // committed bytes, written by the writer
+    alignas(64) std::uint32_t sealed; // 1 once the next segment exists
+  };
+  static constexpr std::size_t m_header_size = 192;
+  static_assert(sizeof(SegmentHeader) <= m_header_size);
+
+  // One word, so that a crash never persists a segment without its offset
+  struct Cursor {
+    std::uint64_t magic;
+    std::uint64_t position;
+  };
+
+  struct Segment {
+    std::uint64_t sequence = 0;
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+    SegmentHeader *header = nullptr;
+    char *data = nullptr;
+  };
+
+  std::filesystem::path m_journal_dir;
+  bool m_ownership;
+  std::uint64_t m_segment_size;
+  Segment m_segment;
+  // Only used by the writer, mirrors m_segment.header->tail
+  std::uint64_t m_tail = 0;
+  // Only used by the writer, segments sealed since the last checkpoint()
+  std::vector<std::uint64_t> m_unflushed;
+  // Only used by readers
+  std::unique_ptr<boost::interprocess::mapped_region> m_cursor_region;
+  Cursor *m_cursor = nullptr;
+
+  [[nodiscard]] std::filesystem::path
+  segment_path(const std::uint64_t sequence) const {
+    std::ostringstream oss;
+    oss << std::setw(20) << std::setfill('0') << sequence << ".journal";
+    return m_journal_dir / oss.str();
+  }
+
+  /// Sequence number of a segment file, false for anything else that happens
+  /// to end in .journal.
+  static bool parse_sequence(const std::filesystem::path &path,
+                             std::uint64_t &sequence) {
+    if (path.extension() != ".journal")
+      return false;
+    const std::string stem = path.stem().string();
+    const auto [end, ec] =
+        std::from_chars(stem.data(), stem.data() + stem.size(), sequence);
+    return ec == std::errc() && end == stem.data() + stem.size() &&
+           !stem.empty();
+  }
+
+  static std::unique_ptr<boost::interprocess::mapped_region>
+  map_file(const std::filesystem::path &path) {
+    namespace bip = boost::interprocess;
+    const bip::file_mapping file(path.string().c_str(), bip::read_write);
+    return std::make_unique<bip::mapped_region>(file, bip::read_write);
+  }
+
+  static void create_file(const std::filesystem::path &path,
+                          const std::uintmax_t size) {
+    std::ofstream(path, std::ios::binary | std::ios::app).close();
+    // Sparse on most filesystems, blocks are allocated as the writer touches
+    // them
+    std::filesystem::resize_file(path, size);
+  }
+
+  bool map_segment(const std::uint64_t sequence) {
+    const auto path = segment_path(sequence);
+    if (!std::filesystem::exists(path))
+      return false;
+    auto region = map_file(path);
+    auto header = static_cast<SegmentHeader *>(region->get_address());
+    if (std::atomic_ref(header->magic).load(std::memory_order_acquire) !=
+        SEGMENT_MAGIC)
+      return false;
+    if (header->version != VERSION)
+      throw std::runtime_error("Unsupported journal segment version: " +
+                               path.string());
+    m_segment.sequence = sequence;
+    m_segment.header = header;
+    m_segment.data = static_cast<char *>(region->get_address()) + m_header_size;
+    m_segment.region = std::move(region);
+    if (!m_ownership) {
+      // Replay is a front-to-back scan, let the kernel read ahead aggressively
+      m_segment.region->advise(
+          boost::interprocess::mapped_region::advice_sequential);
+    }
+    return true;
+  }
+
+  void create_segment(const std::uint64_t sequence) const {
+    const auto path = segment_path(sequence);
+    create_file(path, m_header_size + m_segment_size);
+    const auto region = map_file(path);
+    const auto header = static_cast<SegmentHeader *>(region->get_address());
+    std::memset(header, 0, m_header_size);
+    header->version = VERSION;
+    header->data_size = m_segment_size;
+    header->sequence = sequence;
+    std::atomic_ref(header->magic).store(SEGMENT_MAGIC,
+                                         std::memory_order_release);
+  }
+
+  // Writer only: make the next segment visible, then seal the current one so
+  // that readers never observe a sealed segment without a successor. Its
+  // dirty pages outlive the mapping in the page cache, checkpoint() flushes
+  // them.
+  void roll_segment() {
+    const std::uint64_t next = m_segment.sequence + 1;
+    if (next > (~std::uint64_t{0} >> OFFSET_BITS))
+      throw std::runtime_error("Journal segment sequence numbers exhausted");
+    create_segment(next);
+    std::atomic_ref(m_segment.header->sealed).store(1, std::memory_order_release);
+    m_unflushed.push_back(m_segment.sequence);
+    if (!map_segment(next))
+      throw std::runtime_error("Failed to map journal segment " +
+                               segment_path(next).string());
+    m_tail = 0;
+  }
+
+  // Writer only: repairs what a crashed writer may have left behind. A crash
+  // inside roll_segment() leaves the previous segment unsealed, which would
+  // stall every reader on it, and a crash inside create_segment() leaves the
+  // newest file without its magic.
+  void open_writer() {
+    std::filesystem::create_directories(m_journal_dir);
+    std::vector<std::uint64_t> sequences;
+    for (const auto &entry : std::filesystem::directory_iterator(m_journal_dir)) {
+      std::uint64_t sequence;
+      if (parse_sequence(entry.path(), sequence))
+        sequences.push_back(sequence);
+    }
+    const std::uint64_t last =
+        sequences.empty() ? 0 : *std::ranges::max_element(sequences);
+    if (!map_segment(last)) {
+      // Missing or half-created, nothing in it was ever visible to readers
+      create_segment(last);
+      if (!map_segment(last))
+        throw std::runtime_error("Failed to map journal segment " +
+                                 segment_path(last).string());
+    }
+    for (const std::uint64_t sequence : sequences) {
+      if (sequence == last)
+        continue;
+      const auto region = map_file(segment_path(sequence));
+      const auto header = static_cast<SegmentHeader *>(region->get_address());
+      if (std::atomic_ref(header->magic).load(std::memory_order_acquire) ==
+          SEGMENT_MAGIC)
+        std::atomic_ref(header->sealed).store(1, std::memory_order_release);
+    }
+    // A restarted writer continues right after the last committed record,
+    // anything past the committed tail was never visible to readers.
+    m_segment_size = m_segment.header->data_size;
+    m_tail = std::atomic_ref(m_segment.header->tail)
+                 .load(std::memory_order_acquire);
+  }
+
+  void open_reader(const std::string &cursor_name) {
+    const auto path = m_journal_dir / (cursor_name + ".cursor");
+    const bool existed = std::filesystem::exists(path);
+    if (!existed) {
+      std::filesystem::create_directories(m_journal_dir);
+      create_file(path, sizeof(Cursor));
+    }
+    m_cursor_region = map_file(path);
+    m_cursor = static_cast<Cursor *>(m_cursor_region->get_address());
+    if (m_cursor->magic != CURSOR_MAGIC) {
+      // A fresh cursor replays from the oldest segment still on disk
+      store_cursor(oldest_segment(), 0);
+      m_cursor->magic = CURSOR_MAGIC;
+    }
+  }
+
+  void store_cursor(const std::uint64_t segment, const std::uint64_t offset) {
+    std::atomic_ref(m_cursor->position)
+        .store(segment << OFFSET_BITS | offset, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t cursor_position() const {
+    return std::atomic_ref(m_cursor->position)
+        .load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t oldest_segment() const {
+    std::uint64_t oldest = 0;
+    bool found = false;
+    if (!std::filesystem::exists(m_journal_dir))
+      return 0;
+    for (const auto &entry : std::filesystem::directory_iterator(m_journal_dir)) {
+      std::uint64_t sequence;
+      if (!parse_sequence(entry.path(), sequence))
+        continue;
+      if (!found || sequence < oldest)
+        oldest = sequence;
+      found = true;
+    }
+    return oldest;
+  }
+
+public:
+  /// @param journal_dir directory holding the segment and cursor files
+  /// @param ownership true for the (single) writer, false for a reader
+  /// @param segment_size_bytes payload bytes per segment, less than 4 GiB.
+  /// Only used when the writer creates the first segment, afterward it is
+  /// read from the segment header
+  /// @param cursor_name identifies a reader's durable cursor, readers sharing
+  /// a name resume from the same position
+  explicit JournalQueue(const std::string &journal_dir,
+                        const bool ownership = false,
+                        const std::uint64_t segment_size_bytes = 64 << 20,
+                        const std::string &cursor_name = "default")
+      : m_journal_dir(journal_dir), m_ownership(ownership),
+        m_segment_size(segment_size_bytes) {
+    if (m_segment_size > OFFSET_MASK)
+      throw std::invalid_argument("Journal segments must be less than 4 GiB");
+    if (m_ownership)
+      open_writer();
+    else
+      open_reader(cursor_name);
+  }
+
+  // Disable copy operations.
+  JournalQueue(const JournalQueue &) = delete;
+
+  JournalQueue &operator=(const JournalQueue &) = delete;
+
+  ~JournalQueue() { dispose(); }
+
+  // Appends a message. Only returns false if the message can never fit into a
+  // segment; the journal itself is never full.
+  template <ByteSequence U> bool enqueue_impl(U &&msg_bytes) {
+    const auto bytes = as_byte_span(msg_bytes);
+    const int msg_length = static_cast<int>(bytes.size());
+    const std::uint64_t element_length = sizeof(int) + msg_length;
+    if (element_length > m_segment_size)
+      return false;
+    if (m_tail + element_length > m_segment_size)
+      roll_segment();
+
+    char *record = m_segment.data + m_tail;
+    std::memcpy(record, &msg_length, sizeof(int));
+    std::memcpy(record + sizeof(int), bytes.data(), msg_length);
+    m_tail += element_length;
+    std::atomic_ref(m_segment.header->tail)
+        .store(m_tail, std::memory_order_release);
+    return true;
+  }
+
+  bool dequeue_impl(std::string &buffer) {
+    return consume_up_to_impl(1, [&buffer](const std::span<const std::byte>
+                                               msg) {
+             buffer.assign(reinterpret_cast<const char *>(msg.data()),
+                           msg.size());
+           }) == 1;
+  }
+
+  /// Reader only: hands up to max_items records to fn as
+  /// std::span<const std::byte> pointing into the segment mapping, advancing
+  /// the durable cursor once per segment. Committed records are never
+  /// modified, so nothing is copied.
+  template <typename F>
+  std::size_t consume_up_to_impl(const std::size_t max_items, F &&fn) {
+    std::size_t count = 0;
+    while (count < max_items) {
+      const std::uint64_t position = cursor_position();
+      if (m_segment.header == nullptr ||
+          m_segment.sequence != position >> OFFSET_BITS) {
+        // The writer may not have created the segment yet
+        if (!map_segment(position >> OFFSET_BITS))
+          break;
+      }
+      std::uint64_t offset = position & OFFSET_MASK;
+      // Load sealed before tail: once sealed is observed, the tail is final
+      const bool sealed = std::atomic_ref(m_segment.header->sealed)
+                              .load(std::memory_order_acquire) != 0;
+      const std::uint64_t tail = std::atomic_ref(m_segment.header->tail)
+                                     .load(std::memory_order_acquire);
+      if (offset >= tail) {
+        if (!sealed) // Nothing new committed
+          break;
+        if (!map_segment(m_segment.sequence + 1))
+          break;
+        store_cursor(m_segment.sequence, 0);
+        continue;
+      }
+
+      while (offset < tail && count < max_items) {
+        int msg_length;
+        std::memcpy(&msg_length, m_segment.data + offset, sizeof(int));
+        try {
+          fn(std::span<const std::byte>(
+              reinterpret_cast<const std::byte *>(m_segment.data + offset +
+                                                  sizeof(int)),
+              msg_length));
+        } catch (...) {
+          store_cursor(m_segment.sequence, offset);
+          throw;
+        }
+        offset += sizeof(int) + msg_length;
+        ++count;
+      }
+      store_cursor(m_segment.sequence, offset);
+    }
+    return count;
+  }
+
+  /// Flushes the writer's current segment and every segment it sealed since
+  /// the last checkpoint, or the reader's cursor, to stable storage with
+  /// msync(). Everything is already crash-safe against process failure
+  /// without calling this, checkpoint() only matters for power loss or a
+  /// kernel crash.
+  /// @param async schedule the write-back (MS_ASYNC) instead of waiting for it
+  bool checkpoint(const bool async = false) {
+    if (!m_ownership)
+      return m_cursor_region->flush(0, 0, async);
+    if (m_segment.region == nullptr)
+      return false;
+    while (!m_unflushed.empty()) {
+      // Removed segments have nothing left to flush
+      const auto path = segment_path(m_unflushed.back());
+      if (std::filesystem::exists(path) && !map_file(path)->flush(0, 0, async))
+        return false;
+      m_unflushed.pop_back();
+    }
+    return m_segment.region->flush(0, m_header_size + m_tail, async);
+  }
+
+  /// Writer only: deletes whole segments strictly older than sequence, e.g.
+  /// the smallest cursor_segment() across all readers.
+  void remove_segments_before(const std::uint64_t sequence) const {
+    for (const auto &entry : std::filesystem::directory_iterator(m_journal_dir)) {
+      std::uint64_t entry_sequence;
+      if (parse_sequence(entry.path(), entry_sequence) &&
+          entry_sequence < sequence)
+        std::filesystem::remove(entry.path());
+    }
+  }
+
+  /// Sequence number of the segment the writer appends to, or the reader
+  /// replays from.
+  [[nodiscard]] std::uint64_t cursor_segment() const {
+    if (m_ownership)
+      return m_segment.sequence;
+    return cursor_position() >> OFFSET_BITS;
+  }
+
+  [[nodiscard]] int head_impl() const {
+    if (m_ownership)
+      return 0;
+    return static_cast<int>(cursor_position() & OFFSET_MASK);
+  }
+
+  [[nodiscard]] int tail_impl() const {
+    if (m_segment.header == nullptr)
+      return 0;
+    return static_cast<int>(std::atomic_ref(m_segment.header->tail)
+                                .load(std::memory_order_relaxed));
+  }
+
+  void dispose() {
+    m_segment.region.reset();
+    m_segment.header = nullptr;
+    m_segment.data = nullptr;
+    m_cursor_region.reset();
+    m_cursor = nullptr;
+  }
+};
+} // namespace RingBuffer::Interprocess
+#endif // INTERPROCESS_JOURNAL_QUEUE_IMPL_H
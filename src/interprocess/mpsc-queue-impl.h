@@ -0,0 +1,396 @@
+#ifndef INTERPROCESS_MPSC_QUEUE_IMPL_H
+#define INTERPROCESS_MPSC_QUEUE_IMPL_H
+
+#include "../ringbuffer-interface.h"
+#include "byte-sequence.h"
+#include "segment-header.h"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+
+/* A multi-producer-process to single-consumer channel in one shared memory
+ * segment. Every producer process registers a private lane, which is an SPSC
+ * byte ring with the same framing as SpscQueue, so producers never contend
+ * with each other. After publishing a record the producer rings the lane's bit
+ * in a doorbell bitmap, the consumer scans the bitmap instead of polling every
+ * lane:
+ *
+ *   +---------------+----------+-----------------------+-------+-----+-------+
+ *   | SegmentHeader | doorbell | lane control blocks   | lane0 | ... | laneN |
+ *   |               | bitmap   | {pid, tail}, {head}   | data  |     | data  |
+ *   +---------------+----------+-----------------------+-------+-----+-------+
+ *
+ * Lanes are claimed with a CAS on their pid. A producer that exits, or
+ * crashes and is found by reap_producers(), leaves its lane RETIRED; the
+ * consumer drains whatever the producer published and only then frees the
+ * lane for the next producer.
+ */
+namespace RingBuffer::Interprocess {
+class MpscQueue : public IRingBuffer<MpscQueue, std::string> {
+public:
+  static constexpr int MAX_LANES = 256;
+
+private:
+  static constexpr int FLAG_WRAPPED = -1;
+  static constexpr int DEFAULT_LANE_SIZE = 1 << 16;
+  static constexpr int DEFAULT_LANE_COUNT = 64;
+  static constexpr std::uint64_t LANE_FREE = 0;
+  static constexpr std::uint64_t LANE_RETIRED =
+      std::numeric_limits<std::uint64_t>::max();
+  static constexpr int DOORBELL_WORDS = MAX_LANES / 64;
+
+  struct alignas(64) Doorbell {
+    std::uint64_t words[DOORBELL_WORDS];
+  };
+  struct alignas(64) LaneControl {
+    // Written by the producer
+    std::uint64_t pid;
+    std::uint64_t tail;
+    // Written by the consumer
+    alignas(64) std::uint64_t head;
+  };
+  static constexpr int m_doorbell_offset = sizeof(SegmentHeader);
+  static constexpr int m_lanes_offset = m_doorbell_offset + sizeof(Doorbell);
+
+  int m_lane_count = 0;
+  std::uint64_t m_lane_size = 0;
+  std::uint64_t m_header_size = 0;
+  char *m_base_ptr = nullptr;
+  bool m_ownership;
+  std::string m_mapped_file_name;
+  size_t m_total_size = 0;
+  std::unique_ptr<boost::interprocess::shared_memory_object> m_shm_obj;
+  std::unique_ptr<boost::interprocess::mapped_region> m_region;
+
+  // Producer side
+  int m_lane = -1;
+  std::uint64_t m_tail = 0;
+  std::uint64_t m_cached_head = 0;
+  // Consumer side: lanes whose doorbell we took but have not drained yet
+  std::uint64_t m_pending[DOORBELL_WORDS] = {};
+  int m_next_lane = 0;
+
+  [[nodiscard]] std::uint64_t *doorbell_words() const {
+    return reinterpret_cast<Doorbell *>(m_base_ptr + m_doorbell_offset)->words;
+  }
+
+  [[nodiscard]] LaneControl &lane_control(const int lane) const {
+    const auto lanes =
+        reinterpret_cast<LaneControl *>(m_base_ptr + m_lanes_offset);
+    return lanes[lane];
+  }
+
+  [[nodiscard]] char *lane_data(const int lane) const {
+    return m_base_ptr + m_header_size + m_lane_size * lane;
+  }
+
+  static std::uint64_t compute_header_size(const int lane_count) {
+    return m_lanes_offset + sizeof(LaneControl) * lane_count;
+  }
+
+  void map_region(const SegmentOptions &options) {
+    namespace bip = boost::interprocess;
+    m_region =
+        std::make_unique<bip::mapped_region>(*m_shm_obj, bip::read_write);
+    m_base_ptr = static_cast<char *>(m_region->get_address());
+    m_total_size = m_region->get_size();
+    if (options.lock_pages)
+      lock_pages(m_base_ptr, m_total_size);
+    if (options.prefault)
+      prefault(m_base_ptr, m_total_size);
+  }
+
+  void ring_doorbell(const int lane) const {
+    const std::atomic_ref word(doorbell_words()[lane / 64]);
+    const std::uint64_t bit = std::uint64_t{1} << (lane % 64);
+    // seq_cst pairs with the consumer's exchange(): either the consumer sees
+    // our tail after taking the doorbell, or we see the bit cleared and ring
+    // it again. Skipping the RMW while the bit is still set keeps the hot
+    // path free of locked instructions on a busy lane.
+    if ((word.load(std::memory_order_seq_cst) & bit) == 0)
+      word.fetch_or(bit, std::memory_order_seq_cst);
+  }
+
+  void register_lane() {
+    const std::uint64_t pid = current_pid();
+    for (int i = 0; i < m_lane_count; ++i) {
+      std::uint64_t expected = LANE_FREE;
+      if (std::atomic_ref(lane_control(i).pid)
+              .compare_exchange_strong(expected, pid,
+                                       std::memory_order_acq_rel)) {
+        m_lane = i;
+        break;
+      }
+    }
+    if (m_lane < 0)
+      throw std::runtime_error("No free producer lane in [" +
+                               m_mapped_file_name + "]");
+    // A recycled lane continues at the position its previous producer left
+    // off, which the consumer has fully drained before freeing it
+    m_tail = std::atomic_ref(lane_control(m_lane).tail)
+                 .load(std::memory_order_acquire);
+    m_cached_head = m_tail;
+  }
+
+  // Consumer only: hands up to max_items records of a lane to fn in place and
+  // releases them with a single head store, frees the lane if it is retired
+  // and fully drained
+  template <typename F>
+  std::size_t consume_lane(const int lane, const std::size_t max_items,
+                           F &fn) const {
+    auto &control = lane_control(lane);
+    std::uint64_t head = control.head;
+    // Check for retirement before loading the tail: the producer retires
+    // after its final tail store, so that store is visible to us then
+    const bool retired =
+        std::atomic_ref(control.pid).load(std::memory_order_acquire) ==
+        LANE_RETIRED;
+    const std::uint64_t tail =
+        std::atomic_ref(control.tail).load(std::memory_order_seq_cst);
+    std::size_t count = 0;
+    while (head != tail && count < max_items) {
+      const std::uint64_t offset = head % m_lane_size;
+      if (m_lane_size - offset < sizeof(int)) {
+        head += m_lane_size - offset;
+        continue;
+      }
+      const char *record = lane_data(lane) + offset;
+      int msg_length;
+      std::memcpy(&msg_length, record, sizeof(int));
+      if (msg_length == FLAG_WRAPPED) {
+        head += m_lane_size - offset;
+        continue;
+      }
+      try {
+        fn(std::span<const std::byte>(
+            reinterpret_cast<const std::byte *>(record + sizeof(int)),
+            msg_length));
+      } catch (...) {
+        // Keep the record fn threw on, the lane's bit stays pending
+        std::atomic_ref(control.head).store(head, std::memory_order_release);
+        throw;
+      }
+      head += sizeof(int) + msg_length;
+      ++count;
+    }
+    std::atomic_ref(control.head).store(head, std::memory_order_release);
+    if (retired && head == tail) {
+      // The producer is gone and everything it published has been consumed
+      std::atomic_ref(control.pid)
+          .store(LANE_FREE, std::memory_order_release);
+    }
+    return count;
+  }
+
+  bool take_doorbells() {
+    bool any = false;
+    for (int w = 0; w < DOORBELL_WORDS; ++w) {
+      const std::atomic_ref word(doorbell_words()[w]);
+      if (word.load(std::memory_order_relaxed) == 0)
+        continue;
+      m_pending[w] |= word.exchange(0, std::memory_order_seq_cst);
+      any = true;
+    }
+    return any;
+  }
+
+public:
+  /// @param queue_name name of the shared memory object
+  /// @param ownership true for the (single) consumer, which creates and
+  /// eventually removes the segment; false for a producer, which registers a
+  /// lane of its own
+  /// @param lane_size_bytes payload bytes per producer lane, read from the
+  /// segment header by producers. Records never straddle the end of a lane,
+  /// so only records of up to half a lane are guaranteed to fit into an
+  /// empty lane
+  /// @param lane_count maximum number of concurrently registered producers,
+  /// at most MAX_LANES
+  explicit MpscQueue(const std::string &queue_name,
+                     const bool ownership = false,
+                     const int lane_size_bytes = 0, const int lane_count = 0,
+                     const SegmentOptions &options = {})
+      : m_ownership(ownership), m_mapped_file_name(queue_name) {
+    namespace bip = boost::interprocess;
+    if (m_ownership) {
+      m_lane_size = lane_size_bytes > 0 ? lane_size_bytes : DEFAULT_LANE_SIZE;
+      m_lane_count = lane_count > 0 ? lane_count : DEFAULT_LANE_COUNT;
+      if (m_lane_count > MAX_LANES)
+        throw std::invalid_argument("lane_count exceeds MAX_LANES");
+      m_header_size = compute_header_size(m_lane_count);
+      m_shm_obj = std::make_unique<bip::shared_memory_object>(
+          bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
+      m_shm_obj->truncate(
+          static_cast<long>(m_header_size + m_lane_size * m_lane_count));
+      map_region(options);
+      std::memset(m_base_ptr, 0, m_total_size);
+      publish_header(m_base_ptr, SegmentKind::MpscQueue, m_header_size,
+                     m_lane_size * m_lane_count, m_lane_count, m_lane_size);
+      return;
+    }
+
+    m_shm_obj = std::make_unique<bip::shared_memory_object>(
+        bip::open_only, m_mapped_file_name.c_str(), bip::read_write);
+    map_region(options);
+    const auto &header = read_header(m_base_ptr, m_total_size,
+                                     SegmentKind::MpscQueue, queue_name);
+    m_lane_count = static_cast<int>(header.params[0]);
+    m_lane_size = header.params[1];
+    m_header_size = compute_header_size(m_lane_count);
+    if (header.header_size != m_header_size)
+      throw std::runtime_error("Unexpected header size of [" + queue_name +
+                               "]");
+    register_lane();
+  }
+
+  // Disable copy operations.
+  MpscQueue(const MpscQueue &) = delete;
+
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  ~MpscQueue() { dispose(); }
+
+  // Producer only: appends a message to this process's lane.
+  template <ByteSequence U> bool enqueue_impl(U &&msg_bytes) {
+    const auto bytes = as_byte_span(msg_bytes);
+    const int msg_length = static_cast<int>(bytes.size());
+    const std::uint64_t element_length = sizeof(int) + msg_length;
+    const std::uint64_t offset = m_tail % m_lane_size;
+    const std::uint64_t skip =
+        m_lane_size - offset < element_length ? m_lane_size - offset : 0;
+    const std::uint64_t new_tail = m_tail + skip + element_length;
+
+    auto &control = lane_control(m_lane);
+    if (new_tail - m_cached_head > m_lane_size) {
+      m_cached_head =
+          std::atomic_ref(control.head).load(std::memory_order_acquire);
+      if (new_tail - m_cached_head > m_lane_size)
+        return false;
+    }
+
+    char *data = lane_data(m_lane);
+    if (skip >= sizeof(int)) {
+      constexpr int flag = FLAG_WRAPPED;
+      std::memcpy(data + offset, &flag, sizeof(int));
+    }
+    const std::uint64_t start_offset = (m_tail + skip) % m_lane_size;
+    std::memcpy(data + start_offset, &msg_length, sizeof(int));
+    std::memcpy(data + start_offset + sizeof(int), bytes.data(),
+                msg_length);
+    m_tail = new_tail;
+    std::atomic_ref(control.tail).store(new_tail, std::memory_order_seq_cst);
+    ring_doorbell(m_lane);
+    return true;
+  }
+
+  // Consumer only: dequeues one message from whichever lane rang, lanes are
+  // served round-robin so that one busy producer cannot starve the others.
+  bool dequeue_impl(std::string &buffer) {
+    return consume_up_to_impl(1, [&buffer](const std::span<const std::byte>
+                                               msg) {
+             buffer.assign(reinterpret_cast<const char *>(msg.data()),
+                           msg.size());
+           }) == 1;
+  }
+
+  /// Consumer only: hands up to max_items messages to fn as
+  /// std::span<const std::byte>, sweeping each lane that rang in place and
+  /// publishing its head once. Lanes are visited round-robin like in
+  /// dequeue().
+  template <typename F>
+  std::size_t consume_up_to_impl(const std::size_t max_items, F &&fn) {
+    std::size_t count = 0;
+    for (int attempt = 0; attempt < 2 && count < max_items; ++attempt) {
+      for (int i = 0; i < m_lane_count; ++i) {
+        const int lane = (m_next_lane + i) % m_lane_count;
+        const std::uint64_t bit = std::uint64_t{1} << (lane % 64);
+        if ((m_pending[lane / 64] & bit) == 0)
+          continue;
+        count += consume_lane(lane, max_items - count, fn);
+        if (count == max_items) {
+          // The lane may hold more, keep its bit and resume after it
+          m_next_lane = lane + 1;
+          return count;
+        }
+        m_pending[lane / 64] &= ~bit;
+      }
+      if (!take_doorbells())
+        break;
+    }
+    return count;
+  }
+
+  /// Consumer only: retires the lanes of producer processes that died without
+  /// unregistering. Their published records are still delivered, after which
+  /// the lanes are reused.
+  /// @return number of lanes retired
+  int reap_producers() {
+    int reaped = 0;
+    for (int i = 0; i < m_lane_count; ++i) {
+      std::uint64_t pid =
+          std::atomic_ref(lane_control(i).pid).load(std::memory_order_acquire);
+      if (pid == LANE_FREE || pid == LANE_RETIRED || process_alive(pid))
+        continue;
+      if (std::atomic_ref(lane_control(i).pid)
+              .compare_exchange_strong(pid, LANE_RETIRED,
+                                       std::memory_order_acq_rel)) {
+        m_pending[i / 64] |= std::uint64_t{1} << (i % 64);
+        ++reaped;
+      }
+    }
+    return reaped;
+  }
+
+  /// Number of lanes currently owned by a producer, including retired lanes
+  /// that still hold undelivered records.
+  [[nodiscard]] int producer_count() const {
+    int count = 0;
+    for (int i = 0; i < m_lane_count; ++i) {
+      if (std::atomic_ref(lane_control(i).pid)
+              .load(std::memory_order_relaxed) != LANE_FREE)
+        ++count;
+    }
+    return count;
+  }
+
+  /// Producer only: the lane this process registered.
+  [[nodiscard]] int lane() const { return m_lane; }
+
+  [[nodiscard]] int head_impl() const {
+    if (m_lane < 0)
+      return 0;
+    return static_cast<int>(std::atomic_ref(lane_control(m_lane).head)
+                                .load(std::memory_order_relaxed) %
+                            m_lane_size);
+  }
+
+  [[nodiscard]] int tail_impl() const {
+    return static_cast<int>(m_tail % m_lane_size);
+  }
+
+  void dispose() {
+    if (m_base_ptr != nullptr && m_lane >= 0) {
+      // Hand the lane back, the consumer frees it once it is drained
+      std::atomic_ref(lane_control(m_lane).pid)
+          .store(LANE_RETIRED, std::memory_order_seq_cst);
+      ring_doorbell(m_lane);
+      m_lane = -1;
+    }
+    m_region.reset();
+    m_shm_obj.reset();
+    if (m_ownership) {
+      boost::interprocess::shared_memory_object::remove(
+          m_mapped_file_name.c_str());
+    }
+    m_base_ptr = nullptr;
+  }
+};
+} // namespace RingBuffer::Interprocess
+#endif // INTERPROCESS_MPSC_QUEUE_IMPL_H
@@ -0,0 +1,183 @@
+#ifndef INTERPROCESS_NOTIFIER_IMPL_H
+#define INTERPROCESS_NOTIFIER_IMPL_H
+
+#include "../detail/wakeup.h"
+#include "segment-header.h"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* The shared memory flavor of Intraprocess::Notifier, for a consumer process
+ * that blocks in its epoll loop on sockets and an Interprocess queue
+ * together. The sleep/wake word lives in a small segment of its own:
+ *
+ *   +---------------+----------+
+ *   | SegmentHeader | word     |
+ *   +---------------+----------+
+ *
+ * An eventfd cannot be opened by name from another process, so the readiness
+ * signal is a named FIFO next to the segment (/dev/shm/<name>.wakeup). Both
+ * ends open it read-write and non-blocking: the producer writes one byte when
+ * it finds the consumer sleeping, the consumer polls it and drains it after a
+ * wakeup. As intraprocess, a busy consumer costs no syscall per message, see
+ * detail/wakeup.h. POSIX only.
+ */
+namespace RingBuffer::Interprocess {
+
+class Notifier {
+private:
+  struct alignas(64) WordLine {
+    std::uint32_t word;
+  };
+  static constexpr int m_word_offset = sizeof(SegmentHeader);
+  static constexpr int m_header_size = m_word_offset + sizeof(WordLine);
+
+  char *m_base_ptr = nullptr;
+  bool m_ownership;
+  std::string m_mapped_file_name;
+  std::string m_fifo_path;
+  int m_fd = -1;
+  size_t m_total_size = 0;
+  std::unique_ptr<boost::interprocess::shared_memory_object> m_shm_obj;
+  std::unique_ptr<boost::interprocess::mapped_region> m_region;
+
+  [[nodiscard]] std::uint32_t &word() const {
+    return reinterpret_cast<WordLine *>(m_base_ptr + m_word_offset)->word;
+  }
+
+  void map_region(const SegmentOptions &options) {
+    namespace bip = boost::interprocess;
+    m_region =
+        std::make_unique<bip::mapped_region>(*m_shm_obj, bip::read_write);
+    m_base_ptr = static_cast<char *>(m_region->get_address());
+    m_total_size = m_region->get_size();
+    if (options.lock_pages)
+      lock_pages(m_base_ptr, m_total_size);
+    if (options.prefault)
+      prefault(m_base_ptr, m_total_size);
+  }
+
+  void open_fifo() {
+    m_fd = open(m_fifo_path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0)
+      throw std::system_error(errno, std::generic_category(),
+                              "open(" + m_fifo_path + ")");
+  }
+
+public:
+  /// @param name name of the shared memory object, the FIFO is named after
+  /// it
+  /// @param ownership the owner creates, initializes and eventually removes
+  /// the segment and the FIFO; the other endpoint attaches to them
+  explicit Notifier(const std::string &name, const bool ownership = false,
+                    const SegmentOptions &options = {})
+      : m_ownership(ownership), m_mapped_file_name(name),
+        m_fifo_path("/dev/shm/" + name + ".wakeup") {
+    namespace bip = boost::interprocess;
+    if (m_ownership) {
+      // A FIFO left behind by a crashed owner may still hold stale bytes
+      unlink(m_fifo_path.c_str());
+      if (mkfifo(m_fifo_path.c_str(), 0600) != 0)
+        throw std::system_error(errno, std::generic_category(),
+                                "mkfifo(" + m_fifo_path + ")");
+      open_fifo();
+      m_shm_obj = std::make_unique<bip::shared_memory_object>(
+          bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
+      m_shm_obj->truncate(m_header_size);
+      map_region(options);
+      std::memset(m_base_ptr, 0, m_header_size);
+      publish_header(m_base_ptr, SegmentKind::Notifier, m_header_size, 0);
+      return;
+    }
+
+    m_shm_obj = std::make_unique<bip::shared_memory_object>(
+        bip::open_only, m_mapped_file_name.c_str(), bip::read_write);
+    map_region(options);
+    const auto &header =
+        read_header(m_base_ptr, m_total_size, SegmentKind::Notifier, name);
+    if (header.header_size != m_header_size)
+      throw std::runtime_error("Unexpected header size of [" + name + "]");
+    open_fifo();
+  }
+
+  // Disable copy operations.
+  Notifier(const Notifier &) = delete;
+
+  Notifier &operator=(const Notifier &) = delete;
+
+  ~Notifier() { dispose(); }
+
+  /// The FIFO to register with epoll/poll for EPOLLIN/POLLIN.
+  [[nodiscard]] int fd() const { return m_fd; }
+
+  /// Producer side: call after each successful enqueue(). Writes the FIFO
+  /// only if the consumer is waiting.
+  void notify() {
+    if (Detail::wakeup_take(word())) {
+      const char one = 1;
+      // EAGAIN means the FIFO is full, i.e., readable anyway
+      (void) !write(m_fd, &one, sizeof(one));
+    }
+  }
+
+  /// Consumer side: call right before polling the queue one last time, block
+  /// on fd() only if that poll comes back empty.
+  void prepare_wait() { Detail::wakeup_arm(word()); }
+
+  /// Consumer side: the last poll after prepare_wait() found messages, the
+  /// consumer does not block after all.
+  void cancel_wait() { Detail::wakeup_disarm(word()); }
+
+  /// Consumer side: drains fd() after it became readable.
+  void acknowledge() {
+    char buf[64];
+    while (read(m_fd, buf, sizeof(buf)) == sizeof(buf)) {
+    }
+  }
+
+  /// Consumer side: blocks on fd() without an epoll loop of its own, for
+  /// after a prepare_wait() whose last poll came back empty.
+  /// @param timeout_ms -1 waits indefinitely
+  /// @return false on timeout
+  bool wait(const int timeout_ms = -1) {
+    pollfd pfd{m_fd, POLLIN, 0};
+    int ready;
+    while ((ready = poll(&pfd, 1, timeout_ms)) < 0 && errno == EINTR) {
+    }
+    if (ready <= 0) {
+      cancel_wait();
+      return false;
+    }
+    acknowledge();
+    return true;
+  }
+
+  void dispose() {
+    m_region.reset();
+    m_shm_obj.reset();
+    if (m_fd >= 0)
+      close(m_fd);
+    m_fd = -1;
+    if (m_ownership) {
+      boost::interprocess::shared_memory_object::remove(
+          m_mapped_file_name.c_str());
+      unlink(m_fifo_path.c_str());
+    }
+    m_base_ptr = nullptr;
+  }
+};
+} // namespace RingBuffer::Interprocess
+
+#endif // INTERPROCESS_NOTIFIER_IMPL_H
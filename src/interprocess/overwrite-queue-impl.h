@@ -0,0 +1,170 @@
+#ifndef INTERPROCESS_OVERWRITE_QUEUE_IMPL_H
+#define INTERPROCESS_OVERWRITE_QUEUE_IMPL_H
+
+#include "../detail/overwrite-ring.h"
+#include "../ringbuffer-interface.h"
+#include "segment-header.h"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+/* The shared memory flavor of Intraprocess::OverwriteQueue, e.g., an always-on
+ * flight recorder the hot path writes into and a tool attaches to on demand:
+ *
+ *   +---------------+----------+--------------+--------------+-----+
+ *   | SegmentHeader | written  | slot 0       | slot 1       | ... |
+ *   |               |          | {seq, words} | {seq, words} |     |
+ *   +---------------+----------+--------------+--------------+-----+
+ *
+ * The producer never reads anything the consumer writes, so a slow, stopped
+ * or crashed consumer can never hold it back. A consumer starts at the oldest
+ * message still in the ring, i.e., it first replays the recorded history.
+ */
+namespace RingBuffer::Interprocess {
+
+template <typename T>
+class OverwriteQueue : public IRingBuffer<OverwriteQueue<T>, T> {
+private:
+  using Slot = Detail::SeqlockSlot<T>;
+  struct alignas(64) ProducerLine {
+    std::uint64_t written;
+  };
+  static constexpr int m_producer_offset = sizeof(SegmentHeader);
+  static constexpr int m_header_size =
+      m_producer_offset + sizeof(ProducerLine);
+  static constexpr std::uint64_t DEFAULT_CAPACITY = 1 << 16;
+
+  std::uint64_t m_capacity = 0;
+  char *m_base_ptr = nullptr;
+  bool m_ownership;
+  std::string m_mapped_file_name;
+  size_t m_total_size = 0;
+  std::unique_ptr<boost::interprocess::shared_memory_object> m_shm_obj;
+  std::unique_ptr<boost::interprocess::mapped_region> m_region;
+  // Consumer side
+  std::uint64_t m_cursor = 0;
+  std::uint64_t m_dropped = 0;
+
+  [[nodiscard]] std::uint64_t &written() const {
+    return reinterpret_cast<ProducerLine *>(m_base_ptr + m_producer_offset)
+        ->written;
+  }
+
+  [[nodiscard]] Detail::OverwriteRing<T> ring() const {
+    return {reinterpret_cast<Slot *>(m_base_ptr + m_header_size),
+            m_capacity - 1, written()};
+  }
+
+  void map_region(const SegmentOptions &options) {
+    namespace bip = boost::interprocess;
+    m_region =
+        std::make_unique<bip::mapped_region>(*m_shm_obj, bip::read_write);
+    m_base_ptr = static_cast<char *>(m_region->get_address());
+    m_total_size = m_region->get_size();
+    if (options.lock_pages)
+      lock_pages(m_base_ptr, m_total_size);
+    if (options.prefault)
+      prefault(m_base_ptr, m_total_size);
+  }
+
+public:
+  /// @param name name of the shared memory object
+  /// @param ownership the owner creates, initializes and eventually removes
+  /// the segment; other endpoints attach to a segment the owner created.
+  /// Either end may own it, usually the producer does
+  /// @param capacity number of slots, rounded up to a power of two; read from
+  /// the segment header by attachers, which may pass 0
+  explicit OverwriteQueue(const std::string &name, const bool ownership = false,
+                          const std::size_t capacity = 0,
+                          const SegmentOptions &options = {})
+      : m_ownership(ownership), m_mapped_file_name(name) {
+    namespace bip = boost::interprocess;
+    if (m_ownership) {
+      m_capacity = Detail::overwrite_ring_capacity(
+          capacity > 0 ? capacity : DEFAULT_CAPACITY);
+      m_shm_obj = std::make_unique<bip::shared_memory_object>(
+          bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
+      m_shm_obj->truncate(
+          static_cast<long>(m_header_size + sizeof(Slot) * m_capacity));
+      map_region(options);
+      std::memset(m_base_ptr, 0, m_total_size);
+      publish_header(m_base_ptr, SegmentKind::OverwriteQueue, m_header_size,
+                     sizeof(Slot) * m_capacity, m_capacity, sizeof(T));
+      return;
+    }
+
+    m_shm_obj = std::make_unique<bip::shared_memory_object>(
+        bip::open_only, m_mapped_file_name.c_str(), bip::read_write);
+    map_region(options);
+    const auto &header = read_header(m_base_ptr, m_total_size,
+                                     SegmentKind::OverwriteQueue, name);
+    if (header.header_size != m_header_size || header.params[1] != sizeof(T))
+      throw std::runtime_error("[" + name +
+                               "] holds messages of a different type");
+    m_capacity = header.params[0];
+    if (capacity > 0 && Detail::overwrite_ring_capacity(capacity) != m_capacity)
+      throw std::runtime_error("capacity does not match [" + name +
+                               "]: " + std::to_string(m_capacity));
+    const std::uint64_t written_so_far =
+        std::atomic_ref(written()).load(std::memory_order_acquire);
+    m_cursor = written_so_far > m_capacity ? written_so_far - m_capacity : 0;
+  }
+
+  // Disable copy operations.
+  OverwriteQueue(const OverwriteQueue &) = delete;
+
+  OverwriteQueue &operator=(const OverwriteQueue &) = delete;
+
+  ~OverwriteQueue() { dispose(); }
+
+  /// Always succeeds, overwriting the oldest message if the ring is full.
+  template <typename U>
+    requires std::assignable_from<T &, U>
+  bool enqueue_impl(U &&item) {
+    if constexpr (std::is_same_v<std::remove_cvref_t<U>, T>) {
+      Detail::overwrite_ring_push(ring(), item);
+    } else {
+      T value;
+      value = std::forward<U>(item);
+      Detail::overwrite_ring_push(ring(), value);
+    }
+    return true;
+  }
+
+  /// Dequeues the oldest message still in the ring, messages that were
+  /// overwritten before they could be dequeued are added to dropped().
+  bool dequeue_impl(T &item) {
+    return Detail::overwrite_ring_pop(ring(), m_cursor, m_dropped, item);
+  }
+
+  /// Number of messages this consumer missed so far.
+  [[nodiscard]] std::uint64_t dropped() const { return m_dropped; }
+
+  [[nodiscard]] std::size_t capacity() const { return m_capacity; }
+
+  [[nodiscard]] int head_impl() const { return static_cast<int>(m_cursor); }
+
+  [[nodiscard]] int tail_impl() const {
+    return static_cast<int>(
+        std::atomic_ref(written()).load(std::memory_order_acquire));
+  }
+
+  void dispose() {
+    m_region.reset();
+    m_shm_obj.reset();
+    if (m_ownership) {
+      boost::interprocess::shared_memory_object::remove(
+          m_mapped_file_name.c_str());
+    }
+    m_base_ptr = nullptr;
+  }
+};
+} // namespace RingBuffer::Interprocess
+
+#endif // INTERPROCESS_OVERWRITE_QUEUE_IMPL_H
@@ -0,0 +1,296 @@
+#ifndef INTERPROCESS_SEGMENT_HEADER_H
+#define INTERPROCESS_SEGMENT_HEADER_H
+
+#include "copy-kernels.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <csignal>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/* Every shared memory segment created by the toolkit starts with a
+ * self-describing SegmentHeader, so that an attaching process learns the
+ * geometry from the segment itself instead of being told out-of-band:
+ *
+ *   +----------------+----------------------+------------------------+
+ *   | SegmentHeader  | queue specific       | payload area           |
+ *   | (64 bytes)     | control block        | (queue_size bytes)     |
+ *   +----------------+----------------------+------------------------+
+ *   0                64                     header_size
+ *
+ * The owner fills in every field and publishes magic last with a
+ * write-release, an attacher read-acquires magic before trusting the rest.
+ */
+namespace RingBuffer::Interprocess {
+
+enum class SegmentKind : std::uint32_t {
+  SpscQueue = 1,
+  BroadcastQueue = 2,
+  MpscQueue = 3,
+  Seqlock = 4,
+  TripleBuffer = 5,
+  OverwriteQueue = 6,
+  Notifier = 7,
+  BlobArena = 8,
+};
+
+struct alignas(64) SegmentHeader {
+  static constexpr std::uint64_t MAGIC = 0x4c4654424f58484d; // LFTBOXHM
+  static constexpr std::uint32_t VERSION = 1;
+
+  std::uint64_t magic;
+  std::uint32_t version;
+  SegmentKind kind;
+  // Offset of the payload area from the start of the segment
+  std::uint64_t header_size;
+  // Size of the payload area in bytes
+  std::uint64_t queue_size;
+  // Nanoseconds since the Unix epoch when the owner created the segment
+  std::int64_t creation_epoch_ns;
+  // Queue specific geometry, e.g., record alignment
+  std::uint64_t params[3];
+};
+static_assert(sizeof(SegmentHeader) == 64);
+
+struct SegmentOptions {
+  // Touch every page of the mapping up front, so that the first lap of the
+  // ring does not pay for page faults
+  bool prefault = true;
+  // mlock() the mapping, so that it is never paged out. Needs a large enough
+  // RLIMIT_MEMLOCK (or CAP_IPC_LOCK)
+  bool lock_pages = false;
+  // Owner only, attachers read it from the header: 1 packs records back to
+  // back, 8 or 64 pads every record to that boundary and publishes its length
+  // word with a write-release (see SpscQueue)
+  int record_alignment = 1;
+  // How this endpoint copies payloads in and out of the segment
+  CopyOptions copy = {};
+  // Owner only: reserve a SegmentStats region after the control block that
+  // the endpoints keep up to date, for queue-top and alike. Costs a branch
+  // per operation when off, a few stores to the endpoint's own cache line
+  // when on
+  bool stats = false;
+  // Owner only: stamp every Nth message (rounded up to a power of two) and
+  // record how long it stayed in the queue, 0 disables sampling. The
+  // segment grows by a 64-byte stamp per N of the most messages the ring
+  // can hold, e.g., 16 MiB for a packed 1 MiB queue with N = 1. See
+  // Detail::SojournLog
+  std::uint64_t sojourn_sample_every = 0;
+};
+
+/* Counters of one endpoint in a SegmentStats region. Only that endpoint
+ * writes its line, with relaxed stores; monitors only read it, and never
+ * the queue's head and tail, so they cannot slow the hot path down beyond
+ * the occasional reload of a stats line.
+ */
+struct alignas(64) EndpointStats {
+  // Messages moved so far and their payload bytes
+  std::uint64_t messages;
+  std::uint64_t bytes;
+  // Producer: enqueue() found the queue full, consumer: found it empty
+  std::uint64_t stalls;
+  // Producer only: the most payload-area bytes ever in use
+  std::uint64_t high_water;
+  // CLOCK_REALTIME in ns, coarse, refreshed on the first message after a
+  // stall and on every 16th message otherwise
+  std::int64_t last_active_ns;
+  // Process that last moved a message
+  std::uint64_t pid;
+};
+
+struct SegmentStats {
+  EndpointStats producer;
+  EndpointStats consumer;
+};
+
+inline std::size_t page_size() {
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#else
+  return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/// Faults in every page of [addr, addr + length). Attachers must not write
+/// to a live ring, so pages are read-touched unless the kernel can populate
+/// them writable for us.
+inline void prefault(void *addr, const std::size_t length) {
+#if defined(MADV_POPULATE_WRITE)
+  if (madvise(addr, length, MADV_POPULATE_WRITE) == 0)
+    return;
+#endif
+  const std::size_t step = page_size();
+  const auto base = static_cast<const volatile char *>(addr);
+  for (std::size_t offset = 0; offset < length; offset += step) {
+    (void) base[offset];
+  }
+  if (length > 0)
+    (void) base[length - 1];
+}
+
+/// Pins [addr, addr + length) in RAM, throws std::system_error on failure.
+inline void lock_pages(void *addr, const std::size_t length) {
+#if defined(_WIN32)
+  if (!VirtualLock(addr, length))
+    throw std::system_error(static_cast<int>(GetLastError()),
+                            std::system_category(), "VirtualLock()");
+#else
+  if (mlock(addr, length) != 0)
+    throw std::system_error(errno, std::generic_category(), "mlock()");
+#endif
+}
+
+inline std::uint64_t current_pid() {
+#if defined(_WIN32)
+  return GetCurrentProcessId();
+#else
+  return static_cast<std::uint64_t>(getpid());
+#endif
+}
+
+/// Whether the process that registered itself with pid is still running, used
+/// to reclaim endpoint slots of processes that crashed.
+inline bool process_alive(const std::uint64_t pid) {
+#if defined(_WIN32)
+  const HANDLE process =
+      OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+  if (process == nullptr)
+    return false;
+  const bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+  CloseHandle(process);
+  return alive;
+#else
+  return kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+#endif
+}
+
+/// Nanoseconds since the Unix epoch from the cheapest clock available, a few
+/// ms coarse on Linux.
+inline std::int64_t coarse_epoch_ns() {
+#if defined(CLOCK_REALTIME_COARSE)
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+  return static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+#else
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(system_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/// The writer side of one EndpointStats line, does nothing until attach()ed.
+/// Must be used by the line's endpoint only.
+class StatsRecorder {
+  EndpointStats *m_line = nullptr;
+  // getpid() is a real syscall, so it is only asked once
+  std::uint64_t m_pid = 0;
+  bool m_pid_published = false;
+  // The last operation stalled, stamp the next message
+  bool m_stalled = true;
+
+  template <typename T> static void put(T &field, const T value) {
+    std::atomic_ref(field).store(value, std::memory_order_relaxed);
+  }
+
+public:
+  void attach(EndpointStats *line) {
+    m_line = line;
+    m_pid = current_pid();
+    m_pid_published = false;
+  }
+
+  void record(const std::uint64_t messages, const std::uint64_t bytes) {
+    if (m_line == nullptr)
+      return;
+    // The only writer, so plain reads of our own fields are up to date
+    const std::uint64_t total = m_line->messages + messages;
+    put(m_line->messages, total);
+    put(m_line->bytes, m_line->bytes + bytes);
+    if (m_stalled || total % 16 < messages) {
+      put(m_line->last_active_ns, coarse_epoch_ns());
+      m_stalled = false;
+    }
+    // Both lines are attached in every process, only the endpoint that
+    // actually moves messages claims its line
+    if (!m_pid_published) {
+      put(m_line->pid, m_pid);
+      m_pid_published = true;
+    }
+  }
+
+  void record_stall() {
+    if (m_line == nullptr)
+      return;
+    put(m_line->stalls, m_line->stalls + 1);
+    m_stalled = true;
+  }
+
+  void record_used(const std::uint64_t used_bytes) {
+    if (m_line != nullptr && used_bytes > m_line->high_water)
+      put(m_line->high_water, used_bytes);
+  }
+};
+
+inline void publish_header(void *segment_base, const SegmentKind kind,
+                           const std::uint64_t header_size,
+                           const std::uint64_t queue_size,
+                           const std::uint64_t params0 = 0,
+                           const std::uint64_t params1 = 0,
+                           const std::uint64_t params2 = 0) {
+  using namespace std::chrono;
+  const auto header = static_cast<SegmentHeader *>(segment_base);
+  header->version = SegmentHeader::VERSION;
+  header->kind = kind;
+  header->header_size = header_size;
+  header->queue_size = queue_size;
+  header->creation_epoch_ns =
+      duration_cast<nanoseconds>(system_clock::now().time_since_epoch())
+          .count();
+  header->params[0] = params0;
+  header->params[1] = params1;
+  header->params[2] = params2;
+  std::atomic_ref(header->magic)
+      .store(SegmentHeader::MAGIC, std::memory_order_release);
+}
+
+/// Validates the header of an attached segment, throws std::runtime_error if
+/// the segment was not (fully) created by a compatible owner.
+inline const SegmentHeader &read_header(const void *segment_base,
+                                        const std::size_t mapped_size,
+                                        const SegmentKind kind,
+                                        const std::string &name) {
+  if (mapped_size < sizeof(SegmentHeader))
+    throw std::runtime_error("Shared memory segment [" + name +
+                             "] is too small to hold a header");
+  const auto header = static_cast<const SegmentHeader *>(segment_base);
+  if (std::atomic_ref(const_cast<std::uint64_t &>(header->magic))
+        .load(std::memory_order_acquire) != SegmentHeader::MAGIC)
+    throw std::runtime_error("Shared memory segment [" + name +
+                             "] is not initialized by its owner");
+  if (header->version != SegmentHeader::VERSION || header->kind != kind)
+    throw std::runtime_error("Shared memory segment [" + name +
+                             "] has an incompatible version or kind");
+  if (header->header_size + header->queue_size > mapped_size)
+    throw std::runtime_error("Shared memory segment [" + name +
+                             "] is smaller than its header claims");
+  return *header;
+}
+} // namespace RingBuffer::Interprocess
+
+#endif // INTERPROCESS_SEGMENT_HEADER_H
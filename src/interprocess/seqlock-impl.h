@@ -0,0 +1,210 @@
+#ifndef INTERPROCESS_SEQLOCK_IMPL_H
+#define INTERPROCESS_SEQLOCK_IMPL_H
+
+#include "../detail/seqlock.h"
+#include "../ringbuffer-interface.h"
+#include "segment-header.h"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+/* Seqlocked "latest value" slots in shared memory, see
+ * Intraprocess::Seqlock for the semantics and detail/seqlock.h for the
+ * protocol:
+ *
+ *   +---------------+------------------+------------------+-----+
+ *   | SegmentHeader | slot 0           | slot 1           | ... |
+ *   |               | {seq, words}     | {seq, words}     |     |
+ *   +---------------+------------------+------------------+-----+
+ *
+ * Every slot starts on its own cache line. The header records the slot
+ * count and sizeof(T), so an attacher built with a different T is rejected.
+ * T must be trivially copyable and must not hold pointers, they would not
+ * mean anything in the other process.
+ */
+namespace RingBuffer::Interprocess {
+
+/// An array of independently seqlocked slots, e.g., one per instrument id.
+/// Each key has at most one writer at a time, in any process.
+template <typename T> class KeyedSeqlock {
+private:
+  using Slot = Detail::SeqlockSlot<T>;
+  static constexpr int m_header_size = sizeof(SegmentHeader);
+
+  std::uint64_t m_slot_count = 0;
+  char *m_base_ptr = nullptr;
+  bool m_ownership;
+  std::string m_mapped_file_name;
+  size_t m_total_size = 0;
+  std::unique_ptr<boost::interprocess::shared_memory_object> m_shm_obj;
+  std::unique_ptr<boost::interprocess::mapped_region> m_region;
+
+  [[nodiscard]] Slot &slot(const std::size_t key) const {
+    if (key >= m_slot_count)
+      throw std::out_of_range("KeyedSeqlock key out of range");
+    return reinterpret_cast<Slot *>(m_base_ptr + m_header_size)[key];
+  }
+
+  void map_region(const SegmentOptions &options) {
+    namespace bip = boost::interprocess;
+    m_region =
+        std::make_unique<bip::mapped_region>(*m_shm_obj, bip::read_write);
+    m_base_ptr = static_cast<char *>(m_region->get_address());
+    m_total_size = m_region->get_size();
+    if (options.lock_pages)
+      lock_pages(m_base_ptr, m_total_size);
+    if (options.prefault)
+      prefault(m_base_ptr, m_total_size);
+  }
+
+public:
+  /// @param name name of the shared memory object
+  /// @param ownership the owner creates, initializes and eventually removes
+  /// the segment; other endpoints attach to a segment the owner created
+  /// @param slot_count number of keys, read from the segment header by
+  /// attachers, which may pass 0
+  explicit KeyedSeqlock(const std::string &name, const bool ownership = false,
+                        const std::size_t slot_count = 0,
+                        const SegmentOptions &options = {})
+      : m_ownership(ownership), m_mapped_file_name(name) {
+    namespace bip = boost::interprocess;
+    if (m_ownership) {
+      if (slot_count == 0)
+        throw std::invalid_argument("slot_count must be positive");
+      m_slot_count = slot_count;
+      m_shm_obj = std::make_unique<bip::shared_memory_object>(
+          bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
+      m_shm_obj->truncate(
+          static_cast<long>(m_header_size + sizeof(Slot) * m_slot_count));
+      map_region(options);
+      std::memset(m_base_ptr, 0, m_total_size);
+      publish_header(m_base_ptr, SegmentKind::Seqlock, m_header_size,
+                     sizeof(Slot) * m_slot_count, m_slot_count, sizeof(T));
+      return;
+    }
+
+    m_shm_obj = std::make_unique<bip::shared_memory_object>(
+        bip::open_only, m_mapped_file_name.c_str(), bip::read_write);
+    map_region(options);
+    const auto &header =
+        read_header(m_base_ptr, m_total_size, SegmentKind::Seqlock, name);
+    if (header.header_size != m_header_size || header.params[1] != sizeof(T))
+      throw std::runtime_error("[" + name +
+                               "] holds values of a different type");
+    m_slot_count = header.params[0];
+    if (slot_count > 0 && slot_count != m_slot_count)
+      throw std::runtime_error("slot_count does not match [" + name +
+                               "]: " + std::to_string(m_slot_count));
+  }
+
+  // Disable copy operations.
+  KeyedSeqlock(const KeyedSeqlock &) = delete;
+
+  KeyedSeqlock &operator=(const KeyedSeqlock &) = delete;
+
+  ~KeyedSeqlock() { dispose(); }
+
+  void store(const std::size_t key, const T &value) {
+    Detail::seqlock_store(slot(key), value);
+  }
+
+  /// @return false if nothing was published under key yet
+  bool load(const std::size_t key, T &value) const {
+    return Detail::seqlock_load(slot(key), value) != 0;
+  }
+
+  /// Reads the newest value under key if it is newer than last_version, then
+  /// advances last_version to it. Start with last_version = 0.
+  bool load_if_newer(const std::size_t key, T &value,
+                     std::uint64_t &last_version) const {
+    auto &s = slot(key);
+    if (Detail::seqlock_version(s) == last_version)
+      return false;
+    const auto version = Detail::seqlock_load(s, value);
+    if (version == last_version)
+      return false;
+    last_version = version;
+    return true;
+  }
+
+  [[nodiscard]] std::uint64_t version(const std::size_t key) const {
+    return Detail::seqlock_version(slot(key));
+  }
+
+  [[nodiscard]] std::size_t size() const { return m_slot_count; }
+
+  void dispose() {
+    m_region.reset();
+    m_shm_obj.reset();
+    if (m_ownership) {
+      boost::interprocess::shared_memory_object::remove(
+          m_mapped_file_name.c_str());
+    }
+    m_base_ptr = nullptr;
+  }
+};
+
+/// A single conflating slot with the ring buffer interface: enqueue() never
+/// fails or waits, dequeue() returns true once per new value.
+template <typename T>
+class Seqlock : public IRingBuffer<Seqlock<T>, T> {
+private:
+  KeyedSeqlock<T> m_slots;
+  // Version last handed out by dequeue()
+  std::uint64_t m_dequeued_version = 0;
+
+public:
+  /// @param name name of the shared memory object
+  /// @param ownership the owner creates, initializes and eventually removes
+  /// the segment; other endpoints attach to a segment the owner created
+  explicit Seqlock(const std::string &name, const bool ownership = false,
+                   const SegmentOptions &options = {})
+      : m_slots(name, ownership, ownership ? 1 : 0, options) {
+    if (m_slots.size() != 1)
+      throw std::runtime_error("[" + name + "] is a KeyedSeqlock");
+  }
+
+  template <typename U>
+    requires std::assignable_from<T &, U>
+  bool enqueue_impl(U &&item) {
+    if constexpr (std::is_same_v<std::remove_cvref_t<U>, T>) {
+      m_slots.store(0, item);
+    } else {
+      T value;
+      value = std::forward<U>(item);
+      m_slots.store(0, value);
+    }
+    return true;
+  }
+
+  bool dequeue_impl(T &item) {
+    return m_slots.load_if_newer(0, item, m_dequeued_version);
+  }
+
+  /// Reads the newest value, false if nothing was published yet.
+  bool load(T &item) const { return m_slots.load(0, item); }
+
+  bool load_if_newer(T &item, std::uint64_t &last_version) const {
+    return m_slots.load_if_newer(0, item, last_version);
+  }
+
+  /// Number of values published so far.
+  [[nodiscard]] std::uint64_t version() const { return m_slots.version(0); }
+
+  [[nodiscard]] int head_impl() const {
+    return static_cast<int>(m_dequeued_version);
+  }
+
+  [[nodiscard]] int tail_impl() const { return static_cast<int>(version()); }
+
+  void dispose() { m_slots.dispose(); }
+};
+} // namespace RingBuffer::Interprocess
+
+#endif // INTERPROCESS_SEQLOCK_IMPL_H
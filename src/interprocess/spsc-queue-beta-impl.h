@@ -2,6 +2,8 @@
 #define INTERPROCESS_SPSC_BETA_QUEUE_IMPL_H
 
 #include "../ringbuffer-interface.h"
+#include "byte-sequence.h"
+#include "segment-header.h"
 
 #include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/shared_memory_object.hpp>
@@ -10,13 +12,19 @@
 #include <chrono>
 #include <cstring>
 #include <memory>
+#include <span>
 #include <string>
 
 namespace RingBuffer::Interprocess {
   class SpscQueueBeta : public IRingBuffer<SpscQueueBeta, std::string> {
   private:
     static constexpr int FLAG_WRAPPED = -1;
-    static constexpr int m_header_size = sizeof(int) * 2;
+    static constexpr int DEFAULT_QUEUE_SIZE = 1000;
+    // SegmentHeader, then head and tail on the next cache line, then the
+    // payload area
+    static constexpr int m_head_offset = sizeof(SegmentHeader);
+    static constexpr int m_tail_offset = m_head_offset + sizeof(int);
+    static constexpr int m_header_size = sizeof(SegmentHeader) * 2;
     int m_queue_size;
     // const int m_max_msg_size;
     // int m_max_element_size;
@@ -27,30 +35,76 @@ namespace RingBuffer::Interprocess {
     std::unique_ptr<boost::interprocess::shared_memory_object> m_shm_obj;
     std::unique_ptr<boost::interprocess::mapped_region> m_region;
 
-  public:
-    explicit SpscQueueBeta(const std::string &queue_name,
-                           const bool ownership = false,
-                           const int queue_size_bytes = 1000)
-      : m_ownership(ownership), m_mapped_file_name(queue_name) {
-      m_queue_size = queue_size_bytes;
-      // header + queue payload area.
-      m_total_size = m_header_size + m_queue_size;
-      // Use Boost.Interprocess to open (or create) and map the memory.
+    void map_region(const SegmentOptions &options) {
       namespace bip = boost::interprocess;
-
-      m_shm_obj = std::make_unique<bip::shared_memory_object>(
-        bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
-      // Resize the shared memory object.
-      m_shm_obj->truncate(static_cast<long>(m_total_size));
       // Map the entire shared memory object into the process's address space.
       m_region =
           std::make_unique<bip::mapped_region>(*m_shm_obj, bip::read_write);
       m_base_ptr = static_cast<char *>(m_region->get_address());
+      m_total_size = m_region->get_size();
+      if (options.lock_pages)
+        lock_pages(m_base_ptr, m_total_size);
+      // Each process has its own page tables, so every endpoint must fault in
+      // its own view to keep page faults off the first lap of the ring
+      if (options.prefault)
+        prefault(m_base_ptr, m_total_size);
+    }
+
+  public:
+    /// @param queue_name name of the shared memory object
+    /// @param ownership the owner creates, initializes and eventually removes
+    /// the segment; other endpoints attach to a segment the owner created
+    /// @param queue_size_bytes size of the payload area. Attachers may pass 0
+    /// to read it from the segment header, a non-zero value that differs from
+    /// the header is rejected
+    /// @param options prefault/mlock settings of this process's mapping,
+    /// record_alignment is not supported and must stay 1
+    explicit SpscQueueBeta(const std::string &queue_name,
+                           const bool ownership = false,
+                           const int queue_size_bytes = 0,
+                           const SegmentOptions &options = {})
+        : m_ownership(ownership), m_mapped_file_name(queue_name) {
+      // Use Boost.Interprocess to open (or create) and map the memory.
+      namespace bip = boost::interprocess;
 
-      // If this process "owns" the queue, initialize it.
       if (m_ownership) {
+        if (options.record_alignment != 1)
+          throw std::invalid_argument(
+              "SpscQueueBeta only supports packed records");
+        m_queue_size =
+            queue_size_bytes > 0 ? queue_size_bytes : DEFAULT_QUEUE_SIZE;
+        // header + queue payload area.
+        m_total_size = m_header_size + m_queue_size;
+        m_shm_obj = std::make_unique<bip::shared_memory_object>(
+            bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
+        // Resize the shared memory object.
+        m_shm_obj->truncate(static_cast<long>(m_total_size));
+        map_region(options);
         std::memset(m_base_ptr, 0, m_total_size);
+        publish_header(m_base_ptr, SegmentKind::SpscQueue, m_header_size,
+                       m_queue_size);
+        return;
       }
+
+      // Attachers never create the segment, its geometry comes from the header
+      m_shm_obj = std::make_unique<bip::shared_memory_object>(
+          bip::open_only, m_mapped_file_name.c_str(), bip::read_write);
+      map_region(options);
+      const auto &header = read_header(m_base_ptr, m_total_size,
+                                       SegmentKind::SpscQueue, queue_name);
+      if (header.header_size != m_header_size)
+        throw std::runtime_error("Unexpected header size of [" + queue_name +
+                                 "]");
+      // Only SpscQueue speaks the aligned record layout
+      if (header.params[0] > 1)
+        throw std::runtime_error("[" + queue_name +
+                                 "] uses aligned records, attach with "
+                                 "SpscQueue instead");
+      m_queue_size = static_cast<int>(header.queue_size);
+      if (queue_size_bytes > 0 && queue_size_bytes != m_queue_size)
+        throw std::runtime_error(
+            "queue_size_bytes does not match the size of [" + queue_name +
+            "]: " + std::to_string(m_queue_size));
     }
 
     // Disable copy operations.
@@ -62,13 +116,12 @@ namespace RingBuffer::Interprocess {
 
     // Enqueues a message.
     // we cant std::move() in this case
-    template<typename U>
-      requires std::assignable_from<std::string &, U>
-    bool enqueue_impl(U &&msg_bytes) {
-      const int msg_length = static_cast<int>(msg_bytes.size());
+    template<ByteSequence U> bool enqueue_impl(U &&msg_bytes) {
+      const auto bytes = as_byte_span(msg_bytes);
+      const int msg_length = static_cast<int>(bytes.size());
       const int element_length = sizeof(int) + msg_length;
-      const auto head_ptr = reinterpret_cast<int *>(m_base_ptr);
-      const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + sizeof(int));
+      const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
+      const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
       // i.e. the base address of data segment
       char *data_base = m_base_ptr + m_header_size;
 
@@ -84,9 +137,20 @@ namespace RingBuffer::Interprocess {
         return false;
       }
 
+      // Wrap under the same rule the consumer applies in dequeue_impl()
+      const bool wraps = tail + static_cast<int>(sizeof(int)) >= m_queue_size ||
+                         tail + element_length > m_queue_size;
+      // A wrapping record also uses up the bytes it skips at the end of the
+      // ring, and no record may reach head, or the queue would look empty
+      const int needed =
+          wraps ? m_queue_size - tail + element_length : element_length;
+      if (needed >= m_queue_size - used) {
+        return false;
+      }
+
       int msg_offset = tail;
       // If the message record would not fit contiguously, write a wrap marker.
-      if (msg_offset + element_length > m_queue_size) {
+      if (wraps) {
         if (m_queue_size - msg_offset >= static_cast<int>(sizeof(int))) {
           *reinterpret_cast<int *>(data_base + msg_offset) = FLAG_WRAPPED;
         }
@@ -97,7 +161,7 @@ namespace RingBuffer::Interprocess {
       // are not atomic
       *reinterpret_cast<int *>(data_base + msg_offset) = msg_length;
       // Write the payload first.
-      std::memcpy(data_base + msg_offset + sizeof(int), msg_bytes.data(),
+      std::memcpy(data_base + msg_offset + sizeof(int), bytes.data(),
                   msg_length);
       /*
         const std::atomic_ref length_atomic(
@@ -115,8 +179,8 @@ namespace RingBuffer::Interprocess {
     }
 
     bool dequeue_impl(std::string &buffer) const {
-      const auto head_ptr = reinterpret_cast<int *>(m_base_ptr);
-      const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + sizeof(int));
+      const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
+      const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
       // i.e. the base address of data segment
       char *queue_base = m_base_ptr + m_header_size;
 
@@ -157,16 +221,64 @@ namespace RingBuffer::Interprocess {
       return true;
     }
 
+    // Hands up to max_items messages to fn in place, then releases them all
+    // with a single head store.
+    template <typename F>
+    std::size_t consume_up_to_impl(const std::size_t max_items, F &&fn) const {
+      const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
+      const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
+      char *queue_base = m_base_ptr + m_header_size;
+
+      const std::atomic_ref head_atomic(*head_ptr);
+      const std::atomic_ref tail_atomic(*tail_ptr);
+      int head = head_atomic.load(std::memory_order_relaxed);
+      const int tail = tail_atomic.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      std::size_t count = 0;
+      while (head != tail && count < max_items) {
+        int msg_length = 0;
+        if (head + static_cast<int>(sizeof(msg_length)) < m_queue_size)
+          msg_length = *reinterpret_cast<int *>(queue_base + head);
+        if (head + static_cast<int>(sizeof(msg_length)) >= m_queue_size ||
+            msg_length == FLAG_WRAPPED) {
+          head = 0;
+          msg_length = *reinterpret_cast<int *>(queue_base + head);
+        }
+        try {
+          fn(std::span<const std::byte>(
+              reinterpret_cast<const std::byte *>(queue_base + head +
+                                                  sizeof(int)),
+              msg_length));
+        } catch (...) {
+          std::atomic_thread_fence(std::memory_order_release);
+          head_atomic.store(head, std::memory_order_relaxed);
+          throw;
+        }
+        head += static_cast<int>(sizeof(msg_length)) + msg_length;
+        if (head >= m_queue_size)
+          head = 0;
+        ++count;
+      }
+      if (count > 0) {
+        std::atomic_thread_fence(std::memory_order_release);
+        head_atomic.store(head, std::memory_order_relaxed);
+      }
+      return count;
+    }
+
     // Returns the number of used bytes in the queue. If head or tail is not
     // provided, they are re-read.
     [[nodiscard]] int get_used_bytes(int head = -1, int tail = -1) const {
       if (head == -1) {
-        const auto head_ptr = reinterpret_cast<int *>(m_base_ptr);
+        const auto head_ptr =
+            reinterpret_cast<int *>(m_base_ptr + m_head_offset);
         const std::atomic_ref head_atomic(*head_ptr);
         head = head_atomic.load(std::memory_order_acquire);
       }
       if (tail == -1) {
-        const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + sizeof(int));
+        const auto tail_ptr =
+            reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
         const std::atomic_ref tail_atomic(*tail_ptr);
         tail = tail_atomic.load(std::memory_order_relaxed);
       }
@@ -175,14 +287,19 @@ namespace RingBuffer::Interprocess {
       return m_queue_size - (head - tail);
     }
 
+    /// The self-describing header written by the owner.
+    [[nodiscard]] const SegmentHeader &header() const {
+      return *reinterpret_cast<const SegmentHeader *>(m_base_ptr);
+    }
+
     [[nodiscard]] int head_impl() const {
-      const auto head_ptr = reinterpret_cast<int *>(m_base_ptr);
+      const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
       const std::atomic_ref head_atomic(*head_ptr);
       return head_atomic.load(std::memory_order_relaxed);
     }
 
     [[nodiscard]] int tail_impl() const {
-      const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + sizeof(int));
+      const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
       const std::atomic_ref tail_atomic(*tail_ptr);
       return tail_atomic.load(std::memory_order_relaxed);
     }
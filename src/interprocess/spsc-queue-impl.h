@@ -1,16 +1,22 @@
 #ifndef INTERPROCESS_SPSC_QUEUE_IMPL_H
 #define INTERPROCESS_SPSC_QUEUE_IMPL_H
 
+#include "../detail/sojourn.h"
 #include "../ringbuffer-interface.h"
+#include "byte-sequence.h"
+#include "segment-header.h"
 
 #include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/shared_memory_object.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <thread>
 
@@ -18,8 +24,28 @@ namespace RingBuffer::Interprocess {
 class SpscQueue : public RingBuffer::IRingBuffer<SpscQueue, std::string> {
 private:
   static constexpr int FLAG_WRAPPED = -1;
-  static constexpr int m_header_size = sizeof(int) * 2;
+  static constexpr int DEFAULT_QUEUE_SIZE = 1000;
+  // SegmentHeader, then head and tail on the next cache line, then the
+  // optional SegmentStats and Detail::SojournLog, then the payload area
+  static constexpr int m_head_offset = sizeof(SegmentHeader);
+  static constexpr int m_tail_offset = m_head_offset + sizeof(int);
+  static constexpr int BASE_HEADER_SIZE = sizeof(SegmentHeader) * 2;
+  std::uint64_t m_header_size = BASE_HEADER_SIZE;
+  // Aligned records carry an 8-byte header (length word + padding), so that
+  // payloads start 8-byte aligned
+  static constexpr int ALIGNED_RECORD_HEADER = 8;
   int m_queue_size;
+  // 1 for the packed legacy layout, otherwise 8 or 64, see enqueue_aligned()
+  int m_record_alignment = 1;
+  // Per-endpoint payload copy kernels, see SegmentOptions::copy
+  PayloadCopier m_copier;
+  bool m_prefetch_next = false;
+  // No-ops unless the segment has a SegmentStats region. The consumer's is
+  // mutable like the rest of its const dequeue path
+  StatsRecorder m_producer_stats;
+  mutable StatsRecorder m_consumer_stats;
+  // nullptr unless the owner enabled sojourn sampling
+  Detail::SojournLog *m_sojourn = nullptr;
   // const int m_max_msg_size;
   // int m_max_element_size;
   char *m_base_ptr = nullptr;
@@ -29,30 +55,298 @@ private:
   std::unique_ptr<boost::interprocess::shared_memory_object> m_shm_obj;
   std::unique_ptr<boost::interprocess::mapped_region> m_region;
 
-public:
-  explicit SpscQueue(const std::string &queue_name,
-                     const bool ownership = false,
-                     const int queue_size_bytes = 1000)
-      : m_ownership(ownership), m_mapped_file_name(queue_name) {
-    m_queue_size = queue_size_bytes;
-    // header + queue payload area.
-    m_total_size = m_header_size + m_queue_size;
-    // Use Boost.Interprocess to open (or create) and map the memory.
+  void map_region(const SegmentOptions &options) {
     namespace bip = boost::interprocess;
-
-    m_shm_obj = std::make_unique<bip::shared_memory_object>(
-        bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
-    // Resize the shared memory object.
-    m_shm_obj->truncate(static_cast<long>(m_total_size));
     // Map the entire shared memory object into the process's address space.
     m_region =
         std::make_unique<bip::mapped_region>(*m_shm_obj, bip::read_write);
     m_base_ptr = static_cast<char *>(m_region->get_address());
+    m_total_size = m_region->get_size();
+    if (options.lock_pages)
+      lock_pages(m_base_ptr, m_total_size);
+    // Each process has its own page tables, so every endpoint must fault in
+    // its own view to keep page faults off the first lap of the ring
+    if (options.prefault)
+      prefault(m_base_ptr, m_total_size);
+  }
+
+  void attach_stats(const std::uint64_t stats_offset,
+                    const std::uint64_t sojourn_offset) {
+    if (sojourn_offset != 0)
+      m_sojourn =
+          reinterpret_cast<Detail::SojournLog *>(m_base_ptr + sojourn_offset);
+    if (stats_offset == 0)
+      return;
+    const auto stats =
+        reinterpret_cast<SegmentStats *>(m_base_ptr + stats_offset);
+    m_producer_stats.attach(&stats->producer);
+    m_consumer_stats.attach(&stats->consumer);
+  }
+
+  [[nodiscard]] int aligned_record_size(const int msg_length) const {
+    const int element_length = ALIGNED_RECORD_HEADER + msg_length;
+    return (element_length + m_record_alignment - 1) & -m_record_alignment;
+  }
+
+  // The most records the payload area holds at a time, sizes the sojourn
+  // stamp ring
+  [[nodiscard]] std::uint64_t max_messages() const {
+    const int smallest = m_record_alignment > 1
+                             ? aligned_record_size(0)
+                             : static_cast<int>(sizeof(int));
+    return static_cast<std::uint64_t>(m_queue_size) / smallest;
+  }
+
+  /* Aligned records (record_alignment of 8 or 64) start on a multiple of the
+   * alignment and the queue size is a multiple of it too, so a wrap marker
+   * always fits before the end of the ring:
+   *
+   *   +-------------+---------+---------+---------------+---------+
+   *   | length word | padding | payload | padding       | next... |
+   *   | (int)       | to 8    |         | to alignment  |         |
+   *   +-------------+---------+---------+---------------+---------+
+   *
+   * The length word holds ALIGNED_RECORD_HEADER + payload size (never 0) and
+   * is written with a release store after the payload, a wrapped record is
+   * written before its FLAG_WRAPPED marker. Before that release store the
+   * producer zeroes the length word where the next record will start, which
+   * always lies in free space. A zero length word therefore means "nothing
+   * published yet": the consumer never needs to read tail and never writes
+   * into the payload area, stale length words further on are never read.
+   */
+  // Copies every fragment back to back to dst
+  void write_fragments(char *dst, const Fragments fragments) const {
+    for (const auto &fragment : fragments) {
+      m_copier.to_shm(dst, fragment.data(), fragment.size());
+      dst += fragment.size();
+    }
+  }
+
+  bool enqueue_aligned(const Fragments fragments, const int msg_length) {
+    const int record_size = aligned_record_size(msg_length);
+    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
+    const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
+    char *data_base = m_base_ptr + m_header_size;
+
+    const std::atomic_ref head_atomic(*head_ptr);
+    const std::atomic_ref tail_atomic(*tail_ptr);
+    const int head = head_atomic.load(std::memory_order_acquire);
+    // Only the producer writes tail
+    const int tail = tail_atomic.load(std::memory_order_relaxed);
+
+    const bool wraps = tail + record_size > m_queue_size;
+    const int needed = wraps ? m_queue_size - tail + record_size : record_size;
+    // Keep at least one unit free so that head == tail still means empty
+    const int used = get_used_bytes(head, tail);
+    if (needed >= m_queue_size - used) {
+      m_producer_stats.record_stall();
+      return false;
+    }
+
+    const int msg_offset = wraps ? 0 : tail;
+    int new_tail = msg_offset + record_size;
+    if (new_tail >= m_queue_size)
+      new_tail = 0;
+    if (m_sojourn != nullptr)
+      m_sojourn->on_produced();
+    write_fragments(data_base + msg_offset + ALIGNED_RECORD_HEADER, fragments);
+    // The unit kept free guarantees new_tail is not the consumer's head
+    std::atomic_ref(*reinterpret_cast<int *>(data_base + new_tail))
+        .store(0, std::memory_order_relaxed);
+    std::atomic_ref(*reinterpret_cast<int *>(data_base + msg_offset))
+        .store(ALIGNED_RECORD_HEADER + msg_length, std::memory_order_release);
+    if (wraps) {
+      std::atomic_ref(*reinterpret_cast<int *>(data_base + tail))
+          .store(FLAG_WRAPPED, std::memory_order_release);
+    }
+
+    tail_atomic.store(new_tail, std::memory_order_release);
+    m_producer_stats.record(1, msg_length);
+    m_producer_stats.record_used(used + needed);
+    return true;
+  }
+
+  bool dequeue_aligned(std::string &buffer) const {
+    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
+    char *queue_base = m_base_ptr + m_header_size;
+
+    const std::atomic_ref head_atomic(*head_ptr);
+    // Only the consumer writes head
+    int head = head_atomic.load(std::memory_order_relaxed);
+    auto length_at = [queue_base](const int offset) {
+      return std::atomic_ref(*reinterpret_cast<int *>(queue_base + offset));
+    };
+
+    int element_length = length_at(head).load(std::memory_order_acquire);
+    if (element_length == 0) {
+      // Nothing published at head yet
+      m_consumer_stats.record_stall();
+      return false;
+    }
+    if (element_length == FLAG_WRAPPED) {
+      head = 0;
+      // The record was released before its wrap marker
+      element_length = length_at(head).load(std::memory_order_acquire);
+    }
+
+    const int msg_length = element_length - ALIGNED_RECORD_HEADER;
+    const int record_size = aligned_record_size(msg_length);
+    int new_head = head + record_size;
+    if (new_head >= m_queue_size)
+      new_head = 0;
+    // Overlap the miss on the next length word with the copy below
+    if (m_prefetch_next)
+      prefetch_read(queue_base + new_head);
+    buffer.resize(msg_length);
+    m_copier.from_shm(buffer.data(), queue_base + head + ALIGNED_RECORD_HEADER,
+                      msg_length);
+
+    release_consumed(new_head, 1, msg_length);
+    return true;
+  }
+
+  template <typename F>
+  std::size_t consume_aligned(const std::size_t max_items, F &fn) const {
+    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
+    char *queue_base = m_base_ptr + m_header_size;
+    const std::atomic_ref head_atomic(*head_ptr);
+    int head = head_atomic.load(std::memory_order_relaxed);
+    auto length_at = [queue_base](const int offset) {
+      return std::atomic_ref(*reinterpret_cast<int *>(queue_base + offset));
+    };
+
+    std::size_t count = 0;
+    std::uint64_t bytes = 0;
+    while (count < max_items) {
+      int element_length = length_at(head).load(std::memory_order_acquire);
+      if (element_length == 0)
+        break;
+      if (element_length == FLAG_WRAPPED) {
+        head = 0;
+        element_length = length_at(head).load(std::memory_order_acquire);
+      }
+      const int msg_length = element_length - ALIGNED_RECORD_HEADER;
+      const int record_size = aligned_record_size(msg_length);
+      try {
+        fn(std::span<const std::byte>(reinterpret_cast<const std::byte *>(
+                                          queue_base + head +
+                                          ALIGNED_RECORD_HEADER),
+                                      msg_length));
+      } catch (...) {
+        release_consumed(head, count, bytes);
+        throw;
+      }
+      head += record_size;
+      if (head >= m_queue_size)
+        head = 0;
+      ++count;
+      bytes += msg_length;
+    }
+    if (count > 0)
+      release_consumed(head, count, bytes);
+    else
+      m_consumer_stats.record_stall();
+    return count;
+  }
+
+  // Hands the count messages taken up to head back to the producer
+  void release_consumed(const int head, const std::size_t count,
+                     const std::uint64_t bytes) const {
+    // Before releasing, so the producer cannot reuse a sampled stamp
+    if (m_sojourn != nullptr)
+      m_sojourn->on_consumed(count);
+    std::atomic_ref(*reinterpret_cast<int *>(m_base_ptr + m_head_offset))
+        .store(head, std::memory_order_release);
+    m_consumer_stats.record(count, bytes);
+  }
+
+public:
+  /// @param queue_name name of the shared memory object
+  /// @param ownership the owner creates, initializes and eventually removes
+  /// the segment; other endpoints attach to a segment the owner created
+  /// @param queue_size_bytes size of the payload area. Attachers may pass 0 to
+  /// read it from the segment header, a non-zero value that differs from the
+  /// header is rejected
+  /// @param options prefault/mlock settings of this process's mapping and
+  /// its payload copy kernels. The owner's record_alignment (1, 8 or 64)
+  /// selects the record layout, the owner rounds queue_size_bytes down to a
+  /// multiple of it
+  explicit SpscQueue(const std::string &queue_name,
+                     const bool ownership = false,
+                     const int queue_size_bytes = 0,
+                     const SegmentOptions &options = {})
+      : m_copier(options.copy), m_prefetch_next(options.copy.prefetch_next),
+        m_ownership(ownership), m_mapped_file_name(queue_name) {
+    // Use Boost.Interprocess to open (or create) and map the memory.
+    namespace bip = boost::interprocess;
 
-    // If this process "owns" the queue, initialize it.
     if (m_ownership) {
+      m_record_alignment = options.record_alignment;
+      if (m_record_alignment != 1 && m_record_alignment != 8 &&
+          m_record_alignment != 64)
+        throw std::invalid_argument("record_alignment must be 1, 8 or 64");
+      m_queue_size =
+          queue_size_bytes > 0 ? queue_size_bytes : DEFAULT_QUEUE_SIZE;
+      m_queue_size -= m_queue_size % m_record_alignment;
+      if (m_record_alignment > 1 && m_queue_size < 2 * m_record_alignment)
+        throw std::invalid_argument(
+            "queue_size_bytes must hold at least two aligned records");
+      const std::uint64_t stats_offset = options.stats ? m_header_size : 0;
+      if (options.stats)
+        m_header_size += sizeof(SegmentStats);
+      const std::uint64_t sojourn_offset =
+          options.sojourn_sample_every > 0 ? m_header_size : 0;
+      if (sojourn_offset != 0)
+        m_header_size += Detail::SojournLog::size_for(
+            max_messages(), options.sojourn_sample_every);
+      // header + queue payload area.
+      m_total_size = m_header_size + m_queue_size;
+      m_shm_obj = std::make_unique<bip::shared_memory_object>(
+          bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
+      // Resize the shared memory object.
+      m_shm_obj->truncate(static_cast<long>(m_total_size));
+      map_region(options);
       std::memset(m_base_ptr, 0, m_total_size);
+      if (sojourn_offset != 0)
+        reinterpret_cast<Detail::SojournLog *>(m_base_ptr + sojourn_offset)
+            ->init(max_messages(), options.sojourn_sample_every);
+      // params[1] and params[2] locate the stats and the sojourn region, 0 if
+      // there is none
+      publish_header(m_base_ptr, SegmentKind::SpscQueue, m_header_size,
+                     m_queue_size, m_record_alignment, stats_offset,
+                     sojourn_offset);
+      attach_stats(stats_offset, sojourn_offset);
+      return;
     }
+
+    // Attachers never create the segment, its geometry comes from the header
+    m_shm_obj = std::make_unique<bip::shared_memory_object>(
+        bip::open_only, m_mapped_file_name.c_str(), bip::read_write);
+    map_region(options);
+    const auto &header = read_header(m_base_ptr, m_total_size,
+                                     SegmentKind::SpscQueue, queue_name);
+    m_queue_size = static_cast<int>(header.queue_size);
+    // Segments created before record alignment existed store 0 here
+    m_record_alignment = std::max(static_cast<int>(header.params[0]), 1);
+    if (header.params[1] != 0)
+      m_header_size += sizeof(SegmentStats);
+    if (header.params[2] != 0) {
+      if (header.params[2] + sizeof(Detail::SojournLog) > header.header_size)
+        throw std::runtime_error("Unexpected header size of [" + queue_name +
+                                 "]");
+      // The owner sized the stamp ring from the same geometry
+      const auto log = reinterpret_cast<const Detail::SojournLog *>(
+          m_base_ptr + header.params[2]);
+      m_header_size += Detail::SojournLog::size_for(max_messages(), log->every);
+    }
+    if (header.header_size != m_header_size)
+      throw std::runtime_error("Unexpected header size of [" + queue_name +
+                               "]");
+    if (queue_size_bytes > 0 && queue_size_bytes != m_queue_size)
+      throw std::runtime_error(
+          "queue_size_bytes does not match the size of [" + queue_name +
+          "]: " + std::to_string(m_queue_size));
+    attach_stats(header.params[1], header.params[2]);
   }
 
   // Disable copy operations.
@@ -64,13 +358,25 @@ public:
 
   // Enqueues a message.
   // we cant std::move() in this case
-  template <typename U>
-    requires std::assignable_from<std::string &, U>
-  bool enqueue_impl(U &&msg_bytes) {
-    const int msg_length = static_cast<int>(msg_bytes.size());
+  template <ByteSequence U> bool enqueue_impl(U &&msg_bytes) {
+    const std::span<const std::byte> fragment = as_byte_span(msg_bytes);
+    return enqueue_gather({&fragment, 1});
+  }
+
+  /// Enqueues the concatenation of fragments as one message, e.g., a header,
+  /// a body and a trailer, without assembling it in a temporary first.
+  /// @return true if the message was enqueued, false if the queue is full
+  bool enqueue_gather(const Fragments fragments) {
+    std::size_t total_length = 0;
+    for (const auto &fragment : fragments) {
+      total_length += fragment.size();
+    }
+    const int msg_length = static_cast<int>(total_length);
+    if (m_record_alignment > 1)
+      return enqueue_aligned(fragments, msg_length);
     const int element_length = sizeof(int) + msg_length;
-    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr);
-    const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + sizeof(int));
+    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
+    const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
     // i.e. the base address of data segment
     char *data_base = m_base_ptr + m_header_size;
 
@@ -84,12 +390,25 @@ public:
     const int used = get_used_bytes(head, tail);
     if (const int free = m_queue_size - used;
         free < element_length + msg_length) {
+      m_producer_stats.record_stall();
+      return false;
+    }
+
+    // Wrap under the same rule the consumer applies in dequeue_impl()
+    const bool wraps = tail + static_cast<int>(sizeof(int)) >= m_queue_size ||
+                       tail + element_length > m_queue_size;
+    // A wrapping record also uses up the bytes it skips at the end of the
+    // ring, and no record may reach head, or the queue would look empty
+    const int needed =
+        wraps ? m_queue_size - tail + element_length : element_length;
+    if (needed >= m_queue_size - used) {
+      m_producer_stats.record_stall();
       return false;
     }
 
     int msg_offset = tail;
     // If the message record would not fit contiguously, write a wrap marker.
-    if (msg_offset + element_length > m_queue_size) {
+    if (wraps) {
       if (m_queue_size - msg_offset >= static_cast<int>(sizeof(int))) {
         *reinterpret_cast<int *>(data_base + msg_offset) = FLAG_WRAPPED;
       }
@@ -100,8 +419,7 @@ public:
     // are not atomic
     *reinterpret_cast<int *>(data_base + msg_offset) = msg_length;
     // Write the payload first.
-    std::memcpy(data_base + msg_offset + sizeof(int), msg_bytes.data(),
-                msg_length);
+    write_fragments(data_base + msg_offset + sizeof(int), fragments);
     /*
       const std::atomic_ref length_atomic(
           *reinterpret_cast<int *>(data_base + msg_offset));
@@ -111,14 +429,20 @@ public:
     int new_tail = msg_offset + element_length;
     if (new_tail >= m_queue_size)
       new_tail = 0;
+    if (m_sojourn != nullptr)
+      m_sojourn->on_produced();
     tail_atomic.store(new_tail, std::memory_order_release);
+    m_producer_stats.record(1, msg_length);
+    m_producer_stats.record_used(used + needed);
 
     return true;
   }
 
   bool dequeue_impl(std::string &buffer) const {
-    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr);
-    const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + sizeof(int));
+    if (m_record_alignment > 1)
+      return dequeue_aligned(buffer);
+    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
+    const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
     // i.e. the base address of data segment
     char *queue_base = m_base_ptr + m_header_size;
 
@@ -130,6 +454,7 @@ public:
     // on ARM64
     if (const int tail = tail_atomic.load(std::memory_order_acquire);
         head == tail) {
+      m_consumer_stats.record_stall();
       return false; // Queue is empty, no message available.
     }
 
@@ -148,26 +473,97 @@ public:
     if (buffer.size() < static_cast<size_t>(msg_length)) {
       buffer.resize(msg_length);
     }
-    std::memcpy(buffer.data(), queue_base + head + sizeof(int), msg_length);
-
     // Advance the head pointer.
     int new_head = head + static_cast<int>(sizeof(msg_length)) + msg_length;
     if (new_head >= m_queue_size)
       new_head = 0;
-    head_atomic.store(new_head, std::memory_order_release);
+    if (m_prefetch_next)
+      prefetch_read(queue_base + new_head);
+    m_copier.from_shm(buffer.data(), queue_base + head + sizeof(int),
+                      msg_length);
+
+    release_consumed(new_head, 1, msg_length);
     return true;
   }
 
+  /// Hands up to max_items messages to fn as std::span<const std::byte>
+  /// pointing into the ring, then releases them all with a single head store.
+  /// Packed records: only messages published before the call are visited.
+  /// Aligned records are found by polling their length words, so messages
+  /// published during the sweep may be visited too.
+  template <typename F>
+  std::size_t consume_up_to_impl(const std::size_t max_items, F &&fn) const {
+    if (m_record_alignment > 1)
+      return consume_aligned(max_items, fn);
+    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
+    const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
+    char *queue_base = m_base_ptr + m_header_size;
+
+    const std::atomic_ref head_atomic(*head_ptr);
+    const std::atomic_ref tail_atomic(*tail_ptr);
+    // Only the consumer writes head
+    int head = head_atomic.load(std::memory_order_relaxed);
+    const int tail = tail_atomic.load(std::memory_order_acquire);
+
+    std::size_t count = 0;
+    std::uint64_t bytes = 0;
+    while (head != tail && count < max_items) {
+      // Same wrap rule as dequeue_impl()
+      int msg_length = 0;
+      if (head + static_cast<int>(sizeof(msg_length)) < m_queue_size)
+        msg_length = *reinterpret_cast<int *>(queue_base + head);
+      if (head + static_cast<int>(sizeof(msg_length)) >= m_queue_size ||
+          msg_length == FLAG_WRAPPED) {
+        head = 0;
+        msg_length = *reinterpret_cast<int *>(queue_base + head);
+      }
+      const char *payload = queue_base + head + sizeof(int);
+      int new_head = head + static_cast<int>(sizeof(msg_length)) + msg_length;
+      if (new_head >= m_queue_size)
+        new_head = 0;
+      if (m_prefetch_next)
+        prefetch_read(queue_base + new_head);
+      try {
+        fn(std::span<const std::byte>(
+            reinterpret_cast<const std::byte *>(payload), msg_length));
+      } catch (...) {
+        release_consumed(head, count, bytes);
+        throw;
+      }
+      head = new_head;
+      ++count;
+      bytes += msg_length;
+    }
+    if (count > 0)
+      release_consumed(head, count, bytes);
+    else
+      m_consumer_stats.record_stall();
+    return count;
+  }
+
+  /// Counters both endpoints keep in the segment, nullptr unless the owner
+  /// created it with SegmentOptions::stats.
+  [[nodiscard]] const SegmentStats *stats() const {
+    const std::uint64_t offset = header().params[1];
+    if (offset == 0)
+      return nullptr;
+    return reinterpret_cast<const SegmentStats *>(m_base_ptr + offset);
+  }
+
+  /// Sampled sojourn times in TSC ticks, nullptr unless the owner created
+  /// the segment with SegmentOptions::sojourn_sample_every.
+  [[nodiscard]] const Detail::SojournLog *sojourn() const { return m_sojourn; }
+
   // Returns the number of used bytes in the queue. If head or tail is not
   // provided, they are re-read.
   [[nodiscard]] int get_used_bytes(int head = -1, int tail = -1) const {
     if (head == -1) {
-      const auto head_ptr = reinterpret_cast<int *>(m_base_ptr);
+      const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
       const std::atomic_ref head_atomic(*head_ptr);
       head = head_atomic.load(std::memory_order_acquire);
     }
     if (tail == -1) {
-      const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + sizeof(int));
+      const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
       const std::atomic_ref tail_atomic(*tail_ptr);
       tail = tail_atomic.load(std::memory_order_relaxed);
     }
@@ -176,14 +572,22 @@ public:
     return m_queue_size - (head - tail);
   }
 
+  /// 1 for packed records, otherwise the boundary every record is padded to.
+  [[nodiscard]] int record_alignment() const { return m_record_alignment; }
+
+  /// The self-describing header written by the owner.
+  [[nodiscard]] const SegmentHeader &header() const {
+    return *reinterpret_cast<const SegmentHeader *>(m_base_ptr);
+  }
+
   [[nodiscard]] int head_impl() const {
-    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr);
+    const auto head_ptr = reinterpret_cast<int *>(m_base_ptr + m_head_offset);
     const std::atomic_ref head_atomic(*head_ptr);
     return head_atomic.load(std::memory_order_relaxed);
   }
 
   [[nodiscard]] int tail_impl() const {
-    const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + sizeof(int));
+    const auto tail_ptr = reinterpret_cast<int *>(m_base_ptr + m_tail_offset);
     const std::atomic_ref tail_atomic(*tail_ptr);
     return tail_atomic.load(std::memory_order_relaxed);
   }
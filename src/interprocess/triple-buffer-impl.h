@@ -0,0 +1,251 @@
+#ifndef INTERPROCESS_TRIPLE_BUFFER_IMPL_H
+#define INTERPROCESS_TRIPLE_BUFFER_IMPL_H
+
+#include "segment-header.h"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/* The shared memory flavor of Intraprocess::TripleBuffer, for snapshots of up
+ * to buffer_size bytes handed from one writer process to one reader process:
+ *
+ *   +---------------+-------------------------+-----------+-----------+
+ *   | SegmentHeader | state                   | buffer 0  | buffer 1  |
+ *   |               | {back, middle + FRESH,  | {size,    | ...       |
+ *   |               |  front}                 |  bytes}   |           |
+ *   +---------------+-------------------------+-----------+-----------+
+ *
+ * The state word has its own cache line, each buffer starts on its own page.
+ * The writer records how many bytes it filled in the buffer itself before
+ * publish(). Unlike the intraprocess flavor, which exchanges middle and then
+ * stores its own index, all three indices live in the one word and every
+ * hand-over replaces it with a single compare-and-swap. A process killed at
+ * any instruction therefore leaves three distinct buffers behind, and either
+ * side may attach again and carry on with the buffer it owned.
+ */
+namespace RingBuffer::Interprocess {
+
+class TripleBuffer {
+private:
+  static constexpr std::uint64_t INDEX_MASK = 0b011;
+  static constexpr std::uint64_t FRESH = 0b100;
+  // Where back and front sit in the state word, middle is in the low bits
+  static constexpr int BACK_SHIFT = 4;
+  static constexpr int FRONT_SHIFT = 8;
+  static constexpr std::uint64_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+  struct alignas(64) ControlLine {
+    std::uint64_t value;
+  };
+  struct alignas(64) BufferHeader {
+    std::uint64_t size;
+  };
+  static constexpr int m_state_offset = sizeof(SegmentHeader);
+
+  std::uint64_t m_buffer_size = 0;
+  // Distance between two buffers, BufferHeader included, a multiple of the
+  // page size
+  std::uint64_t m_stride = 0;
+  std::uint64_t m_header_size = 0;
+  char *m_base_ptr = nullptr;
+  bool m_ownership;
+  bool m_writer;
+  std::string m_mapped_file_name;
+  size_t m_total_size = 0;
+  std::unique_ptr<boost::interprocess::shared_memory_object> m_shm_obj;
+  std::unique_ptr<boost::interprocess::mapped_region> m_region;
+
+  [[nodiscard]] std::atomic_ref<std::uint64_t> state() const {
+    return std::atomic_ref(
+        reinterpret_cast<ControlLine *>(m_base_ptr + m_state_offset)->value);
+  }
+
+  static std::uint64_t pack(const std::uint64_t back,
+                            const std::uint64_t middle,
+                            const std::uint64_t front) {
+    return back << BACK_SHIFT | middle | front << FRONT_SHIFT;
+  }
+
+  // Each side only reads its own index, which nobody else changes
+  [[nodiscard]] std::uint64_t back_index() const {
+    return state().load(std::memory_order_relaxed) >> BACK_SHIFT & INDEX_MASK;
+  }
+
+  [[nodiscard]] std::uint64_t front_index() const {
+    return state().load(std::memory_order_relaxed) >> FRONT_SHIFT &
+           INDEX_MASK;
+  }
+
+  [[nodiscard]] BufferHeader &buffer(const std::uint64_t idx) const {
+    return *reinterpret_cast<BufferHeader *>(m_base_ptr + m_header_size +
+                                             idx * m_stride);
+  }
+
+  [[nodiscard]] std::byte *buffer_data(const std::uint64_t idx) const {
+    return reinterpret_cast<std::byte *>(&buffer(idx) + 1);
+  }
+
+  void map_region(const SegmentOptions &options) {
+    namespace bip = boost::interprocess;
+    m_region =
+        std::make_unique<bip::mapped_region>(*m_shm_obj, bip::read_write);
+    m_base_ptr = static_cast<char *>(m_region->get_address());
+    m_total_size = m_region->get_size();
+    if (options.lock_pages)
+      lock_pages(m_base_ptr, m_total_size);
+    if (options.prefault)
+      prefault(m_base_ptr, m_total_size);
+  }
+
+  void set_geometry(const std::uint64_t buffer_size) {
+    const std::uint64_t page = page_size();
+    m_buffer_size = buffer_size;
+    m_stride = (sizeof(BufferHeader) + buffer_size + page - 1) / page * page;
+    m_header_size = page;
+  }
+
+public:
+  /// @param name name of the shared memory object
+  /// @param ownership the owner creates, initializes and eventually removes
+  /// the segment; other endpoints attach to a segment the owner created
+  /// @param writer whether this endpoint writes (back(), publish()) or reads
+  /// (refresh(), front()) snapshots, there is one of each
+  /// @param buffer_size_bytes capacity of each of the three buffers, read
+  /// from the segment header by attachers
+  explicit TripleBuffer(const std::string &name, const bool ownership,
+                        const bool writer,
+                        const std::size_t buffer_size_bytes = 0,
+                        const SegmentOptions &options = {})
+      : m_ownership(ownership), m_writer(writer), m_mapped_file_name(name) {
+    namespace bip = boost::interprocess;
+    if (m_ownership) {
+      set_geometry(buffer_size_bytes > 0 ? buffer_size_bytes
+                                         : DEFAULT_BUFFER_SIZE);
+      m_shm_obj = std::make_unique<bip::shared_memory_object>(
+          bip::open_or_create, m_mapped_file_name.c_str(), bip::read_write);
+      m_shm_obj->truncate(static_cast<long>(m_header_size + 3 * m_stride));
+      map_region(options);
+      std::memset(m_base_ptr, 0, m_header_size);
+      for (std::uint64_t idx = 0; idx < 3; ++idx) {
+        buffer(idx).size = 0;
+      }
+      state().store(pack(0, 1, 2), std::memory_order_relaxed);
+      publish_header(m_base_ptr, SegmentKind::TripleBuffer, m_header_size,
+                     3 * m_stride, m_buffer_size);
+      return;
+    }
+
+    m_shm_obj = std::make_unique<bip::shared_memory_object>(
+        bip::open_only, m_mapped_file_name.c_str(), bip::read_write);
+    map_region(options);
+    const auto &header =
+        read_header(m_base_ptr, m_total_size, SegmentKind::TripleBuffer, name);
+    set_geometry(header.params[0]);
+    if (header.header_size != m_header_size)
+      throw std::runtime_error("Unexpected header size of [" + name + "]");
+    if (buffer_size_bytes > 0 && buffer_size_bytes != m_buffer_size)
+      throw std::runtime_error(
+          "buffer_size_bytes does not match the size of [" + name +
+          "]: " + std::to_string(m_buffer_size));
+  }
+
+  // Disable copy operations.
+  TripleBuffer(const TripleBuffer &) = delete;
+
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  ~TripleBuffer() { dispose(); }
+
+  /// Writer side: the buffer to fill, buffer_size() bytes long.
+  [[nodiscard]] std::span<std::byte> back() const {
+    return {buffer_data(back_index()), m_buffer_size};
+  }
+
+  /// Writer side: back() viewed as a T, e.g., a fixed-size book snapshot.
+  template <typename T> [[nodiscard]] T &back_as() const {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "T must be trivially copyable to live in shared memory");
+    if (sizeof(T) > m_buffer_size)
+      throw std::length_error("T does not fit into a buffer");
+    return *reinterpret_cast<T *>(back().data());
+  }
+
+  /// Writer side: hands the first size_bytes bytes of back() over to the
+  /// reader, never waits for it.
+  void publish(const std::size_t size_bytes) {
+    if (!m_writer)
+      throw std::logic_error("publish() called by the reader");
+    if (size_bytes > m_buffer_size)
+      throw std::length_error("size_bytes exceeds the buffer size");
+    const auto state_ref = state();
+    std::uint64_t current = state_ref.load(std::memory_order_relaxed);
+    const std::uint64_t back = current >> BACK_SHIFT & INDEX_MASK;
+    buffer(back).size = size_bytes;
+    // Only a refresh() in between makes this retry, at most once per refresh
+    while (!state_ref.compare_exchange_weak(
+        current,
+        pack(current & INDEX_MASK, back | FRESH,
+             current >> FRONT_SHIFT & INDEX_MASK),
+        std::memory_order_acq_rel, std::memory_order_relaxed)) {
+    }
+  }
+
+  /// Reader side: switches front() to the newest published snapshot.
+  /// @return false if nothing was published since the last refresh()
+  bool refresh() {
+    if (m_writer)
+      throw std::logic_error("refresh() called by the writer");
+    const auto state_ref = state();
+    std::uint64_t current = state_ref.load(std::memory_order_relaxed);
+    do {
+      if (!(current & FRESH))
+        return false;
+    } while (!state_ref.compare_exchange_weak(
+        current,
+        pack(current >> BACK_SHIFT & INDEX_MASK,
+             current >> FRONT_SHIFT & INDEX_MASK, current & INDEX_MASK),
+        std::memory_order_acq_rel, std::memory_order_relaxed));
+    return true;
+  }
+
+  /// Reader side: the snapshot picked up by the last refresh(), empty if
+  /// nothing was published yet. Stays unchanged until the next refresh().
+  [[nodiscard]] std::span<const std::byte> front() const {
+    const std::uint64_t front = front_index();
+    return {buffer_data(front), buffer(front).size};
+  }
+
+  /// Reader side: front() viewed as a T.
+  template <typename T> [[nodiscard]] const T &front_as() const {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "T must be trivially copyable to live in shared memory");
+    if (sizeof(T) > m_buffer_size)
+      throw std::length_error("T does not fit into a buffer");
+    return *reinterpret_cast<const T *>(front().data());
+  }
+
+  [[nodiscard]] std::size_t buffer_size() const { return m_buffer_size; }
+
+  void dispose() {
+    m_region.reset();
+    m_shm_obj.reset();
+    if (m_ownership) {
+      boost::interprocess::shared_memory_object::remove(
+          m_mapped_file_name.c_str());
+    }
+    m_base_ptr = nullptr;
+  }
+};
+} // namespace RingBuffer::Interprocess
+
+#endif // INTERPROCESS_TRIPLE_BUFFER_IMPL_H
@@ -0,0 +1,293 @@
+#ifndef INTRAPROCESS_BYTE_QUEUE_IMPL_H
+#define INTRAPROCESS_BYTE_QUEUE_IMPL_H
+
+#include "../detail/platform.h"
+#include "../interprocess/byte-sequence.h"
+#include "../ringbuffer-interface.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+/* A variable-length SPSC byte ring for intraprocess use: messages are
+ * length-prefixed records in one contiguous buffer, like the records of
+ * Interprocess::SpscQueue, so passing a message never touches the allocator.
+ *
+ *   +-------------+---------+---------+---------+-------------+
+ *   | length      | padding | payload | padding | next record |
+ *   | (uint32)    | to 8    |         | to 8    | ...         |
+ *   +-------------+---------+---------+---------+-------------+
+ *
+ * Records start 8-byte aligned and never straddle the end of the buffer: a
+ * record that does not fit is preceded by a WRAPPED marker and starts over
+ * at offset 0. head and tail are monotonically increasing byte positions, the
+ * buffer is indexed with position & (capacity - 1). A record and the bytes
+ * it may skip together take less than twice its size, so records of up to
+ * half the capacity always fit into an empty ring and larger ones are
+ * rejected.
+ *
+ * Besides enqueue()/dequeue(), which copy, the producer can build a message
+ * in place with reserve()/commit() and the consumer can read it in place
+ * with peek()/release().
+ */
+namespace RingBuffer::Intraprocess {
+    struct ByteQueueOptions {
+        // Back the ring with 2 MiB pages: explicit huge pages if the system
+        // has some reserved, otherwise transparent huge pages. Ignored where
+        // neither exists.
+        bool huge_pages = false;
+    };
+
+    class ByteQueue : public IRingBuffer<ByteQueue, std::string> {
+    private:
+        static constexpr std::uint32_t WRAPPED = UINT32_MAX;
+        static constexpr std::size_t RECORD_HEADER = 8;
+
+        std::size_t m_capacity;
+        std::byte *m_buffer;
+        // Non-zero if m_buffer is mapped rather than allocated
+        std::size_t m_mapped_size = 0;
+
+        // Written by the producer
+        alignas(64) std::atomic<std::uint64_t> m_tail{0};
+        std::uint64_t m_cached_head = 0;
+        // Position of the record reserve() handed out, and its capacity
+        std::uint64_t m_reserved_start = 0;
+        std::size_t m_reserved_size = 0;
+        bool m_reserved = false;
+
+        // Written by the consumer
+        alignas(64) std::atomic<std::uint64_t> m_head{0};
+        std::uint64_t m_cached_tail = 0;
+        // Position right after the record peek() handed out
+        std::uint64_t m_peeked_end = 0;
+
+        static std::size_t record_size(const std::size_t msg_length) {
+            return (RECORD_HEADER + msg_length + 7) & ~std::size_t{7};
+        }
+
+        static std::size_t round_up_capacity(const std::size_t requested) {
+            std::size_t capacity = 64;
+            while (capacity < requested) {
+                capacity <<= 1;
+            }
+            return capacity;
+        }
+
+        [[nodiscard]] std::uint32_t &length_at(const std::uint64_t pos) const {
+            return *reinterpret_cast<std::uint32_t *>(
+                    m_buffer + (pos & (m_capacity - 1)));
+        }
+
+        void allocate(const ByteQueueOptions &options) {
+            if (options.huge_pages) {
+                m_buffer = static_cast<std::byte *>(
+                        Detail::map_huge_pages(m_capacity, m_mapped_size));
+                if (m_buffer != nullptr)
+                    return;
+            }
+            m_buffer = static_cast<std::byte *>(
+                    ::operator new(m_capacity, std::align_val_t{64}));
+        }
+
+    public:
+        /// @param capacity_bytes size of the ring, rounded up to a power of
+        /// two (at least 64). A message takes its length plus 8 bytes,
+        /// rounded up to a multiple of 8, and may take at most half of it,
+        /// see max_message_size().
+        explicit ByteQueue(const std::size_t capacity_bytes,
+                           const ByteQueueOptions &options = {}) :
+            m_capacity(round_up_capacity(capacity_bytes)) {
+            allocate(options);
+        }
+
+        ByteQueue(const ByteQueue &) = delete;
+
+        ByteQueue &operator=(const ByteQueue &) = delete;
+
+        ~ByteQueue() {
+            if (m_mapped_size > 0)
+                Detail::unmap_huge_pages(m_buffer, m_mapped_size);
+            else
+                ::operator delete(m_buffer, std::align_val_t{64});
+        }
+
+        /// Producer side: reserves room for a message of up to size bytes
+        /// and returns where to write it, nullptr if the ring is full. The
+        /// message becomes visible with commit(); reserving again before
+        /// that discards the reservation.
+        /// @throw std::length_error if size exceeds max_message_size(), such
+        /// a message would never fit
+        std::byte *reserve(const std::size_t size) {
+            m_reserved = false;
+            if (size > max_message_size())
+                throw std::length_error("reserve() exceeds max_message_size()");
+            const std::size_t record = record_size(size);
+            const std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+            const std::size_t offset = tail & (m_capacity - 1);
+            const std::size_t skip =
+                    m_capacity - offset < record ? m_capacity - offset : 0;
+            const std::uint64_t end = tail + skip + record;
+            if (end - m_cached_head > m_capacity) {
+                m_cached_head = m_head.load(std::memory_order_acquire);
+                if (end - m_cached_head > m_capacity)
+                    return nullptr;
+            }
+            if (skip > 0)
+                length_at(tail) = WRAPPED;
+            m_reserved_start = tail + skip;
+            m_reserved_size = size;
+            m_reserved = true;
+            return m_buffer + (m_reserved_start & (m_capacity - 1)) +
+                   RECORD_HEADER;
+        }
+
+        /// Producer side: publishes the first size bytes of the last
+        /// reservation, size must not exceed what was reserved.
+        /// @throw std::logic_error if no reservation is active, i.e., the
+        /// last reserve() failed or its record was already committed
+        void commit(const std::size_t size) {
+            if (!m_reserved)
+                throw std::logic_error("commit() without an active reservation");
+            if (size > m_reserved_size)
+                throw std::length_error("commit() exceeds the reservation");
+            length_at(m_reserved_start) = static_cast<std::uint32_t>(size);
+            m_reserved = false;
+            m_tail.store(m_reserved_start + record_size(size),
+                         std::memory_order_release);
+        }
+
+        /// Consumer side: the oldest message, read in place. It stays valid
+        /// and is returned again until release().
+        /// @return false if the ring is empty
+        bool peek(std::span<const std::byte> &msg) {
+            std::uint64_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_cached_tail) {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+                if (head == m_cached_tail)
+                    return false;
+            }
+            std::uint32_t msg_length = length_at(head);
+            if (msg_length == WRAPPED) {
+                // The wrapped record was published along with its marker
+                head += m_capacity - (head & (m_capacity - 1));
+                msg_length = length_at(head);
+            }
+            msg = {m_buffer + (head & (m_capacity - 1)) + RECORD_HEADER,
+                   msg_length};
+            m_peeked_end = head + record_size(msg_length);
+            return true;
+        }
+
+        /// Consumer side: hands the message returned by peek() back to the
+        /// producer.
+        void release() {
+            m_head.store(m_peeked_end, std::memory_order_release);
+        }
+
+        // Returns false if the ring is full or the message can never fit
+        template<Interprocess::ByteSequence U>
+        bool enqueue_impl(U &&msg_bytes) {
+            const auto bytes = Interprocess::as_byte_span(msg_bytes);
+            if (bytes.size() > max_message_size())
+                return false;
+            std::byte *dst = reserve(bytes.size());
+            if (dst == nullptr)
+                return false;
+            std::memcpy(dst, bytes.data(), bytes.size());
+            commit(bytes.size());
+            return true;
+        }
+
+        /// Writes several fragments back to back as one message.
+        bool enqueue_gather(const Interprocess::Fragments fragments) {
+            std::size_t msg_length = 0;
+            for (const auto &fragment: fragments) {
+                msg_length += fragment.size();
+            }
+            if (msg_length > max_message_size())
+                return false;
+            std::byte *dst = reserve(msg_length);
+            if (dst == nullptr)
+                return false;
+            for (const auto &fragment: fragments) {
+                std::memcpy(dst, fragment.data(), fragment.size());
+                dst += fragment.size();
+            }
+            commit(msg_length);
+            return true;
+        }
+
+        bool dequeue_impl(std::string &buffer) {
+            std::span<const std::byte> msg;
+            if (!peek(msg))
+                return false;
+            buffer.assign(reinterpret_cast<const char *>(msg.data()),
+                          msg.size());
+            release();
+            return true;
+        }
+
+        // Hands up to max_items messages to fn in place, then releases them
+        // all with one store to m_head.
+        template<typename F>
+        std::size_t consume_up_to_impl(const std::size_t max_items, F &&fn) {
+            std::uint64_t head = m_head.load(std::memory_order_relaxed);
+            const std::uint64_t tail = m_tail.load(std::memory_order_acquire);
+            std::size_t count = 0;
+            while (head != tail && count < max_items) {
+                std::uint32_t msg_length = length_at(head);
+                if (msg_length == WRAPPED) {
+                    head += m_capacity - (head & (m_capacity - 1));
+                    msg_length = length_at(head);
+                }
+                try {
+                    fn(std::span<const std::byte>(
+                            m_buffer + (head & (m_capacity - 1)) +
+                                    RECORD_HEADER,
+                            msg_length));
+                } catch (...) {
+                    m_head.store(head, std::memory_order_release);
+                    throw;
+                }
+                head += record_size(msg_length);
+                ++count;
+            }
+            if (count > 0)
+                m_head.store(head, std::memory_order_release);
+            return count;
+        }
+
+        [[nodiscard]] std::size_t capacity() const { return m_capacity; }
+
+        /// Largest message reserve() and enqueue() accept: its record takes
+        /// at most half the ring.
+        [[nodiscard]] std::size_t max_message_size() const {
+            return m_capacity / 2 - RECORD_HEADER;
+        }
+
+        /// Bytes taken by published records, padding and wrap markers
+        /// included.
+        [[nodiscard]] std::size_t used_bytes() const {
+            return m_tail.load(std::memory_order_acquire) -
+                   m_head.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] int head_impl() const {
+            return static_cast<int>(m_head.load(std::memory_order_acquire) &
+                                    (m_capacity - 1));
+        }
+
+        [[nodiscard]] int tail_impl() const {
+            return static_cast<int>(m_tail.load(std::memory_order_acquire) &
+                                    (m_capacity - 1));
+        }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_BYTE_QUEUE_IMPL_H
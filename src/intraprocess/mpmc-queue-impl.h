@@ -0,0 +1,203 @@
+#ifndef INTRAPROCESS_MPMC_QUEUE_IMPL_H
+#define INTRAPROCESS_MPMC_QUEUE_IMPL_H
+
+#include "../detail/hazard-pointers.h"
+#include "../ringbuffer-interface.h"
+#include "object-pool-impl.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+/* Refer to
+ * - M. M. Michael, M. L. Scott, "Simple, Fast, and Practical Non-Blocking
+ *   and Blocking Concurrent Queue Algorithms", PODC 1996
+ */
+
+/* An unbounded lock-free multi-producer-multi-consumer queue: a singly
+ * linked list whose first node is a dummy, so producers only touch the
+ * tail and consumers only the head:
+ *
+ *      Head                                  Tail
+ *        ↓                                     ↓
+ *   +--------+     +--------+     +--------+   +--------+
+ *   | dummy  | --> |   T0   | --> |   T1   | ->|   T2   | --> nullptr
+ *   +--------+     +--------+     +--------+   +--------+
+ *
+ * A producer links its node behind the last one with a CAS on its next
+ * pointer, then swings Tail; anyone who finds Tail lagging swings it on their
+ * behalf. A consumer moves Head to the next node with a CAS, moves the value
+ * out of it and retires the old dummy, the next node becomes the dummy.
+ *
+ * Unlinked nodes are reclaimed through Detail::HazardDomain, since other
+ * threads may still be reading them. Reclaimed nodes go back to an
+ * ObjectPool, so a queue whose length stays within the pool never
+ * allocates; beyond it nodes come from the heap and enqueue() never fails.
+ */
+namespace RingBuffer::Intraprocess {
+    struct MpmcQueueOptions {
+        // Nodes recycled through an ObjectPool, 0 to always use the heap
+        std::size_t pooled_nodes = 4096;
+        bool huge_pages = false;
+    };
+
+    template<typename T>
+    class MpmcQueue : public IRingBuffer<MpmcQueue<T>, T> {
+    private:
+        struct Node {
+            std::atomic<Node *> next{nullptr};
+            // Number of nodes linked before this one, so head() and tail()
+            // can report positions like the ring buffers do
+            std::uint64_t seq = 0;
+            alignas(T) std::byte value[sizeof(T)];
+
+            T *get() { return std::launder(reinterpret_cast<T *>(value)); }
+        };
+
+        std::unique_ptr<ObjectPool<Node>> m_pool;
+        // Declared after the pool: reclaims its leftovers into it first
+        Detail::HazardDomain<2> m_domain;
+        alignas(64) std::atomic<Node *> m_head;
+        alignas(64) std::atomic<Node *> m_tail;
+
+        Node *allocate() {
+            if (m_pool) {
+                if (Node *node = m_pool->create())
+                    return node;
+            }
+            return new Node();
+        }
+
+        void free_node(Node *node) {
+            if (m_pool && m_pool->owns(node))
+                m_pool->destroy(node);
+            else
+                delete node;
+        }
+
+        static void reclaim(void *node, void *queue) {
+            static_cast<MpmcQueue *>(queue)->free_node(static_cast<Node *>(node));
+        }
+
+        void link(Node *node) {
+            typename Detail::HazardDomain<2>::Guard guard(m_domain);
+            while (true) {
+                Node *tail = guard.protect(0, m_tail);
+                Node *next = tail->next.load(std::memory_order_acquire);
+                if (next != nullptr) {
+                    // Tail lags behind, help it along
+                    m_tail.compare_exchange_weak(tail, next,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed);
+                    continue;
+                }
+                node->seq = tail->seq + 1;
+                if (tail->next.compare_exchange_weak(
+                            next, node, std::memory_order_release,
+                            std::memory_order_relaxed)) {
+                    m_tail.compare_exchange_strong(tail, node,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed);
+                    return;
+                }
+            }
+        }
+
+        std::uint64_t seq_of(const std::atomic<Node *> &end) {
+            typename Detail::HazardDomain<2>::Guard guard(m_domain);
+            return guard.protect(0, end)->seq;
+        }
+
+    public:
+        explicit MpmcQueue(const MpmcQueueOptions &options = {}) {
+            if (options.pooled_nodes > 0)
+                m_pool = std::make_unique<ObjectPool<Node>>(
+                        options.pooled_nodes,
+                        ObjectPoolOptions{.huge_pages = options.huge_pages});
+            Node *dummy = allocate();
+            m_head.store(dummy, std::memory_order_relaxed);
+            m_tail.store(dummy, std::memory_order_relaxed);
+        }
+
+        MpmcQueue(const MpmcQueue &) = delete;
+
+        MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+        /// No other thread may use the queue anymore.
+        ~MpmcQueue() {
+            Node *node = m_head.load(std::memory_order_acquire);
+            // The first node is the dummy, its value is gone already
+            Node *next = node->next.load(std::memory_order_acquire);
+            free_node(node);
+            for (node = next; node != nullptr; node = next) {
+                next = node->next.load(std::memory_order_acquire);
+                std::destroy_at(node->get());
+                free_node(node);
+            }
+        }
+
+        /// Never fails, short of std::bad_alloc.
+        template<typename U>
+        bool enqueue_impl(U &&item) {
+            Node *node = allocate();
+            try {
+                new (node->value) T(std::forward<U>(item));
+            } catch (...) {
+                free_node(node);
+                throw;
+            }
+            node->next.store(nullptr, std::memory_order_relaxed);
+            link(node);
+            return true;
+        }
+
+        bool dequeue_impl(T &item) {
+            typename Detail::HazardDomain<2>::Guard guard(m_domain);
+            while (true) {
+                Node *head = guard.protect(0, m_head);
+                Node *next = guard.protect(1, head->next);
+                if (head != m_head.load(std::memory_order_acquire))
+                    continue;
+                if (next == nullptr)
+                    return false;
+                Node *tail = m_tail.load(std::memory_order_acquire);
+                if (head == tail) {
+                    // next is linked but Tail not swung yet, never let Head
+                    // overtake Tail
+                    m_tail.compare_exchange_weak(tail, next,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed);
+                    continue;
+                }
+                if (m_head.compare_exchange_weak(head, next,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_relaxed)) {
+                    // next is the dummy now, but its value is ours alone and
+                    // the hazard keeps it alive until we are done
+                    item = std::move(*next->get());
+                    std::destroy_at(next->get());
+                    guard.retire(head, &MpmcQueue::reclaim, this);
+                    return true;
+                }
+            }
+        }
+
+        /// Number of elements dequeued so far.
+        [[nodiscard]] int head_impl() { return static_cast<int>(seq_of(m_head)); }
+
+        /// Number of elements enqueued so far, may briefly lag behind.
+        [[nodiscard]] int tail_impl() { return static_cast<int>(seq_of(m_tail)); }
+
+        /// Elements in the queue, exact only while it is quiescent.
+        [[nodiscard]] std::size_t size_approx() {
+            const std::uint64_t head = seq_of(m_head);
+            const std::uint64_t tail = seq_of(m_tail);
+            return tail > head ? static_cast<std::size_t>(tail - head) : 0;
+        }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_MPMC_QUEUE_IMPL_H
@@ -0,0 +1,99 @@
+#ifndef INTRAPROCESS_NOTIFIER_IMPL_H
+#define INTRAPROCESS_NOTIFIER_IMPL_H
+
+#include "../detail/wakeup.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/* An eventfd that becomes readable when a producer publishes into a queue
+ * whose consumer is about to sleep, so that the consumer can block in its
+ * epoll loop on sockets, timers and queues together (Linux only):
+ *
+ *   epoll_ctl(ep, EPOLL_CTL_ADD, notifier.fd(), {EPOLLIN, ...});
+ *   while (true) {
+ *     if (q.consume_all(handle) > 0)
+ *       continue;
+ *     notifier.prepare_wait();
+ *     if (q.consume_all(handle) > 0) {
+ *       notifier.cancel_wait();
+ *       continue;
+ *     }
+ *     epoll_wait(ep, ...); // and notifier.acknowledge() if fd() fired
+ *   }
+ *
+ * and on the producer side q.enqueue(msg) followed by notifier.notify().
+ * The eventfd is only written when the consumer has called prepare_wait(),
+ * see detail/wakeup.h, so a busy consumer costs no syscall per message.
+ */
+namespace RingBuffer::Intraprocess {
+    class Notifier {
+    private:
+        alignas(64) std::uint32_t m_word = Detail::WAKEUP_AWAKE;
+        int m_fd;
+
+    public:
+        Notifier() : m_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+            if (m_fd < 0)
+                throw std::system_error(errno, std::generic_category(),
+                                        "eventfd()");
+        }
+
+        Notifier(const Notifier &) = delete;
+
+        Notifier &operator=(const Notifier &) = delete;
+
+        ~Notifier() { close(m_fd); }
+
+        /// The eventfd to register with epoll/poll for EPOLLIN/POLLIN.
+        [[nodiscard]] int fd() const { return m_fd; }
+
+        /// Producer side: call after each successful enqueue(). Writes the
+        /// eventfd only if the consumer is waiting.
+        void notify() {
+            if (Detail::wakeup_take(m_word)) {
+                const std::uint64_t one = 1;
+                // EAGAIN means the counter is saturated, i.e., readable anyway
+                (void) !write(m_fd, &one, sizeof(one));
+            }
+        }
+
+        /// Consumer side: call right before polling the queue one last time,
+        /// block on fd() only if that poll comes back empty.
+        void prepare_wait() { Detail::wakeup_arm(m_word); }
+
+        /// Consumer side: the last poll after prepare_wait() found messages,
+        /// the consumer does not block after all.
+        void cancel_wait() { Detail::wakeup_disarm(m_word); }
+
+        /// Consumer side: resets fd() after it became readable.
+        void acknowledge() {
+            std::uint64_t count;
+            (void) !read(m_fd, &count, sizeof(count));
+        }
+
+        /// Consumer side: blocks on fd() without an epoll loop of its own,
+        /// for after a prepare_wait() whose last poll came back empty.
+        /// @param timeout_ms -1 waits indefinitely
+        /// @return false on timeout
+        bool wait(const int timeout_ms = -1) {
+            pollfd pfd{m_fd, POLLIN, 0};
+            int ready;
+            while ((ready = poll(&pfd, 1, timeout_ms)) < 0 && errno == EINTR) {
+            }
+            if (ready <= 0) {
+                cancel_wait();
+                return false;
+            }
+            acknowledge();
+            return true;
+        }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_NOTIFIER_IMPL_H
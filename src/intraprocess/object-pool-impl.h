@@ -0,0 +1,245 @@
+#ifndef INTRAPROCESS_OBJECT_POOL_IMPL_H
+#define INTRAPROCESS_OBJECT_POOL_IMPL_H
+
+#include "../detail/platform.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+/* A lock-free fixed-capacity pool of T, so that a producer can hand a T*
+ * through e.g. SpscQueue<T*> and the consumer can give it back without
+ * either of them calling the global allocator:
+ *
+ *   +---------+---------+---------+-----+      next[] (one per slot)
+ *   | slot 0  | slot 1  | slot 2  | ... |      +----+----+----+-----+
+ *   | T, pad  | T, pad  | T, pad  |     |      |  2 |  - |  0 | ... |
+ *   +---------+---------+---------+-----+      +----+----+----+-----+
+ *   each slot a whole number of cache lines     free list links
+ *
+ * Free slots form a Treiber stack of slot indices. The head packs a 32-bit
+ * index with a 32-bit tag that every push and pop bumps, so a CAS cannot be
+ * fooled by a slot that was popped and pushed back in between (ABA). Links
+ * live in their own array rather than in the free slot, so a thread that
+ * reads the link of a slot someone else just popped reads an atomic, not
+ * the T being constructed there.
+ *
+ * Slots are padded to cache lines, so objects owned by different threads
+ * never share one. A Cache keeps a private batch of free slots per thread
+ * and talks to the shared stack once per batch.
+ */
+namespace RingBuffer::Intraprocess {
+    struct ObjectPoolOptions {
+        // Back the slab with huge pages, see Detail::map_huge_pages()
+        bool huge_pages = false;
+    };
+
+    template<typename T>
+    class ObjectPool {
+    private:
+        static constexpr std::uint32_t NIL = UINT32_MAX;
+        // A multiple of alignof(T) as well: sizeof(T) is one of it
+        static constexpr std::size_t STRIDE = (sizeof(T) + 63) / 64 * 64;
+        static constexpr std::size_t SLAB_ALIGNMENT =
+                alignof(T) > 64 ? alignof(T) : 64;
+
+        std::size_t m_capacity;
+        std::byte *m_slab;
+        std::size_t m_mapped_size = 0;
+        std::unique_ptr<std::atomic<std::uint32_t>[]> m_next;
+        alignas(64) std::atomic<std::uint64_t> m_head;
+
+        static std::uint64_t pack(const std::uint32_t idx,
+                                  const std::uint64_t tag) {
+            return tag << 32 | idx;
+        }
+
+        static std::uint32_t index_of(const std::uint64_t head) {
+            return static_cast<std::uint32_t>(head);
+        }
+
+        [[nodiscard]] T *slot(const std::uint32_t idx) const {
+            return reinterpret_cast<T *>(m_slab + idx * STRIDE);
+        }
+
+        [[nodiscard]] std::uint32_t index(const T *ptr) const {
+            return static_cast<std::uint32_t>(
+                    (reinterpret_cast<const std::byte *>(ptr) - m_slab) /
+                    STRIDE);
+        }
+
+        /// Pops one free slot.
+        /// @return NIL if the pool is exhausted
+        std::uint32_t pop() {
+            std::uint64_t head = m_head.load(std::memory_order_acquire);
+            while (index_of(head) != NIL) {
+                const std::uint32_t next =
+                        m_next[index_of(head)].load(std::memory_order_relaxed);
+                if (m_head.compare_exchange_weak(
+                            head, pack(next, (head >> 32) + 1),
+                            std::memory_order_acquire,
+                            std::memory_order_acquire))
+                    return index_of(head);
+            }
+            return NIL;
+        }
+
+        /// Pushes the chain first -> ... -> last, already linked through
+        /// m_next, with one CAS.
+        void push_chain(const std::uint32_t first, const std::uint32_t last) {
+            std::uint64_t head = m_head.load(std::memory_order_relaxed);
+            do {
+                m_next[last].store(index_of(head), std::memory_order_relaxed);
+            } while (!m_head.compare_exchange_weak(
+                    head, pack(first, (head >> 32) + 1),
+                    std::memory_order_release, std::memory_order_relaxed));
+        }
+
+    public:
+        /// A per-thread front end: create() and destroy() work on a private
+        /// list of free slots and only refill it from, or spill half of it
+        /// back to, the shared stack every batch_size calls. Must be used by
+        /// one thread at a time and must not outlive its pool.
+        class Cache {
+        private:
+            ObjectPool &m_pool;
+            std::size_t m_batch_size;
+            std::uint32_t m_head = NIL;
+            std::size_t m_count = 0;
+
+            void spill(std::size_t n) {
+                const std::uint32_t first = m_head;
+                std::uint32_t last = first;
+                for (; n > 1; --n) {
+                    last = m_pool.m_next[last].load(std::memory_order_relaxed);
+                }
+                m_head = m_pool.m_next[last].load(std::memory_order_relaxed);
+                m_pool.push_chain(first, last);
+            }
+
+        public:
+            explicit Cache(ObjectPool &pool, const std::size_t batch_size = 32) :
+                m_pool(pool), m_batch_size(batch_size > 0 ? batch_size : 1) {}
+
+            Cache(const Cache &) = delete;
+
+            Cache &operator=(const Cache &) = delete;
+
+            ~Cache() {
+                if (m_count > 0)
+                    spill(m_count);
+            }
+
+            /// @return nullptr if the pool (including this cache) is
+            /// exhausted
+            template<typename... Args>
+            T *create(Args &&...args) {
+                if (m_count == 0) {
+                    for (; m_count < m_batch_size; ++m_count) {
+                        const std::uint32_t idx = m_pool.pop();
+                        if (idx == NIL)
+                            break;
+                        m_pool.m_next[idx].store(m_head,
+                                                 std::memory_order_relaxed);
+                        m_head = idx;
+                    }
+                    if (m_count == 0)
+                        return nullptr;
+                }
+                const std::uint32_t idx = m_head;
+                T *ptr = new (m_pool.slot(idx)) T(std::forward<Args>(args)...);
+                m_head = m_pool.m_next[idx].load(std::memory_order_relaxed);
+                --m_count;
+                return ptr;
+            }
+
+            /// Destroys an object of the pool, created by any thread.
+            void destroy(T *ptr) {
+                std::destroy_at(ptr);
+                const std::uint32_t idx = m_pool.index(ptr);
+                m_pool.m_next[idx].store(m_head, std::memory_order_relaxed);
+                m_head = idx;
+                if (++m_count >= 2 * m_batch_size) {
+                    spill(m_batch_size);
+                    m_count -= m_batch_size;
+                }
+            }
+
+            [[nodiscard]] std::size_t cached() const { return m_count; }
+        };
+
+        /// @param capacity number of objects, fixed for the pool's lifetime
+        explicit ObjectPool(const std::size_t capacity,
+                            const ObjectPoolOptions &options = {}) :
+            m_capacity(capacity),
+            m_slab(nullptr),
+            m_next(std::make_unique<std::atomic<std::uint32_t>[]>(capacity)) {
+            if (capacity == 0 || capacity >= NIL)
+                throw std::invalid_argument("capacity out of range");
+            if (options.huge_pages)
+                m_slab = static_cast<std::byte *>(
+                        Detail::map_huge_pages(capacity * STRIDE, m_mapped_size));
+            if (m_slab == nullptr)
+                m_slab = static_cast<std::byte *>(::operator new(
+                        capacity * STRIDE, std::align_val_t{SLAB_ALIGNMENT}));
+            for (std::size_t i = 0; i < capacity; ++i) {
+                m_next[i].store(i + 1 < capacity ? i + 1 : NIL,
+                                std::memory_order_relaxed);
+            }
+            m_head.store(pack(0, 0), std::memory_order_release);
+        }
+
+        ObjectPool(const ObjectPool &) = delete;
+
+        ObjectPool &operator=(const ObjectPool &) = delete;
+
+        /// Objects still alive are not destroyed, their memory is released.
+        ~ObjectPool() {
+            if (m_mapped_size > 0)
+                Detail::unmap_huge_pages(m_slab, m_mapped_size);
+            else
+                ::operator delete(m_slab, std::align_val_t{SLAB_ALIGNMENT});
+        }
+
+        /// Constructs a T in a free slot, from any thread. If T's constructor
+        /// throws, the slot goes back to the pool.
+        /// @return nullptr if the pool is exhausted
+        template<typename... Args>
+        T *create(Args &&...args) {
+            const std::uint32_t idx = pop();
+            if (idx == NIL)
+                return nullptr;
+            try {
+                return new (slot(idx)) T(std::forward<Args>(args)...);
+            } catch (...) {
+                push_chain(idx, idx);
+                throw;
+            }
+        }
+
+        /// Destroys an object created by this pool, from any thread.
+        void destroy(T *ptr) {
+            std::destroy_at(ptr);
+            const std::uint32_t idx = index(ptr);
+            push_chain(idx, idx);
+        }
+
+        /// Whether ptr points into this pool's slab.
+        [[nodiscard]] bool owns(const T *ptr) const {
+            const auto addr = reinterpret_cast<const std::byte *>(ptr);
+            return addr >= m_slab && addr < m_slab + m_capacity * STRIDE;
+        }
+
+        [[nodiscard]] std::size_t capacity() const { return m_capacity; }
+
+        /// Bytes between two neighboring objects, a multiple of the cache
+        /// line size.
+        static constexpr std::size_t stride() { return STRIDE; }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_OBJECT_POOL_IMPL_H
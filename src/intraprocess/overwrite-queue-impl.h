@@ -0,0 +1,81 @@
+#ifndef INTRAPROCESS_OVERWRITE_QUEUE_IMPL_H
+#define INTRAPROCESS_OVERWRITE_QUEUE_IMPL_H
+
+#include "../detail/overwrite-ring.h"
+#include "../ringbuffer-interface.h"
+
+#include <cstdint>
+#include <memory>
+
+/* A lossy SPSC ring for telemetry and flight recording: enqueue() never fails
+ * and never waits, when the ring is full it overwrites the oldest message.
+ * The consumer detects overwritten messages through per-slot sequence
+ * numbers (see detail/overwrite-ring.h), skips to the oldest message still
+ * in the ring and reports the gap via dropped(). T must be trivially
+ * copyable, since the consumer may copy a slot while it is being
+ * overwritten and retries if so.
+ */
+namespace RingBuffer::Intraprocess {
+    template<typename T>
+    class OverwriteQueue : public IRingBuffer<OverwriteQueue<T>, T> {
+    private:
+        const std::uint64_t m_capacity;
+        std::unique_ptr<Detail::SeqlockSlot<T>[]> m_slots;
+        alignas(64) std::uint64_t m_written = 0;
+        // Consumer side
+        alignas(64) std::uint64_t m_cursor = 0;
+        std::uint64_t m_dropped = 0;
+
+        [[nodiscard]] Detail::OverwriteRing<T> ring() {
+            return {m_slots.get(), m_capacity - 1, m_written};
+        }
+
+    public:
+        /// @param capacity rounded up to a power of two
+        explicit OverwriteQueue(const std::size_t capacity) :
+            m_capacity(Detail::overwrite_ring_capacity(capacity)),
+            m_slots(std::make_unique<Detail::SeqlockSlot<T>[]>(m_capacity)) {}
+
+        OverwriteQueue(const OverwriteQueue &) = delete;
+
+        OverwriteQueue &operator=(const OverwriteQueue &) = delete;
+
+        /// Always succeeds, overwriting the oldest message if the ring is
+        /// full.
+        template<typename U>
+            requires std::assignable_from<T &, U>
+        bool enqueue_impl(U &&item) {
+            if constexpr (std::is_same_v<std::remove_cvref_t<U>, T>) {
+                Detail::overwrite_ring_push(ring(), item);
+            } else {
+                T value;
+                value = std::forward<U>(item);
+                Detail::overwrite_ring_push(ring(), value);
+            }
+            return true;
+        }
+
+        /// Dequeues the oldest message still in the ring, messages that were
+        /// overwritten before they could be dequeued are added to dropped().
+        bool dequeue_impl(T &item) {
+            return Detail::overwrite_ring_pop(ring(), m_cursor, m_dropped,
+                                              item);
+        }
+
+        /// Number of messages the consumer missed so far.
+        [[nodiscard]] std::uint64_t dropped() const { return m_dropped; }
+
+        [[nodiscard]] std::size_t capacity() const { return m_capacity; }
+
+        [[nodiscard]] int head_impl() const {
+            return static_cast<int>(m_cursor);
+        }
+
+        [[nodiscard]] int tail_impl() {
+            return static_cast<int>(std::atomic_ref(m_written).load(
+                    std::memory_order_acquire));
+        }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_OVERWRITE_QUEUE_IMPL_H
@@ -0,0 +1,518 @@
+#ifndef INTRAPROCESS_POLICY_QUEUE_IMPL_H
+#define INTRAPROCESS_POLICY_QUEUE_IMPL_H
+
+#include "../detail/platform.h"
+#include "../detail/sojourn.h"
+#include "../ringbuffer-interface.h"
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+/* Refer to
+ * - https://github.com/facebook/folly/blob/main/folly/ProducerConsumerQueue.h
+ * -
+ * https://github.com/cameron314/readerwriterqueue/blob/master/readerwritercircularbuffer.h
+ */
+
+/* An SPSC queue assembled from compile-time policies, so that a queue can be
+ * tuned for its workload without another copy of the class:
+ *
+ *   PolicyQueue<T, Storage, Index, Fencing, Wait, Stats>
+ *
+ *   Storage  where the slots live: HeapStorage, InlineStorage<N>,
+ *            HugePageStorage
+ *   Index    how head/tail map to slots: WrapIndex (capacity + 1 slots,
+ *            indices wrap to 0) or MaskIndex (power-of-two slots, indices
+ *            grow monotonically and are masked); CachePeer = true keeps a
+ *            private copy of the other side's index and only re-reads the
+ *            shared one when the copy says full/empty
+ *   Fencing  AcquireRelease (acquiring loads and releasing stores) or
+ *            StandaloneFences (relaxed accesses plus
+ *            std::atomic_thread_fence)
+ *   Wait     what a full/empty call does before it gives up: NoWait,
+ *            SpinWait<N> or YieldWait<N>
+ *   Stats    NoStats, CountingStats or SojournSampling<N>, constructed
+ *            from the queue's capacity
+ *
+ * Policies are stateless or [[no_unique_address]] and every hook is an
+ * inline static call. SpscQueue<T> is the queue with the default policies
+ * and SpscQueueBeta<T> the one with StandaloneFences. Interprocess queues
+ * keep their own classes, their layout is the shared memory format.
+ */
+namespace RingBuffer::Intraprocess {
+    namespace QueuePolicy {
+        /// Slots in a heap array.
+        struct HeapStorage {
+            template<typename T>
+            class Buffer {
+            private:
+                std::unique_ptr<T[]> m_slots;
+
+            public:
+                explicit Buffer(const std::size_t slots) :
+                    m_slots(new T[slots]()) {}
+
+                T &operator[](const std::size_t idx) { return m_slots[idx]; }
+            };
+        };
+
+        /// Slots inside the queue object itself, no allocation at all. The
+        /// queue's capacity must need at most N slots.
+        template<std::size_t N>
+        struct InlineStorage {
+            template<typename T>
+            class Buffer {
+            private:
+                std::array<T, N> m_slots{};
+
+            public:
+                explicit Buffer(const std::size_t slots) {
+                    if (slots > N)
+                        throw std::length_error(
+                                "capacity exceeds the inline storage");
+                }
+
+                T &operator[](const std::size_t idx) { return m_slots[idx]; }
+            };
+        };
+
+        /// Slots in a huge page mapping, which saves TLB misses on large
+        /// queues. Falls back to the heap where mmap() is not available.
+        struct HugePageStorage {
+            template<typename T>
+            class Buffer {
+            private:
+                T *m_slots;
+                std::size_t m_count;
+                std::size_t m_mapped_size = 0;
+
+            public:
+                explicit Buffer(const std::size_t slots) : m_count(slots) {
+                    void *mem = Detail::map_huge_pages(sizeof(T) * slots,
+                                                       m_mapped_size);
+                    if (mem == nullptr)
+                        mem = ::operator new(sizeof(T) * slots,
+                                             std::align_val_t{alignof(T)});
+                    m_slots = static_cast<T *>(mem);
+                    std::uninitialized_value_construct_n(m_slots, m_count);
+                }
+
+                Buffer(const Buffer &) = delete;
+
+                Buffer &operator=(const Buffer &) = delete;
+
+                ~Buffer() {
+                    std::destroy_n(m_slots, m_count);
+                    if (m_mapped_size > 0)
+                        Detail::unmap_huge_pages(m_slots, m_mapped_size);
+                    else
+                        ::operator delete(m_slots,
+                                          std::align_val_t{alignof(T)});
+                }
+
+                T &operator[](const std::size_t idx) { return m_slots[idx]; }
+            };
+        };
+
+        /// Indices in [0, capacity], one slot stays free to tell full from
+        /// empty.
+        template<bool CachePeer = false>
+        struct WrapIndex {
+            static constexpr bool cache_peer = CachePeer;
+
+            static std::size_t slots_for(const std::size_t capacity) {
+                return capacity + 1;
+            }
+
+            static std::size_t capacity(const std::size_t slots) {
+                return slots - 1;
+            }
+
+            static std::size_t next(std::size_t idx, const std::size_t slots) {
+                return ++idx == slots ? 0 : idx;
+            }
+
+            static std::size_t slot(const std::size_t idx, std::size_t) {
+                return idx;
+            }
+
+            static bool full(const std::size_t tail, const std::size_t head,
+                             const std::size_t slots) {
+                return next(tail, slots) == head;
+            }
+
+            static std::size_t size(const std::size_t tail,
+                                    const std::size_t head,
+                                    const std::size_t slots) {
+                return tail >= head ? tail - head : slots + tail - head;
+            }
+        };
+
+        /// Monotonic indices masked into a power-of-two number of slots:
+        /// no branch to wrap and every slot is usable.
+        template<bool CachePeer = false>
+        struct MaskIndex {
+            static constexpr bool cache_peer = CachePeer;
+
+            static std::size_t slots_for(const std::size_t capacity) {
+                std::size_t slots = 1;
+                while (slots < capacity) {
+                    slots <<= 1;
+                }
+                return slots;
+            }
+
+            static std::size_t capacity(const std::size_t slots) {
+                return slots;
+            }
+
+            static std::size_t next(const std::size_t idx, std::size_t) {
+                return idx + 1;
+            }
+
+            static std::size_t slot(const std::size_t idx,
+                                    const std::size_t slots) {
+                return idx & (slots - 1);
+            }
+
+            static bool full(const std::size_t tail, const std::size_t head,
+                             const std::size_t slots) {
+                return tail - head == slots;
+            }
+
+            static std::size_t size(const std::size_t tail,
+                                    const std::size_t head, std::size_t) {
+                return tail - head;
+            }
+        };
+
+        struct AcquireRelease {
+            static std::size_t load_peer(const std::atomic<std::size_t> &idx) {
+                return idx.load(std::memory_order_acquire);
+            }
+
+            static void publish(std::atomic<std::size_t> &idx,
+                                const std::size_t value) {
+                idx.store(value, std::memory_order_release);
+            }
+        };
+
+        struct StandaloneFences {
+            static std::size_t load_peer(const std::atomic<std::size_t> &idx) {
+                const std::size_t value = idx.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return value;
+            }
+
+            static void publish(std::atomic<std::size_t> &idx,
+                                const std::size_t value) {
+                std::atomic_thread_fence(std::memory_order_release);
+                idx.store(value, std::memory_order_relaxed);
+            }
+        };
+
+        /// Full/empty calls return false right away.
+        struct NoWait {
+            static bool retry(unsigned) { return false; }
+        };
+
+        /// Full/empty calls spin up to Spins times with a pause hint before
+        /// they return false.
+        template<unsigned Spins>
+        struct SpinWait {
+            static bool retry(const unsigned attempt) {
+                if (attempt >= Spins)
+                    return false;
+                Detail::cpu_relax();
+                return true;
+            }
+        };
+
+        /// Full/empty calls yield the thread up to Yields times before they
+        /// return false, for oversubscribed cores.
+        template<unsigned Yields>
+        struct YieldWait {
+            static bool retry(const unsigned attempt) {
+                if (attempt >= Yields)
+                    return false;
+                std::this_thread::yield();
+                return true;
+            }
+        };
+
+        struct NoStats {
+            explicit NoStats(std::size_t) {}
+
+            void on_enqueue() {}
+            void on_full() {}
+            void on_dequeue(std::size_t) {}
+            void on_empty() {}
+        };
+
+        /// Counts successful and failed calls. Each counter has one writer,
+        /// so it is bumped without a read-modify-write, and may be read from
+        /// any thread.
+        class CountingStats {
+        private:
+            alignas(64) std::atomic<std::uint64_t> m_enqueued{0};
+            std::atomic<std::uint64_t> m_full{0};
+            alignas(64) std::atomic<std::uint64_t> m_dequeued{0};
+            std::atomic<std::uint64_t> m_empty{0};
+
+            static void add(std::atomic<std::uint64_t> &counter,
+                            const std::uint64_t n) {
+                counter.store(counter.load(std::memory_order_relaxed) + n,
+                              std::memory_order_relaxed);
+            }
+
+        public:
+            explicit CountingStats(std::size_t) {}
+
+            void on_enqueue() { add(m_enqueued, 1); }
+            void on_full() { add(m_full, 1); }
+            void on_dequeue(const std::size_t n) { add(m_dequeued, n); }
+            void on_empty() { add(m_empty, 1); }
+
+            [[nodiscard]] std::uint64_t enqueued() const {
+                return m_enqueued.load(std::memory_order_relaxed);
+            }
+            [[nodiscard]] std::uint64_t full() const {
+                return m_full.load(std::memory_order_relaxed);
+            }
+            [[nodiscard]] std::uint64_t dequeued() const {
+                return m_dequeued.load(std::memory_order_relaxed);
+            }
+            [[nodiscard]] std::uint64_t empty() const {
+                return m_empty.load(std::memory_order_relaxed);
+            }
+        };
+
+        /// Stamps every Every-th message with the TSC as it is enqueued and
+        /// records how long it waited when it is dequeued, see
+        /// Detail::SojournLog. Every is rounded up to a power of two, the
+        /// stamp ring is sized for the queue's capacity.
+        template<std::uint64_t Every>
+        class SojournSampling {
+        private:
+            static constexpr std::align_val_t ALIGNMENT{
+                    alignof(Detail::SojournLog)};
+            Detail::SojournLog *m_log;
+
+        public:
+            explicit SojournSampling(const std::size_t capacity) {
+                const std::size_t size =
+                        Detail::SojournLog::size_for(capacity, Every);
+                void *mem = ::operator new(size, ALIGNMENT);
+                std::memset(mem, 0, size);
+                m_log = static_cast<Detail::SojournLog *>(mem);
+                m_log->init(capacity, Every);
+            }
+
+            SojournSampling(const SojournSampling &) = delete;
+
+            SojournSampling &operator=(const SojournSampling &) = delete;
+
+            ~SojournSampling() { ::operator delete(m_log, ALIGNMENT); }
+
+            void on_enqueue() { m_log->on_produced(); }
+            void on_full() {}
+            void on_dequeue(const std::size_t n) { m_log->on_consumed(n); }
+            void on_empty() {}
+
+            /// Sojourn times in TSC ticks, readable from any thread.
+            [[nodiscard]] const Detail::LatencyHistogram &sojourn() const {
+                return m_log->histogram;
+            }
+
+            [[nodiscard]] std::uint64_t dropped_samples() const {
+                return m_log->dropped_samples();
+            }
+        };
+    } // namespace QueuePolicy
+
+    template<typename T, typename Storage = QueuePolicy::HeapStorage,
+             typename Index = QueuePolicy::WrapIndex<>,
+             typename Fencing = QueuePolicy::AcquireRelease,
+             typename Wait = QueuePolicy::NoWait,
+             typename Stats = QueuePolicy::NoStats>
+    class PolicyQueue
+        : public IRingBuffer<
+                  PolicyQueue<T, Storage, Index, Fencing, Wait, Stats>, T> {
+    private:
+        const std::size_t m_slots;
+        typename Storage::template Buffer<T> m_buffer;
+        [[no_unique_address]] Stats m_stats;
+
+        // Written by the producer
+        alignas(64) std::atomic<std::size_t> m_tail{0};
+        std::size_t m_cached_head = 0;
+        // Written by the consumer
+        alignas(64) std::atomic<std::size_t> m_head{0};
+        std::size_t m_cached_tail = 0;
+
+        bool has_room(const std::size_t tail) {
+            if constexpr (Index::cache_peer) {
+                if (!Index::full(tail, m_cached_head, m_slots))
+                    return true;
+                m_cached_head = Fencing::load_peer(m_head);
+                return !Index::full(tail, m_cached_head, m_slots);
+            } else {
+                return !Index::full(tail, Fencing::load_peer(m_head), m_slots);
+            }
+        }
+
+        // The producer's tail as far as the consumer knows, == head if empty
+        std::size_t known_tail(const std::size_t head) {
+            if constexpr (Index::cache_peer) {
+                if (m_cached_tail != head)
+                    return m_cached_tail;
+                m_cached_tail = Fencing::load_peer(m_tail);
+                return m_cached_tail;
+            } else {
+                return Fencing::load_peer(m_tail);
+            }
+        }
+
+        // Lets fill write the free slot at the tail, then publishes it
+        template<typename F>
+        bool produce(F &&fill) {
+            const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            for (unsigned attempt = 0; !has_room(tail); ++attempt) {
+                if (!Wait::retry(attempt)) {
+                    m_stats.on_full();
+                    return false;
+                }
+            }
+            fill(m_buffer[Index::slot(tail, m_slots)]);
+            // Before publishing, so a sampled stamp is visible with the item
+            m_stats.on_enqueue();
+            Fencing::publish(m_tail, Index::next(tail, m_slots));
+            return true;
+        }
+
+        // Lets take empty the oldest slot, then hands it back to the producer
+        template<typename F>
+        bool consume(F &&take) {
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+            for (unsigned attempt = 0; known_tail(head) == head; ++attempt) {
+                if (!Wait::retry(attempt)) {
+                    m_stats.on_empty();
+                    return false;
+                }
+            }
+            take(m_buffer[Index::slot(head, m_slots)]);
+            // Before releasing, so the producer cannot reuse a sampled stamp
+            m_stats.on_dequeue(1);
+            Fencing::publish(m_head, Index::next(head, m_slots));
+            return true;
+        }
+
+    public:
+        explicit PolicyQueue(const std::size_t capacity) :
+            m_slots(Index::slots_for(capacity)), m_buffer(m_slots),
+            m_stats(Index::capacity(m_slots)) {}
+
+        PolicyQueue(const PolicyQueue &) = delete;
+
+        PolicyQueue &operator=(const PolicyQueue &) = delete;
+
+        // A forwarding reference, so that enqueue() takes lvalues and rvalues
+        // alike. Assignment rather than conversion: the slot already holds a
+        // T, which is assigned to.
+        template<typename U>
+            requires std::assignable_from<T &, U>
+        bool enqueue_impl(U &&item) {
+            return produce([&item](T &slot) { slot = std::forward<U>(item); });
+        }
+
+        bool dequeue_impl(T &item) {
+            return consume([&item](T &slot) { item = std::move(slot); });
+        }
+
+        // Producer side: lets fn fill the free slot in place instead of
+        // assigning a new element to it, e.g., slot.assign(data, size). Paired
+        // with dequeue_swap(), a std::string slot still holds the capacity of
+        // a string the consumer handed back, so steady-state traffic does not
+        // allocate.
+        template<typename F>
+            requires std::invocable<F, T &>
+        bool enqueue_with(F &&fn) {
+            return produce(fn);
+        }
+
+        // Consumer side: swaps the oldest element with item instead of moving
+        // it out. item's previous contents, with their heap storage, stay in
+        // the ring for enqueue_with() to reuse rather than being freed on the
+        // consumer thread.
+        bool dequeue_swap(T &item) {
+            return consume([&item](T &slot) {
+                using std::swap;
+                swap(item, slot);
+            });
+        }
+
+        // Hands up to max_items elements to fn in place, then releases them
+        // all with one store to m_head. Does not wait, and always reads the
+        // shared tail: one load per sweep is cheap, a stale sweep is not.
+        template<typename F>
+        std::size_t consume_up_to_impl(const std::size_t max_items, F &&fn) {
+            std::size_t head = m_head.load(std::memory_order_relaxed);
+            const std::size_t tail = Fencing::load_peer(m_tail);
+            if constexpr (Index::cache_peer) {
+                m_cached_tail = tail;
+            }
+            std::size_t count = 0;
+            auto release = [&] {
+                if (count > 0) {
+                    m_stats.on_dequeue(count);
+                    Fencing::publish(m_head, head);
+                }
+            };
+            while (head != tail && count < max_items) {
+                try {
+                    fn(m_buffer[Index::slot(head, m_slots)]);
+                } catch (...) {
+                    release();
+                    throw;
+                }
+                head = Index::next(head, m_slots);
+                ++count;
+            }
+            release();
+            return count;
+        }
+
+        [[nodiscard]] std::size_t size_approx() const {
+            const std::size_t tail = m_tail.load(std::memory_order_acquire);
+            const std::size_t head = m_head.load(std::memory_order_acquire);
+            return Index::size(tail, head, m_slots);
+        }
+
+        [[nodiscard]] std::size_t capacity() const {
+            return Index::capacity(m_slots);
+        }
+
+        [[nodiscard]] const Stats &stats() const { return m_stats; }
+
+        [[nodiscard]] int head_impl() const {
+            return static_cast<int>(Index::slot(
+                    m_head.load(std::memory_order_acquire), m_slots));
+        }
+
+        [[nodiscard]] int tail_impl() const {
+            return static_cast<int>(Index::slot(
+                    m_tail.load(std::memory_order_acquire), m_slots));
+        }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_POLICY_QUEUE_IMPL_H
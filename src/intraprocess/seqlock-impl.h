@@ -0,0 +1,138 @@
+#ifndef INTRAPROCESS_SEQLOCK_IMPL_H
+#define INTRAPROCESS_SEQLOCK_IMPL_H
+
+#include "../detail/seqlock.h"
+#include "../ringbuffer-interface.h"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+/* A conflating "latest value" channel: enqueue() overwrites the single slot
+ * and never fails, so the writer never waits for readers, and readers only
+ * ever see the newest complete value. Meant for state such as best bid/ask,
+ * config or positions where intermediate updates do not matter.
+ *
+ * dequeue() returns true once per new value, for the one consumer that uses
+ * the IRingBuffer interface. Any number of other readers can call load() or
+ * load_if_newer() with their own version cursor.
+ */
+namespace RingBuffer::Intraprocess {
+    template<typename T>
+    class Seqlock : public IRingBuffer<Seqlock<T>, T> {
+    private:
+        Detail::SeqlockSlot<T> m_slot{};
+        // Version last handed out by dequeue(), owned by the consumer
+        std::uint64_t m_dequeued_version = 0;
+
+    public:
+        Seqlock() = default;
+
+        Seqlock(const Seqlock &) = delete;
+
+        Seqlock &operator=(const Seqlock &) = delete;
+
+        /// Publishes item, always succeeds. Only one writer at a time.
+        template<typename U>
+            requires std::assignable_from<T &, U>
+        bool enqueue_impl(U &&item) {
+            if constexpr (std::is_same_v<std::remove_cvref_t<U>, T>) {
+                Detail::seqlock_store(m_slot, item);
+            } else {
+                T value;
+                value = std::forward<U>(item);
+                Detail::seqlock_store(m_slot, value);
+            }
+            return true;
+        }
+
+        /// Reads the newest value if it was not dequeue()d yet.
+        bool dequeue_impl(T &item) {
+            return load_if_newer(item, m_dequeued_version);
+        }
+
+        /// Reads the newest value, retrying torn reads.
+        /// @return false if nothing was published yet
+        bool load(T &item) {
+            return Detail::seqlock_load(m_slot, item) != 0;
+        }
+
+        /// Reads the newest value if it is newer than last_version, then
+        /// advances last_version to it. Start with last_version = 0.
+        bool load_if_newer(T &item, std::uint64_t &last_version) {
+            if (Detail::seqlock_version(m_slot) == last_version)
+                return false;
+            const auto version = Detail::seqlock_load(m_slot, item);
+            if (version == last_version)
+                return false;
+            last_version = version;
+            return true;
+        }
+
+        /// Number of values published so far.
+        [[nodiscard]] std::uint64_t version() {
+            return Detail::seqlock_version(m_slot);
+        }
+
+        [[nodiscard]] int head_impl() const {
+            return static_cast<int>(m_dequeued_version);
+        }
+
+        [[nodiscard]] int tail_impl() {
+            return static_cast<int>(version());
+        }
+    };
+
+    /// An array of independently seqlocked slots, e.g., one per instrument
+    /// id, so that a single object carries thousands of latest values. Each
+    /// key has at most one writer at a time, different keys may be written
+    /// concurrently.
+    template<typename T>
+    class KeyedSeqlock {
+    private:
+        std::unique_ptr<Detail::SeqlockSlot<T>[]> m_slots;
+        std::size_t m_slot_count;
+
+        Detail::SeqlockSlot<T> &slot(const std::size_t key) const {
+            if (key >= m_slot_count)
+                throw std::out_of_range("KeyedSeqlock key out of range");
+            return m_slots[key];
+        }
+
+    public:
+        explicit KeyedSeqlock(const std::size_t slot_count) :
+            m_slots(std::make_unique<Detail::SeqlockSlot<T>[]>(slot_count)),
+            m_slot_count(slot_count) {}
+
+        void store(const std::size_t key, const T &value) {
+            Detail::seqlock_store(slot(key), value);
+        }
+
+        /// @return false if nothing was published under key yet
+        bool load(const std::size_t key, T &value) const {
+            return Detail::seqlock_load(slot(key), value) != 0;
+        }
+
+        /// See Seqlock::load_if_newer(), with one version cursor per key.
+        bool load_if_newer(const std::size_t key, T &value,
+                           std::uint64_t &last_version) const {
+            auto &s = slot(key);
+            if (Detail::seqlock_version(s) == last_version)
+                return false;
+            const auto version = Detail::seqlock_load(s, value);
+            if (version == last_version)
+                return false;
+            last_version = version;
+            return true;
+        }
+
+        [[nodiscard]] std::uint64_t version(const std::size_t key) const {
+            return Detail::seqlock_version(slot(key));
+        }
+
+        [[nodiscard]] std::size_t size() const { return m_slot_count; }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_SEQLOCK_IMPL_H
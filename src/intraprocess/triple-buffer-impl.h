@@ -0,0 +1,85 @@
+#ifndef INTRAPROCESS_TRIPLE_BUFFER_IMPL_H
+#define INTRAPROCESS_TRIPLE_BUFFER_IMPL_H
+
+#include <atomic>
+#include <cstdint>
+
+/* A lock-free triple buffer for handing large snapshots (order books, risk
+ * matrices) from one writer thread to one reader thread without copying
+ * them. Of the three buffers the writer owns one (back), the reader owns one
+ * (front) and the third (middle) is the hand-over point:
+ *
+ *   writer            middle            reader
+ *   +------+         +------+         +------+
+ *   | back | <-----> |      | <-----> |front |
+ *   +------+ publish +------+ refresh +------+
+ *
+ * publish() swaps back and middle and marks middle fresh, refresh() swaps
+ * middle and front if middle is fresh. Both are a single atomic exchange, so
+ * the writer always has a free buffer to fill and the reader always holds
+ * the most recent complete snapshot by reference; nobody waits and nothing
+ * is copied. Snapshots the reader did not pick up in time are overwritten.
+ */
+namespace RingBuffer::Intraprocess {
+    template<typename T>
+    class TripleBuffer {
+    private:
+        static constexpr std::uint8_t INDEX_MASK = 0b011;
+        static constexpr std::uint8_t FRESH = 0b100;
+
+        struct alignas(64) Slot {
+            T value;
+        };
+        Slot m_slots[3];
+        // Index of the middle buffer, plus FRESH if it holds a snapshot the
+        // reader has not picked up yet
+        alignas(64) std::atomic<std::uint8_t> m_middle{1};
+        // Owned by the writer and the reader respectively
+        alignas(64) std::uint8_t m_back = 0;
+        alignas(64) std::uint8_t m_front = 2;
+
+    public:
+        /// Constructs all three buffers from args, e.g., the dimensions of a
+        /// matrix, so that the writer never allocates while it fills them.
+        template<typename... Args>
+        explicit TripleBuffer(const Args &...args) :
+            m_slots{{T(args...)}, {T(args...)}, {T(args...)}} {}
+
+        TripleBuffer(const TripleBuffer &) = delete;
+
+        TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+        /// Writer side: the buffer to fill. It still holds whatever snapshot
+        /// it carried before, not necessarily the last one published.
+        T &back() { return m_slots[m_back].value; }
+
+        /// Writer side: hands back() over to the reader, never waits.
+        void publish() {
+            const auto prev_middle = m_middle.exchange(
+                    m_back | FRESH, std::memory_order_acq_rel);
+            m_back = prev_middle & INDEX_MASK;
+        }
+
+        /// Reader side: switches front() to the newest published snapshot.
+        /// @return false if nothing was published since the last refresh()
+        bool refresh() {
+            if (!(m_middle.load(std::memory_order_relaxed) & FRESH))
+                return false;
+            const auto prev_middle =
+                    m_middle.exchange(m_front, std::memory_order_acq_rel);
+            m_front = prev_middle & INDEX_MASK;
+            return true;
+        }
+
+        /// Reader side: the snapshot picked up by the last refresh(), stays
+        /// valid and unchanged until the next refresh().
+        const T &front() const { return m_slots[m_front].value; }
+
+        /// Whether a snapshot is waiting for refresh(), from either side.
+        [[nodiscard]] bool has_fresh() const {
+            return m_middle.load(std::memory_order_acquire) & FRESH;
+        }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_TRIPLE_BUFFER_IMPL_H
@@ -0,0 +1,166 @@
+#ifndef INTRAPROCESS_WORK_STEALING_DEQUE_IMPL_H
+#define INTRAPROCESS_WORK_STEALING_DEQUE_IMPL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/* Refer to
+ * - D. Chase, Y. Lev, "Dynamic Circular Work-Stealing Deque", SPAA 2005
+ * - N. M. Lê et al., "Correct and Efficient Work-Stealing for Weak Memory
+ *   Models", PPoPP 2013, whose C11 formulation is followed here
+ */
+
+/* A lock-free work-stealing deque: its owner thread pushes and pops at the
+ * bottom like a stack, any number of thieves steal from the top:
+ *
+ *            steal()                          push() / pop()
+ *               ↓                                  ↓
+ *          +----+----+----+----+----+----+----+----+
+ *          |    | T0 | T1 | T2 | T3 |    |    |    |
+ *          +----+----+----+----+----+----+----+----+
+ *                 ↑                   ↑
+ *                Top               Bottom
+ *
+ * top and bottom grow monotonically and are masked into a circular array.
+ * When the owner finds the array full it copies the live range into one of
+ * twice the size. Thieves may still be reading the old array, so retired
+ * arrays are only freed with the deque. Only the last element is contended:
+ * owner and thieves race for it with a CAS on top.
+ *
+ * T is read by thieves that may lose the race and discard it, so it must be
+ * trivially copyable, e.g., a pointer to a task.
+ */
+namespace RingBuffer::Intraprocess {
+    template<typename T>
+    class WorkStealingDeque {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "Thieves copy T racily, T must be trivially copyable");
+
+    private:
+        struct Array {
+            const std::int64_t capacity;
+            const std::int64_t mask;
+            std::unique_ptr<std::atomic<T>[]> slots;
+
+            explicit Array(const std::int64_t cap) :
+                capacity(cap), mask(cap - 1),
+                slots(std::make_unique<std::atomic<T>[]>(cap)) {}
+
+            T get(const std::int64_t idx) const {
+                return slots[idx & mask].load(std::memory_order_relaxed);
+            }
+
+            void put(const std::int64_t idx, const T &value) {
+                slots[idx & mask].store(value, std::memory_order_relaxed);
+            }
+        };
+
+        alignas(64) std::atomic<std::int64_t> m_top{0};
+        alignas(64) std::atomic<std::int64_t> m_bottom{0};
+        std::atomic<Array *> m_array;
+        // Owned by the owner thread: the live array and every array it
+        // replaced
+        std::vector<std::unique_ptr<Array>> m_arrays;
+
+        Array *grow(Array *array, const std::int64_t bottom,
+                    const std::int64_t top) {
+            auto bigger = std::make_unique<Array>(array->capacity * 2);
+            for (std::int64_t i = top; i < bottom; ++i) {
+                bigger->put(i, array->get(i));
+            }
+            array = bigger.get();
+            m_arrays.push_back(std::move(bigger));
+            m_array.store(array, std::memory_order_release);
+            return array;
+        }
+
+    public:
+        /// @param initial_capacity rounded up to a power of two, the deque
+        /// grows beyond it on demand
+        explicit WorkStealingDeque(const std::size_t initial_capacity = 1024) {
+            std::int64_t capacity = 2;
+            while (capacity < static_cast<std::int64_t>(initial_capacity)) {
+                capacity <<= 1;
+            }
+            m_arrays.push_back(std::make_unique<Array>(capacity));
+            m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque &) = delete;
+
+        WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+        /// Owner only, never fails.
+        void push(const T &value) {
+            const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            const std::int64_t top = m_top.load(std::memory_order_acquire);
+            Array *array = m_array.load(std::memory_order_relaxed);
+            if (bottom - top > array->capacity - 1)
+                array = grow(array, bottom, top);
+            array->put(bottom, value);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        /// Owner only: takes the most recently pushed element.
+        /// @return false if the deque is empty
+        bool pop(T &value) {
+            const std::int64_t bottom =
+                    m_bottom.load(std::memory_order_relaxed) - 1;
+            Array *array = m_array.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t top = m_top.load(std::memory_order_relaxed);
+            if (top > bottom) {
+                // Empty
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+            value = array->get(bottom);
+            if (top == bottom) {
+                // The last element, a thief may be after it as well
+                const bool won = m_top.compare_exchange_strong(
+                        top, top + 1, std::memory_order_seq_cst,
+                        std::memory_order_relaxed);
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /// Any thread: takes the oldest element.
+        /// @return false if the deque is empty or another thread took the
+        /// element first, in which case trying again (or another victim) may
+        /// succeed
+        bool steal(T &value) {
+            std::int64_t top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+            if (top >= bottom)
+                return false;
+            const Array *array = m_array.load(std::memory_order_acquire);
+            value = array->get(top);
+            return m_top.compare_exchange_strong(top, top + 1,
+                                                 std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::size_t size_approx() const {
+            const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+            const std::int64_t top = m_top.load(std::memory_order_acquire);
+            return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+        }
+
+        /// Capacity of the current array, doubles whenever push() finds it
+        /// full.
+        [[nodiscard]] std::size_t capacity() const {
+            return m_array.load(std::memory_order_acquire)->capacity;
+        }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_WORK_STEALING_DEQUE_IMPL_H
@@ -0,0 +1,236 @@
+#ifndef INTRAPROCESS_WORK_STEALING_POOL_IMPL_H
+#define INTRAPROCESS_WORK_STEALING_POOL_IMPL_H
+
+#include "../detail/platform.h"
+#include "work-stealing-deque-impl.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* A fork-join thread pool on top of WorkStealingDeque: every worker owns a
+ * deque, runs its own tasks newest first and steals the oldest tasks of a
+ * random victim when it runs dry, so big chunks of work migrate and small
+ * ones stay cache-local:
+ *
+ *   WorkStealingPool pool;
+ *   WorkStealingPool::TaskGroup group(pool);
+ *   group.run([&] { left = sum(lo, mid); });
+ *   right = sum(mid, hi);
+ *   group.wait(); // runs or steals other tasks meanwhile
+ *
+ * A task spawned by a worker goes to that worker's deque without any lock.
+ * Tasks submitted from other threads go through a mutex-protected injection
+ * queue, which workers check after their own deque. Idle workers spin, then
+ * yield, then nap for a few microseconds, so the pool costs little CPU when
+ * there is nothing to do.
+ */
+namespace RingBuffer::Intraprocess {
+    class WorkStealingPool {
+    private:
+        struct Job {
+            void (*run)(Job *);
+        };
+
+        struct alignas(64) Worker {
+            WorkStealingDeque<Job *> deque;
+            std::uint64_t rng;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::mutex m_injected_mutex;
+        std::deque<Job *> m_injected;
+        std::atomic<std::size_t> m_injected_count{0};
+        std::atomic<bool> m_stop{false};
+
+        static inline thread_local WorkStealingPool *tl_pool = nullptr;
+        static inline thread_local Worker *tl_worker = nullptr;
+
+        // xorshift64, cheap victim selection that needs no shared state
+        static std::uint64_t next_random(std::uint64_t &state) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+
+        void push(Job *job) {
+            if (tl_pool == this && tl_worker != nullptr) {
+                tl_worker->deque.push(job);
+                return;
+            }
+            std::lock_guard lock(m_injected_mutex);
+            m_injected.push_back(job);
+            m_injected_count.fetch_add(1, std::memory_order_release);
+        }
+
+        bool take_injected(Job *&job) {
+            if (m_injected_count.load(std::memory_order_acquire) == 0)
+                return false;
+            std::lock_guard lock(m_injected_mutex);
+            if (m_injected.empty())
+                return false;
+            job = m_injected.front();
+            m_injected.pop_front();
+            m_injected_count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool steal(Job *&job, std::uint64_t &rng) {
+            const std::size_t n = m_workers.size();
+            const std::size_t start = next_random(rng) % n;
+            for (std::size_t i = 0; i < n; ++i) {
+                Worker &victim = *m_workers[(start + i) % n];
+                if (&victim != tl_worker && victim.deque.steal(job))
+                    return true;
+            }
+            return false;
+        }
+
+        // Runs one task from wherever it can find one: the caller's own
+        // deque, the injection queue, or a random victim.
+        bool run_one(std::uint64_t &rng) {
+            Job *job;
+            if ((tl_pool == this && tl_worker != nullptr &&
+                 tl_worker->deque.pop(job)) ||
+                take_injected(job) || steal(job, rng)) {
+                job->run(job);
+                return true;
+            }
+            return false;
+        }
+
+        void worker_loop(Worker *self) {
+            tl_pool = this;
+            tl_worker = self;
+            unsigned idle = 0;
+            while (!m_stop.load(std::memory_order_acquire)) {
+                if (run_one(self->rng)) {
+                    idle = 0;
+                } else if (++idle < 64) {
+                    Detail::cpu_relax();
+                } else if (idle < 128) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+        }
+
+    public:
+        /// A set of tasks to wait for, e.g., the children of one fork.
+        class TaskGroup {
+        private:
+            template<typename F>
+            struct GroupJob : Job {
+                TaskGroup *group;
+                F fn;
+
+                GroupJob(TaskGroup *g, F &&f) :
+                    Job{&GroupJob::execute}, group(g), fn(std::move(f)) {}
+
+                static void execute(Job *job) {
+                    const auto self = static_cast<GroupJob *>(job);
+                    TaskGroup *group = self->group;
+                    try {
+                        self->fn();
+                    } catch (...) {
+                        group->record_exception(std::current_exception());
+                    }
+                    delete self;
+                    group->m_pending.fetch_sub(1, std::memory_order_release);
+                }
+            };
+
+            WorkStealingPool &m_pool;
+            std::atomic<std::size_t> m_pending{0};
+            std::mutex m_exception_mutex;
+            std::exception_ptr m_exception;
+
+            void record_exception(std::exception_ptr e) {
+                std::lock_guard lock(m_exception_mutex);
+                if (!m_exception)
+                    m_exception = std::move(e);
+            }
+
+        public:
+            explicit TaskGroup(WorkStealingPool &pool) : m_pool(pool) {}
+
+            TaskGroup(const TaskGroup &) = delete;
+
+            TaskGroup &operator=(const TaskGroup &) = delete;
+
+            ~TaskGroup() {
+                // Tasks reference the group, never leave them behind
+                std::uint64_t rng = reinterpret_cast<std::uintptr_t>(this) | 1;
+                while (m_pending.load(std::memory_order_acquire) > 0) {
+                    if (!m_pool.run_one(rng))
+                        std::this_thread::yield();
+                }
+            }
+
+            /// Schedules fn, which may run on any worker and may itself run
+            /// further tasks.
+            template<typename F>
+            void run(F &&fn) {
+                m_pending.fetch_add(1, std::memory_order_relaxed);
+                m_pool.push(new GroupJob<std::decay_t<F>>(
+                        this, std::decay_t<F>(std::forward<F>(fn))));
+            }
+
+            /// Runs pool tasks until every task of this group has finished,
+            /// then rethrows the first exception one of them threw.
+            void wait() {
+                std::uint64_t rng = reinterpret_cast<std::uintptr_t>(this) | 1;
+                while (m_pending.load(std::memory_order_acquire) > 0) {
+                    if (!m_pool.run_one(rng))
+                        Detail::cpu_relax();
+                }
+                if (m_exception)
+                    std::rethrow_exception(std::exchange(m_exception, nullptr));
+            }
+        };
+
+        explicit WorkStealingPool(
+                const std::size_t threads = std::thread::hardware_concurrency()) {
+            const std::size_t n = threads > 0 ? threads : 1;
+            for (std::size_t i = 0; i < n; ++i) {
+                m_workers.push_back(std::make_unique<Worker>());
+                m_workers.back()->rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+            }
+            // Start only once every deque exists, workers steal from all
+            for (auto &worker: m_workers) {
+                worker->thread =
+                        std::thread(&WorkStealingPool::worker_loop, this,
+                                    worker.get());
+            }
+        }
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        /// Tasks still queued are dropped, wait for their groups first.
+        ~WorkStealingPool() {
+            m_stop.store(true, std::memory_order_release);
+            for (auto &worker: m_workers) {
+                worker->thread.join();
+            }
+        }
+
+        [[nodiscard]] std::size_t thread_count() const {
+            return m_workers.size();
+        }
+    };
+} // namespace RingBuffer::Intraprocess
+
+#endif // INTRAPROCESS_WORK_STEALING_POOL_IMPL_H
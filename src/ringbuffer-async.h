@@ -0,0 +1,259 @@
+#ifndef RINGBUFFER_ASYNC_H
+#define RINGBUFFER_ASYNC_H
+
+#include "ringbuffer-interface.h"
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* Coroutine adapters for the ring buffers: co_await async_dequeue(q, item)
+ * and co_await async_enqueue(q, item) complete immediately if the queue is
+ * ready and otherwise suspend the calling Task until a retry succeeds.
+ *
+ * A Scheduler runs any number of Tasks on the thread that calls run(). A
+ * suspended operation parks itself in an intrusive list inside its own
+ * awaiter, i.e., inside the coroutine frame, and the scheduler retries every
+ * parked operation after each round of resumed tasks. Neither path allocates
+ * and the fast path does not even suspend. The peer may be another Task on
+ * the same scheduler, a thread or a process: parked operations are simply
+ * retried until it makes progress.
+ *
+ *   Scheduler sched;
+ *   sched.spawn([](auto &q) -> Task {
+ *     std::string msg;
+ *     while (true) {
+ *       co_await async_dequeue(q, msg);
+ *       handle(msg);
+ *     }
+ *   }(q));
+ *   sched.run();
+ */
+namespace RingBuffer {
+
+class Scheduler;
+
+namespace Detail {
+// A suspended queue operation, embedded in its awaiter
+struct ParkedOperation {
+  ParkedOperation *next = nullptr;
+  bool (*try_complete)(ParkedOperation *) = nullptr;
+  std::coroutine_handle<> handle;
+};
+} // namespace Detail
+
+/// A coroutine run by a Scheduler. It starts suspended and is destroyed when
+/// it finishes, an exception escaping it is rethrown by Scheduler::run().
+class Task {
+public:
+  struct promise_type {
+    Scheduler *scheduler = nullptr;
+
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void return_void();
+
+    void unhandled_exception();
+  };
+
+  explicit Task(const std::coroutine_handle<promise_type> handle)
+      : m_handle(handle) {}
+
+  Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+
+  Task(const Task &) = delete;
+
+  Task &operator=(const Task &) = delete;
+
+  Task &operator=(Task &&) = delete;
+
+  // A Task that was never spawned never ran, so its frame is still ours
+  ~Task() {
+    if (m_handle)
+      m_handle.destroy();
+  }
+
+private:
+  friend class Scheduler;
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+/// Runs Tasks cooperatively on the thread calling run(). Not thread-safe:
+/// only that thread may spawn() or run().
+class Scheduler {
+private:
+  std::vector<std::coroutine_handle<>> m_ready;
+  std::vector<std::coroutine_handle<>> m_running;
+  Detail::ParkedOperation *m_parked_head = nullptr;
+  Detail::ParkedOperation *m_parked_tail = nullptr;
+  std::size_t m_live_tasks = 0;
+  std::size_t m_suspensions = 0;
+  std::exception_ptr m_exception;
+
+  friend struct Task::promise_type;
+
+  // Retries parked operations in the order they parked, completed ones are
+  // unlinked and their tasks become ready.
+  bool poll_parked() {
+    bool progressed = false;
+    Detail::ParkedOperation *prev = nullptr;
+    auto *op = m_parked_head;
+    while (op != nullptr) {
+      auto *next = op->next;
+      if (op->try_complete(op)) {
+        (prev == nullptr ? m_parked_head : prev->next) = next;
+        if (op == m_parked_tail)
+          m_parked_tail = prev;
+        m_ready.push_back(op->handle);
+        progressed = true;
+      } else {
+        prev = op;
+      }
+      op = next;
+    }
+    return progressed;
+  }
+
+public:
+  Scheduler() = default;
+
+  Scheduler(const Scheduler &) = delete;
+
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  // Tasks that never finished are still suspended and their frames are ours.
+  // A parked operation lives inside its task's frame, so read next first.
+  ~Scheduler() {
+    for (const auto handle : m_ready) {
+      handle.destroy();
+    }
+    auto *op = m_parked_head;
+    while (op != nullptr) {
+      auto *next = op->next;
+      op->handle.destroy();
+      op = next;
+    }
+  }
+
+  void spawn(Task task) {
+    auto handle = std::exchange(task.m_handle, {});
+    handle.promise().scheduler = this;
+    m_ready.push_back(handle);
+    ++m_live_tasks;
+  }
+
+  void park(Detail::ParkedOperation *op) {
+    op->next = nullptr;
+    if (m_parked_tail == nullptr)
+      m_parked_head = op;
+    else
+      m_parked_tail->next = op;
+    m_parked_tail = op;
+    ++m_suspensions;
+  }
+
+  /// Resumes every ready task once, then retries parked operations.
+  /// @return false if nothing made progress, i.e., every task waits for a
+  /// peer outside this scheduler
+  bool run_once() {
+    m_running.swap(m_ready);
+    for (const auto handle : m_running) {
+      handle.resume();
+    }
+    const bool resumed = !m_running.empty();
+    m_running.clear();
+    if (m_exception)
+      std::rethrow_exception(std::exchange(m_exception, nullptr));
+    return poll_parked() || resumed;
+  }
+
+  /// Runs until every spawned task has finished, yielding the thread while
+  /// all of them wait for peers outside this scheduler.
+  void run() {
+    while (m_live_tasks > 0) {
+      if (!run_once())
+        std::this_thread::yield();
+    }
+  }
+
+  [[nodiscard]] std::size_t live_tasks() const { return m_live_tasks; }
+
+  /// How many co_awaits had to suspend so far, the rest completed on the
+  /// fast path.
+  [[nodiscard]] std::size_t suspensions() const { return m_suspensions; }
+};
+
+inline void Task::promise_type::return_void() { --scheduler->m_live_tasks; }
+
+inline void Task::promise_type::unhandled_exception() {
+  --scheduler->m_live_tasks;
+  scheduler->m_exception = std::current_exception();
+}
+
+namespace Detail {
+template <typename Derived> struct QueueAwaiter : ParkedOperation {
+  bool await_ready() { return static_cast<Derived *>(this)->try_once(); }
+
+  void await_suspend(const std::coroutine_handle<Task::promise_type> caller) {
+    handle = caller;
+    this->try_complete = [](ParkedOperation *op) {
+      return static_cast<Derived *>(op)->try_once();
+    };
+    caller.promise().scheduler->park(this);
+  }
+
+  void await_resume() const noexcept {}
+};
+
+template <typename TImpl, typename T>
+struct DequeueAwaiter : QueueAwaiter<DequeueAwaiter<TImpl, T>> {
+  IRingBuffer<TImpl, T> &queue;
+  T &item;
+
+  DequeueAwaiter(IRingBuffer<TImpl, T> &queue, T &item)
+      : queue(queue), item(item) {}
+
+  bool try_once() { return queue.dequeue(item); }
+};
+
+template <typename TImpl, typename T, typename U>
+struct EnqueueAwaiter : QueueAwaiter<EnqueueAwaiter<TImpl, T, U>> {
+  IRingBuffer<TImpl, T> &queue;
+  U &&item;
+
+  EnqueueAwaiter(IRingBuffer<TImpl, T> &queue, U &&item)
+      : queue(queue), item(std::forward<U>(item)) {}
+
+  // The queues leave item untouched when they are full, so it may be
+  // forwarded again on every retry
+  bool try_once() { return queue.enqueue(std::forward<U>(item)); }
+};
+} // namespace Detail
+
+/// co_await from a Task: dequeues into item, suspending while q is empty.
+template <typename TImpl, typename T>
+[[nodiscard]] Detail::DequeueAwaiter<TImpl, T>
+async_dequeue(IRingBuffer<TImpl, T> &q, T &item) {
+  return {q, item};
+}
+
+/// co_await from a Task: enqueues item, suspending while q is full. item
+/// must outlive the co_await, which a temporary in the same statement does.
+template <typename TImpl, typename T, typename U>
+[[nodiscard]] Detail::EnqueueAwaiter<TImpl, T, U>
+async_enqueue(IRingBuffer<TImpl, T> &q, U &&item) {
+  return {q, std::forward<U>(item)};
+}
+
+} // namespace RingBuffer
+
+#endif // RINGBUFFER_ASYNC_H
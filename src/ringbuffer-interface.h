@@ -1,7 +1,9 @@
 #ifndef RINGBUFFER_INTERFACE_H
 #define RINGBUFFER_INTERFACE_H
 
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -13,11 +15,15 @@ public:
   ~IRingBuffer() = default;
 
   ///
-  /// @tparam U a dummy template to enable forwarding reference
+  /// @tparam U a dummy template to enable forwarding reference, accepted
+  /// types are up to the implementation, e.g., interprocess queues take any
+  /// contiguous byte sequence, not just T
   /// @param item data will be std::move()ed or copied from item to the queue
   /// @return true if item was enqueued, false if queue is full
   template <typename U>
-    requires std::assignable_from<T &, U>
+    requires requires(TImpl &impl, U &&u) {
+      impl.enqueue_impl(std::forward<U>(u));
+    }
   bool enqueue(U &&item) {
     // TODO: make sure perfect forwarding works as expected
     return static_cast<TImpl *>(this)->enqueue_impl(std::forward<U>(item));
@@ -30,6 +36,41 @@ public:
     return static_cast<TImpl *>(this)->dequeue_impl(item);
   }
 
+  ///
+  /// Drains up to max_items elements in one sweep: fn is called on each
+  /// element in place (T& for intraprocess queues, std::span<const std::byte>
+  /// for interprocess ones) and the consumed elements are handed back to the
+  /// producer with a single index store at the end. Elements are only valid
+  /// for the duration of the call to fn. Queues without a native sweep fall
+  /// back to calling dequeue() in a loop.
+  ///
+  /// If fn throws, the elements it returned from are handed back to the
+  /// producer before the exception propagates, and the element it threw on
+  /// stays in the queue for the next call. Every native sweep behaves like
+  /// this; the fallback has already dequeued that element, so it is lost.
+  /// @return number of elements passed to fn
+  template <typename F>
+  std::size_t consume_up_to(const std::size_t max_items, F &&fn) {
+    auto &impl = *static_cast<TImpl *>(this);
+    if constexpr (requires { impl.consume_up_to_impl(max_items, fn); }) {
+      return impl.consume_up_to_impl(max_items, fn);
+    } else {
+      T item;
+      std::size_t count = 0;
+      while (count < max_items && impl.dequeue_impl(item)) {
+        fn(item);
+        ++count;
+      }
+      return count;
+    }
+  }
+
+  ///
+  /// consume_up_to() without a limit, i.e., everything published so far.
+  template <typename F> std::size_t consume_all(F &&fn) {
+    return consume_up_to(std::numeric_limits<std::size_t>::max(), fn);
+  }
+
   int head() { return static_cast<TImpl *>(this)->head_impl(); }
 
   int tail() { return static_cast<TImpl *>(this)->tail_impl(); }
@@ -0,0 +1,104 @@
+#include "../interprocess/blob-arena-impl.h"
+#include "../interprocess/spsc-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer::Interprocess;
+
+TEST(InterprocessBlobArena, RecyclesBlocksWithinTheirSizeClass) {
+  auto arena = BlobArena("RecyclesBlocks", true, 1 << 20);
+  BlobHandle small;
+  ASSERT_TRUE(arena.write(std::string(100, 'a'), small));
+  EXPECT_EQ(small.size, 100);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(arena.data(small).data()) % 64,
+            0);
+  EXPECT_EQ(std::string(reinterpret_cast<const char *>(
+                            arena.data(small).data()),
+                        small.size),
+            std::string(100, 'a'));
+
+  BlobHandle large;
+  ASSERT_TRUE(arena.allocate(100'000, large));
+  EXPECT_NE(large.offset, small.offset);
+  const std::size_t carved = arena.carved_bytes();
+
+  arena.release(small);
+  EXPECT_THROW(arena.release(small), std::logic_error);
+  // Same class: the released block comes back, nothing new is carved
+  BlobHandle again;
+  ASSERT_TRUE(arena.allocate(150, again));
+  EXPECT_EQ(again.offset, small.offset);
+  EXPECT_EQ(arena.carved_bytes(), carved);
+  arena.release(again);
+  arena.release(large);
+}
+
+TEST(InterprocessBlobArena, RejectsWhatDoesNotFit) {
+  auto arena = BlobArena("RejectsWhatDoesNotFit", true, 64 << 10);
+  BlobHandle handle;
+  EXPECT_FALSE(arena.allocate(64 << 10, handle));
+  ASSERT_TRUE(arena.allocate(20'000, handle));
+  ASSERT_TRUE(arena.allocate(20'000, handle));
+  // Both 32 KiB blocks are taken
+  BlobHandle third{};
+  EXPECT_FALSE(arena.allocate(20'000, third));
+  arena.release(handle);
+  EXPECT_TRUE(arena.allocate(20'000, third));
+
+  EXPECT_THROW((void) arena.data({arena.capacity(), 1}), std::out_of_range);
+  EXPECT_THROW((void) arena.data({third.offset, 40'000}), std::out_of_range);
+  EXPECT_THROW(BlobArena("RejectsWhatDoesNotFit", false, 1 << 20),
+               std::runtime_error);
+}
+
+TEST(InterprocessBlobArena, HandlesCrossProcessesThroughAQueue) {
+  constexpr int blobs = 50;
+  constexpr std::size_t blob_size = 3 << 20;
+  // Room for two blobs at a time: the producer depends on the consumer
+  // releasing them
+  auto arena = BlobArena("HandlesCross", true, 2 * (4 << 20));
+  auto q = SpscQueue("HandlesCrossQueue", true, 1024);
+  if (const pid_t pid = fork(); pid == 0) {
+    auto producer_arena = BlobArena("HandlesCross");
+    auto producer_q = SpscQueue("HandlesCrossQueue");
+    for (int i = 0; i < blobs; ++i) {
+      BlobHandle handle;
+      while (!producer_arena.allocate(blob_size, handle)) {
+        std::this_thread::yield();
+      }
+      std::memset(producer_arena.data(handle).data(), i, blob_size);
+      while (!producer_q.enqueue(std::as_bytes(std::span(&handle, 1)))) {
+        std::this_thread::yield();
+      }
+    }
+    _exit(0);
+  } else {
+    std::string msg;
+    for (int i = 0; i < blobs; ++i) {
+      while (!q.dequeue(msg)) {
+        std::this_thread::yield();
+      }
+      ASSERT_EQ(msg.size(), sizeof(BlobHandle));
+      BlobHandle handle;
+      std::memcpy(&handle, msg.data(), sizeof(handle));
+      const auto blob = arena.data(handle);
+      ASSERT_EQ(blob.size(), blob_size);
+      EXPECT_EQ(blob.front(), std::byte(i));
+      EXPECT_EQ(blob.back(), std::byte(i));
+      arena.release(handle);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+  }
+  EXPECT_LE(arena.carved_bytes(), arena.capacity());
+}
@@ -0,0 +1,252 @@
+#include "../interprocess/broadcast-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Interprocess;
+
+TEST(InterprocessBroadcastQueue, EverySubscriberSeesEveryMessage) {
+  auto pub = BroadcastQueue("EverySubscriberSeesEveryMessage", true, 4096);
+  auto sub1 = BroadcastQueue("EverySubscriberSeesEveryMessage");
+  auto sub2 = BroadcastQueue("EverySubscriberSeesEveryMessage");
+  EXPECT_EQ(pub.subscriber_count(), 2);
+
+  std::string payload;
+  EXPECT_FALSE(sub1.dequeue(payload));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(pub.enqueue("Hello world!" + std::to_string(i)));
+  }
+  for (auto *sub : {&sub1, &sub2}) {
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_TRUE(sub->dequeue(payload));
+      EXPECT_EQ(payload, "Hello world!" + std::to_string(i));
+    }
+    EXPECT_FALSE(sub->dequeue(payload));
+    EXPECT_EQ(sub->overruns(), 0);
+  }
+}
+
+TEST(InterprocessBroadcastQueue, BlockOnSlowestWaitsForEverySubscriber) {
+  constexpr int sz = (sizeof(int) + 8) * 4;
+  auto pub = BroadcastQueue("BlockOnSlowest", true, sz);
+  // Without subscribers nothing holds the producer back
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(pub.enqueue(std::string(8, 'x')));
+  }
+  auto fast = BroadcastQueue("BlockOnSlowest");
+  auto slow = BroadcastQueue("BlockOnSlowest");
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(pub.enqueue(std::string(8, 'a' + i)));
+  }
+  EXPECT_FALSE(pub.enqueue(std::string(8, 'e')));
+
+  std::string payload;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(fast.dequeue(payload));
+  }
+  EXPECT_FALSE(pub.enqueue(std::string(8, 'e')));
+  EXPECT_TRUE(slow.dequeue(payload));
+  EXPECT_EQ(payload, std::string(8, 'a'));
+  EXPECT_TRUE(pub.enqueue(std::string(8, 'e')));
+
+  // A subscriber that leaves no longer holds the producer back
+  { auto leaving = BroadcastQueue("BlockOnSlowest"); }
+  slow.dispose();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(fast.dequeue(payload));
+    EXPECT_TRUE(pub.enqueue(std::string(8, 'f')));
+  }
+}
+
+TEST(InterprocessBroadcastQueue, ReapsSubscribersThatDied) {
+  constexpr int sz = 64;
+  auto pub = BroadcastQueue("ReapsSubscribersThatDied", true, sz);
+  if (const pid_t pid = fork(); pid == 0) {
+    // Register, then die without unregistering
+    auto sub = BroadcastQueue("ReapsSubscribersThatDied");
+    _exit(0);
+  } else {
+    waitpid(pid, nullptr, 0);
+  }
+  EXPECT_EQ(pub.subscriber_count(), 1);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(pub.enqueue(std::string(8, 'x')));
+  }
+  EXPECT_EQ(pub.subscriber_count(), 0);
+}
+
+TEST(InterprocessBroadcastQueue, OverwriteSlowestDetectsOverruns) {
+  constexpr int sz = 256;
+  auto pub = BroadcastQueue("OverwriteSlowest", true, sz,
+                            BroadcastPolicy::OverwriteSlowest);
+  auto sub = BroadcastQueue("OverwriteSlowest");
+  EXPECT_EQ(sub.policy(), BroadcastPolicy::OverwriteSlowest);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(pub.enqueue(std::to_string(i)));
+  }
+  std::string payload;
+  EXPECT_TRUE(sub.dequeue(payload));
+  EXPECT_EQ(sub.overruns(), 1);
+  // Whatever survived is still in order and ends with the newest message
+  int prev = std::stoi(payload);
+  while (sub.dequeue(payload)) {
+    EXPECT_EQ(std::stoi(payload), prev + 1);
+    prev = std::stoi(payload);
+  }
+  EXPECT_EQ(prev, 999);
+}
+
+TEST(InterprocessBroadcastQueue, ConsumeUpToSweepsUnderBothPolicies) {
+  for (const auto policy : {BroadcastPolicy::BlockOnSlowest,
+                            BroadcastPolicy::OverwriteSlowest}) {
+    const std::string name =
+        "ConsumeUpTo" + std::to_string(static_cast<int>(policy));
+    auto pub = BroadcastQueue(name, true, 256, policy);
+    auto sub = BroadcastQueue(name);
+    int next_out = 0;
+    auto expect_next = [&](const std::span<const std::byte> msg) {
+      EXPECT_EQ(std::string_view(reinterpret_cast<const char *>(msg.data()),
+                                 msg.size()),
+                std::to_string(next_out++));
+    };
+    for (int round = 0; round < 100; ++round) {
+      for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(pub.enqueue(std::to_string(round * 10 + i)));
+      }
+      EXPECT_EQ(sub.consume_up_to(4, expect_next), 4);
+      EXPECT_EQ(sub.consume_all(expect_next), 6);
+      EXPECT_EQ(sub.consume_all(expect_next), 0);
+    }
+    EXPECT_EQ(sub.overruns(), 0);
+    EXPECT_EQ(sub.head(), sub.tail());
+  }
+}
+
+TEST(InterprocessBroadcastQueue, ConsumeUpToKeepsTheMessageFnThrewOn) {
+  for (const auto policy : {BroadcastPolicy::BlockOnSlowest,
+                            BroadcastPolicy::OverwriteSlowest}) {
+    const std::string name =
+        "ConsumeUpToThrows" + std::to_string(static_cast<int>(policy));
+    auto pub = BroadcastQueue(name, true, 256, policy);
+    auto sub = BroadcastQueue(name);
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_TRUE(pub.enqueue(std::to_string(i)));
+    }
+    std::vector<std::string> taken;
+    EXPECT_THROW(sub.consume_all([&](const std::span<const std::byte> msg) {
+      std::string payload(reinterpret_cast<const char *>(msg.data()),
+                          msg.size());
+      if (payload == "2")
+        throw std::runtime_error("stop");
+      taken.push_back(std::move(payload));
+    }), std::runtime_error);
+    EXPECT_EQ(taken, (std::vector<std::string>{"0", "1"}));
+    std::string payload;
+    EXPECT_TRUE(sub.dequeue(payload));
+    EXPECT_EQ(payload, "2");
+    EXPECT_EQ(sub.consume_all([](std::span<const std::byte>) {}), 2);
+  }
+}
+
+TEST(InterprocessBroadcastQueue, ConcurrentProduceAndConsume) {
+  constexpr int iter_size = 2'000'000;
+  constexpr int subscriber_count = 3;
+  auto pub = BroadcastQueue("BroadcastConcurrentProduceAndConsume", true, 1024);
+  std::vector<std::unique_ptr<BroadcastQueue>> subs;
+  for (int i = 0; i < subscriber_count; ++i) {
+    subs.emplace_back(std::make_unique<BroadcastQueue>(
+        "BroadcastConcurrentProduceAndConsume"));
+  }
+  std::vector<std::thread> consumers;
+  for (auto &sub : subs) {
+    consumers.emplace_back([&sub] {
+      int dequeue_count = 0;
+      while (dequeue_count < iter_size) {
+        if (std::string payload; sub->dequeue(payload)) {
+          EXPECT_EQ(payload, std::to_string(dequeue_count));
+          ++dequeue_count;
+        }
+      }
+      EXPECT_EQ(sub->overruns(), 0);
+    });
+  }
+  std::thread thread_producer([&] {
+    int enqueue_count = 0;
+    while (enqueue_count < iter_size) {
+      if (pub.enqueue(std::to_string(enqueue_count)))
+        ++enqueue_count;
+    }
+  });
+  thread_producer.join();
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+}
+
+TEST(InterprocessBroadcastQueue, ConcurrentLateJoinersNeverOverrun) {
+  auto pub = BroadcastQueue("BroadcastConcurrentLateJoiners", true, 256);
+  std::atomic<bool> done = false;
+  std::thread thread_producer([&] {
+    for (int i = 0; !done.load(); ) {
+      if (pub.enqueue(std::to_string(i)))
+        ++i;
+    }
+  });
+  // Each subscriber joins while the producer runs and must read a gapless
+  // sequence, whichever message it starts at
+  for (int round = 0; round < 200; ++round) {
+    auto sub = BroadcastQueue("BroadcastConcurrentLateJoiners");
+    int expected = -1;
+    int received = 0;
+    while (received < 500) {
+      sub.consume_up_to(16, [&](const std::span<const std::byte> msg) {
+        const int value = std::stoi(std::string(
+            reinterpret_cast<const char *>(msg.data()), msg.size()));
+        if (expected >= 0) {
+          EXPECT_EQ(value, expected);
+        }
+        expected = value + 1;
+        ++received;
+      });
+    }
+    EXPECT_EQ(sub.overruns(), 0);
+  }
+  done = true;
+  thread_producer.join();
+}
+
+TEST(InterprocessBroadcastQueue, ConcurrentLossySubscriberStaysInOrder) {
+  constexpr int iter_size = 2'000'000;
+  auto pub = BroadcastQueue("BroadcastConcurrentLossy", true, 512,
+                            BroadcastPolicy::OverwriteSlowest);
+  auto sub = BroadcastQueue("BroadcastConcurrentLossy");
+  std::atomic<bool> done = false;
+  std::thread thread_consumer([&] {
+    int prev = -1;
+    std::string payload;
+    while (true) {
+      if (!sub.dequeue(payload)) {
+        if (done.load())
+          break;
+        continue;
+      }
+      const int msg = std::stoi(payload);
+      EXPECT_GT(msg, prev);
+      prev = msg;
+    }
+  });
+  for (int i = 0; i < iter_size; ++i) {
+    EXPECT_TRUE(pub.enqueue(std::to_string(i)));
+  }
+  done = true;
+  thread_consumer.join();
+}
@@ -0,0 +1,230 @@
+#include "../interprocess/journal-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Interprocess;
+
+namespace {
+std::string fresh_journal_dir(const std::string &name) {
+  const auto dir = std::filesystem::temp_directory_path() /
+                   ("lockfree-toolkit-" + name);
+  std::filesystem::remove_all(dir);
+  return dir.string();
+}
+} // namespace
+
+TEST(InterprocessJournalQueue, SingleThreadBasicProduceThenConsume) {
+  const auto dir = fresh_journal_dir("SingleThreadBasicProduceThenConsume");
+  auto writer = JournalQueue(dir, true, 4096);
+  auto reader = JournalQueue(dir, false);
+
+  std::string payload;
+  EXPECT_FALSE(reader.dequeue(payload));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(writer.enqueue("Hello world!" + std::to_string(i)));
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(reader.dequeue(payload));
+    EXPECT_EQ(payload, "Hello world!" + std::to_string(i));
+  }
+  EXPECT_FALSE(reader.dequeue(payload));
+}
+
+TEST(InterprocessJournalQueue, RollsSegmentsAndRejectsOversizedMessages) {
+  const auto dir = fresh_journal_dir("RollsSegments");
+  constexpr std::uint64_t segment_size = 64;
+  auto writer = JournalQueue(dir, true, segment_size);
+  auto reader = JournalQueue(dir, false);
+
+  EXPECT_FALSE(writer.enqueue(std::string(segment_size, 'x')));
+  constexpr int iter_size = 1000;
+  for (int i = 0; i < iter_size; ++i) {
+    EXPECT_TRUE(writer.enqueue(std::to_string(i)));
+  }
+  EXPECT_GT(writer.cursor_segment(), 10);
+
+  std::string payload;
+  for (int i = 0; i < iter_size; ++i) {
+    EXPECT_TRUE(reader.dequeue(payload));
+    EXPECT_EQ(payload, std::to_string(i));
+  }
+  EXPECT_FALSE(reader.dequeue(payload));
+  EXPECT_EQ(reader.cursor_segment(), writer.cursor_segment());
+
+  writer.remove_segments_before(reader.cursor_segment());
+  EXPECT_TRUE(writer.enqueue(std::string("after purge")));
+  EXPECT_TRUE(reader.dequeue(payload));
+  EXPECT_EQ(payload, "after purge");
+}
+
+TEST(InterprocessJournalQueue, ConsumeAllCrossesSegments) {
+  const auto dir = fresh_journal_dir("ConsumeAllCrossesSegments");
+  auto writer = JournalQueue(dir, true, 64);
+  auto reader = JournalQueue(dir, false);
+
+  constexpr int iter_size = 1000;
+  for (int i = 0; i < iter_size; ++i) {
+    EXPECT_TRUE(writer.enqueue(std::to_string(i)));
+  }
+  int next_out = 0;
+  auto expect_next = [&](const std::span<const std::byte> msg) {
+    EXPECT_EQ(std::string_view(reinterpret_cast<const char *>(msg.data()),
+                               msg.size()),
+              std::to_string(next_out++));
+  };
+  EXPECT_EQ(reader.consume_up_to(10, expect_next), 10);
+  EXPECT_EQ(reader.consume_all(expect_next), iter_size - 10);
+  EXPECT_EQ(reader.consume_all(expect_next), 0);
+  EXPECT_EQ(reader.cursor_segment(), writer.cursor_segment());
+
+  // The durable cursor survives a restart after a sweep
+  EXPECT_TRUE(writer.enqueue(std::string("after sweep")));
+  auto restarted = JournalQueue(dir, false);
+  std::string payload;
+  EXPECT_TRUE(restarted.dequeue(payload));
+  EXPECT_EQ(payload, "after sweep");
+}
+
+TEST(InterprocessJournalQueue, ConsumeUpToKeepsTheRecordFnThrewOn) {
+  const auto dir = fresh_journal_dir("ConsumeUpToThrows");
+  auto writer = JournalQueue(dir, true, 4096);
+  auto reader = JournalQueue(dir, false);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(writer.enqueue(std::to_string(i)));
+  }
+  std::vector<std::string> taken;
+  EXPECT_THROW(reader.consume_all([&](const std::span<const std::byte> msg) {
+    std::string payload(reinterpret_cast<const char *>(msg.data()),
+                        msg.size());
+    if (payload == "2")
+      throw std::runtime_error("stop");
+    taken.push_back(std::move(payload));
+  }), std::runtime_error);
+  EXPECT_EQ(taken, (std::vector<std::string>{"0", "1"}));
+  // The durable cursor points at "2", a restarted reader starts there too
+  std::string payload;
+  EXPECT_TRUE(JournalQueue(dir, false).dequeue(payload));
+  EXPECT_EQ(payload, "2");
+  EXPECT_TRUE(reader.dequeue(payload));
+  EXPECT_EQ(payload, "3");
+}
+
+TEST(InterprocessJournalQueue, RestartedEndpointsResumeFromDurableState) {
+  const auto dir = fresh_journal_dir("RestartedEndpoints");
+  std::string payload;
+  {
+    auto writer = JournalQueue(dir, true, 256);
+    for (int i = 0; i < 50; ++i) {
+      EXPECT_TRUE(writer.enqueue(std::to_string(i)));
+    }
+    auto reader = JournalQueue(dir, false, 0, "replay");
+    for (int i = 0; i < 20; ++i) {
+      EXPECT_TRUE(reader.dequeue(payload));
+      EXPECT_EQ(payload, std::to_string(i));
+    }
+    EXPECT_TRUE(reader.checkpoint());
+    EXPECT_TRUE(writer.checkpoint());
+  }
+  // Both endpoints "crash" and come back, past a stray file that is no
+  // segment
+  std::ofstream(std::filesystem::path(dir) / "notes.journal") << "not ours";
+  auto writer = JournalQueue(dir, true);
+  for (int i = 50; i < 100; ++i) {
+    EXPECT_TRUE(writer.enqueue(std::to_string(i)));
+  }
+  auto reader = JournalQueue(dir, false, 0, "replay");
+  for (int i = 20; i < 100; ++i) {
+    EXPECT_TRUE(reader.dequeue(payload));
+    EXPECT_EQ(payload, std::to_string(i));
+  }
+  EXPECT_FALSE(reader.dequeue(payload));
+
+  // A reader with a different cursor replays the whole journal
+  auto other_reader = JournalQueue(dir, false, 0, "other");
+  EXPECT_TRUE(other_reader.dequeue(payload));
+  EXPECT_EQ(payload, "0");
+  writer.remove_segments_before(0);
+  EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(dir) /
+                                      "notes.journal"));
+}
+
+TEST(InterprocessJournalQueue, RestartedWriterRepairsAnInterruptedRoll) {
+  const auto dir = fresh_journal_dir("RestartedWriterRepairs");
+  std::uint64_t last;
+  {
+    auto writer = JournalQueue(dir, true, 64);
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_TRUE(writer.enqueue(std::to_string(i)));
+    }
+    last = writer.cursor_segment();
+  }
+  // The writer "crashed" while rolling to the next segment: the current one
+  // is not sealed yet and the next one is still a zero-filled file
+  const auto segment_path = [&](const std::uint64_t sequence) {
+    std::ostringstream oss;
+    oss << std::setw(20) << std::setfill('0') << sequence << ".journal";
+    return std::filesystem::path(dir) / oss.str();
+  };
+  ASSERT_TRUE(std::filesystem::exists(segment_path(last)));
+  std::filesystem::copy_file(segment_path(last), segment_path(last + 1));
+  {
+    std::fstream newest(segment_path(last + 1),
+                        std::ios::binary | std::ios::in | std::ios::out);
+    const std::string zeros(192, '\0');
+    newest.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+  }
+  auto reader = JournalQueue(dir, false);
+  std::string payload;
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(reader.dequeue(payload));
+    EXPECT_EQ(payload, std::to_string(i));
+  }
+
+  auto writer = JournalQueue(dir, true);
+  EXPECT_EQ(writer.cursor_segment(), last + 1);
+  for (int i = 100; i < 200; ++i) {
+    EXPECT_TRUE(writer.enqueue(std::to_string(i)));
+  }
+  EXPECT_TRUE(writer.checkpoint());
+  for (int i = 100; i < 200; ++i) {
+    EXPECT_TRUE(reader.dequeue(payload));
+    EXPECT_EQ(payload, std::to_string(i));
+  }
+  EXPECT_FALSE(reader.dequeue(payload));
+}
+
+TEST(InterprocessJournalQueue, ConcurrentProduceAndConsume) {
+  const auto dir = fresh_journal_dir("ConcurrentProduceAndConsume");
+  constexpr int iter_size = 1'000'000;
+  auto writer = JournalQueue(dir, true, 1 << 16);
+  auto reader = JournalQueue(dir, false);
+
+  std::thread thread_producer([&] {
+    for (int i = 0; i < iter_size; ++i) {
+      EXPECT_TRUE(writer.enqueue(std::to_string(i)));
+    }
+  });
+  std::thread thread_consumer([&] {
+    int dequeue_count = 0;
+    while (dequeue_count < iter_size) {
+      if (std::string payload; reader.dequeue(payload)) {
+        EXPECT_EQ(payload, std::to_string(dequeue_count));
+        ++dequeue_count;
+      }
+    }
+  });
+  thread_producer.join();
+  thread_consumer.join();
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,174 @@
+#include "../interprocess/mpsc-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Interprocess;
+
+TEST(InterprocessMpscQueue, SingleThreadProducersGetTheirOwnLanes) {
+  auto consumer = MpscQueue("ProducersGetTheirOwnLanes", true, 256, 4);
+  auto producer1 = MpscQueue("ProducersGetTheirOwnLanes");
+  auto producer2 = MpscQueue("ProducersGetTheirOwnLanes");
+  EXPECT_NE(producer1.lane(), producer2.lane());
+  EXPECT_EQ(consumer.producer_count(), 2);
+
+  std::string payload;
+  EXPECT_FALSE(consumer.dequeue(payload));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(producer1.enqueue("p1/" + std::to_string(i)));
+    EXPECT_TRUE(producer2.enqueue("p2/" + std::to_string(i)));
+  }
+  std::map<std::string, int> next = {{"p1", 0}, {"p2", 0}};
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_TRUE(consumer.dequeue(payload));
+    const auto producer = payload.substr(0, 2);
+    EXPECT_EQ(payload.substr(3), std::to_string(next[producer]++));
+  }
+  EXPECT_FALSE(consumer.dequeue(payload));
+}
+
+TEST(InterprocessMpscQueue, SingleThreadLaneFullAndWrap) {
+  constexpr int lane_size = (sizeof(int) + 3) * 2;
+  auto consumer = MpscQueue("LaneFullAndWrap", true, lane_size, 1);
+  auto producer = MpscQueue("LaneFullAndWrap");
+  EXPECT_THROW(MpscQueue("LaneFullAndWrap"), std::runtime_error);
+
+  std::string payload;
+  for (int i = 0; i < INT16_MAX; ++i) {
+    int enqueued = 0;
+    // Records of up to half the lane always fit into an empty lane
+    while (producer.enqueue(std::to_string((i + enqueued) % 1000)))
+      ++enqueued;
+    EXPECT_GE(enqueued, 1);
+    for (int j = 0; j < enqueued; ++j) {
+      EXPECT_TRUE(consumer.dequeue(payload));
+      EXPECT_EQ(payload, std::to_string((i + j) % 1000));
+    }
+    EXPECT_FALSE(consumer.dequeue(payload));
+  }
+}
+
+TEST(InterprocessMpscQueue, ConsumeAllSweepsEveryLane) {
+  auto consumer = MpscQueue("ConsumeAllSweepsEveryLane", true, 256, 4);
+  auto producer1 = MpscQueue("ConsumeAllSweepsEveryLane");
+  auto producer2 = MpscQueue("ConsumeAllSweepsEveryLane");
+  std::map<std::string, int> next = {{"p1", 0}, {"p2", 0}};
+  auto expect_next = [&](const std::span<const std::byte> msg) {
+    const auto payload =
+        std::string(reinterpret_cast<const char *>(msg.data()), msg.size());
+    const auto producer = payload.substr(0, 2);
+    EXPECT_EQ(payload.substr(3), std::to_string(next[producer]++));
+  };
+  for (int round = 0; round < 1000; ++round) {
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_TRUE(producer1.enqueue("p1/" + std::to_string(round * 5 + i)));
+      EXPECT_TRUE(producer2.enqueue("p2/" + std::to_string(round * 5 + i)));
+    }
+    EXPECT_EQ(consumer.consume_up_to(3, expect_next), 3);
+    EXPECT_EQ(consumer.consume_all(expect_next), 7);
+    EXPECT_EQ(consumer.consume_all(expect_next), 0);
+  }
+  EXPECT_EQ(next["p1"], 5000);
+  EXPECT_EQ(next["p2"], 5000);
+}
+
+TEST(InterprocessMpscQueue, ConsumeUpToKeepsTheMessageFnThrewOn) {
+  auto consumer = MpscQueue("ConsumeUpToThrows", true, 256, 2);
+  auto producer = MpscQueue("ConsumeUpToThrows");
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(producer.enqueue(std::to_string(i)));
+  }
+  std::vector<std::string> taken;
+  EXPECT_THROW(consumer.consume_all([&](const std::span<const std::byte> msg) {
+    std::string payload(reinterpret_cast<const char *>(msg.data()),
+                        msg.size());
+    if (payload == "2")
+      throw std::runtime_error("stop");
+    taken.push_back(std::move(payload));
+  }), std::runtime_error);
+  EXPECT_EQ(taken, (std::vector<std::string>{"0", "1"}));
+  std::string payload;
+  EXPECT_TRUE(consumer.dequeue(payload));
+  EXPECT_EQ(payload, "2");
+  EXPECT_EQ(consumer.consume_all([](std::span<const std::byte>) {}), 2);
+}
+
+TEST(InterprocessMpscQueue, CrashedProducerIsDrainedThenReaped) {
+  auto consumer = MpscQueue("CrashedProducerIsDrained", true, 1024, 2);
+  if (const pid_t pid = fork(); pid == 0) {
+    auto producer = MpscQueue("CrashedProducerIsDrained");
+    for (int i = 0; i < 3; ++i) {
+      producer.enqueue(std::to_string(i));
+    }
+    // Die without unregistering
+    _exit(0);
+  } else {
+    waitpid(pid, nullptr, 0);
+  }
+  EXPECT_EQ(consumer.producer_count(), 1);
+  EXPECT_EQ(consumer.reap_producers(), 1);
+
+  std::string payload;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(consumer.dequeue(payload));
+    EXPECT_EQ(payload, std::to_string(i));
+  }
+  EXPECT_FALSE(consumer.dequeue(payload));
+  EXPECT_EQ(consumer.producer_count(), 0);
+
+  // The lane is reusable, and so is a lane a producer left gracefully once
+  // the consumer drained it
+  for (int round = 0; round < 5; ++round) {
+    {
+      auto producer = MpscQueue("CrashedProducerIsDrained");
+      EXPECT_TRUE(producer.enqueue("round " + std::to_string(round)));
+    }
+    EXPECT_EQ(consumer.producer_count(), 1);
+    EXPECT_TRUE(consumer.dequeue(payload));
+    EXPECT_EQ(payload, "round " + std::to_string(round));
+    EXPECT_FALSE(consumer.dequeue(payload));
+    EXPECT_EQ(consumer.producer_count(), 0);
+  }
+}
+
+TEST(InterprocessMpscQueue, ConcurrentProduceAndConsume) {
+  constexpr int producer_count = 4;
+  constexpr int iter_size = 500'000;
+  auto consumer =
+      MpscQueue("MpscConcurrentProduceAndConsume", true, 512, producer_count);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producer_count; ++p) {
+    producers.emplace_back([p] {
+      auto producer = MpscQueue("MpscConcurrentProduceAndConsume");
+      int enqueue_count = 0;
+      while (enqueue_count < iter_size) {
+        if (producer.enqueue(std::to_string(p) + "/" +
+                             std::to_string(enqueue_count)))
+          ++enqueue_count;
+      }
+    });
+  }
+  std::vector<int> next(producer_count, 0);
+  int dequeue_count = 0;
+  while (dequeue_count < iter_size * producer_count) {
+    if (std::string payload; consumer.dequeue(payload)) {
+      const auto slash = payload.find('/');
+      const int p = std::stoi(payload.substr(0, slash));
+      EXPECT_EQ(payload.substr(slash + 1), std::to_string(next[p]++));
+      ++dequeue_count;
+    }
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+}
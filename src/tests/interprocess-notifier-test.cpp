@@ -0,0 +1,77 @@
+#include "../interprocess/notifier-impl.h"
+#include "../interprocess/spsc-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Interprocess;
+
+namespace {
+bool readable(const int fd) {
+  pollfd pfd{fd, POLLIN, 0};
+  return poll(&pfd, 1, 0) == 1;
+}
+} // namespace
+
+TEST(InterprocessNotifier, SignalsOnlyAWaitingConsumer) {
+  auto consumer = Notifier("NotifierSignals", true);
+  auto producer = Notifier("NotifierSignals");
+  producer.notify();
+  EXPECT_FALSE(readable(consumer.fd()));
+
+  consumer.prepare_wait();
+  producer.notify();
+  producer.notify();
+  EXPECT_TRUE(readable(consumer.fd()));
+  consumer.acknowledge();
+  EXPECT_FALSE(readable(consumer.fd()));
+
+  consumer.prepare_wait();
+  consumer.cancel_wait();
+  producer.notify();
+  EXPECT_FALSE(consumer.wait(0));
+  EXPECT_THROW(SpscQueue("NotifierSignals"), std::runtime_error);
+}
+
+TEST(InterprocessNotifier, WakesAConsumerInAnotherProcess) {
+  constexpr int iterations = 20'000;
+  auto q = SpscQueue("NotifierWakesQueue", true, 4096);
+  auto notifier = Notifier("NotifierWakes", true);
+  if (const pid_t pid = fork(); pid == 0) {
+    auto child_q = SpscQueue("NotifierWakesQueue");
+    auto child_notifier = Notifier("NotifierWakes");
+    for (int i = 0; i < iterations; ++i) {
+      while (!child_q.enqueue(std::to_string(i))) {
+        usleep(10);
+      }
+      child_notifier.notify();
+    }
+    _exit(0);
+  } else {
+    int expected = 0;
+    auto check = [&](const std::span<const std::byte> msg) {
+      EXPECT_EQ(std::string(reinterpret_cast<const char *>(msg.data()),
+                            msg.size()),
+                std::to_string(expected++));
+    };
+    while (expected < iterations) {
+      if (q.consume_all(check) > 0)
+        continue;
+      notifier.prepare_wait();
+      if (q.consume_all(check) > 0) {
+        notifier.cancel_wait();
+        continue;
+      }
+      ASSERT_TRUE(notifier.wait(10'000));
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    EXPECT_EQ(status, 0);
+  }
+}
@@ -0,0 +1,85 @@
+#include "../interprocess/overwrite-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Interprocess;
+
+namespace {
+struct TraceEvent {
+  std::uint64_t id;
+  std::uint64_t timestamp_ns;
+  std::uint32_t kind;
+};
+} // namespace
+
+TEST(InterprocessOverwriteQueue, LateConsumerReplaysTheRecordedHistory) {
+  auto recorder = OverwriteQueue<TraceEvent>("FlightRecorder", true, 64);
+  if (const pid_t pid = fork(); pid == 0) {
+    auto producer = OverwriteQueue<TraceEvent>("FlightRecorder");
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+      producer.enqueue(TraceEvent{i, i * 10, 1});
+    }
+    _exit(0);
+  } else {
+    waitpid(pid, nullptr, 0);
+  }
+  // An attacher starts at the oldest message still recorded
+  auto late = OverwriteQueue<TraceEvent>("FlightRecorder");
+  TraceEvent event{};
+  for (std::uint64_t i = 1000 - 64; i < 1000; ++i) {
+    EXPECT_TRUE(late.dequeue(event));
+    EXPECT_EQ(event.id, i);
+  }
+  EXPECT_FALSE(late.dequeue(event));
+  EXPECT_EQ(late.dropped(), 0);
+
+  // The owner has been reading from the start and missed the rest
+  EXPECT_TRUE(recorder.dequeue(event));
+  EXPECT_EQ(event.id, 1000 - 64);
+  EXPECT_EQ(recorder.dropped(), 1000 - 64);
+}
+
+TEST(InterprocessOverwriteQueue, AttachRejectsMismatchedSegment) {
+  auto q = OverwriteQueue<TraceEvent>("OverwriteMismatch", true, 100);
+  EXPECT_EQ(q.capacity(), 128);
+  EXPECT_THROW(OverwriteQueue<int>("OverwriteMismatch"), std::runtime_error);
+  EXPECT_THROW(OverwriteQueue<TraceEvent>("OverwriteMismatch", false, 256),
+               std::runtime_error);
+  EXPECT_NO_THROW(OverwriteQueue<TraceEvent>("OverwriteMismatch", false, 128));
+}
+
+TEST(InterprocessOverwriteQueue, ConcurrentConsumerSeesOrderedMessagesAndGaps) {
+  constexpr std::uint64_t iter_size = 20'000'000;
+  auto consumer_q =
+      OverwriteQueue<TraceEvent>("OverwriteConcurrent", true, 1024);
+  auto producer_q = OverwriteQueue<TraceEvent>("OverwriteConcurrent");
+  std::atomic<bool> done = false;
+  std::uint64_t received = 0;
+  std::thread consumer([&] {
+    TraceEvent event{};
+    while (true) {
+      const bool finished = done.load();
+      if (!consumer_q.dequeue(event)) {
+        if (finished)
+          break;
+        continue;
+      }
+      EXPECT_EQ(event.id, received + consumer_q.dropped());
+      EXPECT_EQ(event.timestamp_ns, event.id * 10);
+      ++received;
+    }
+  });
+  for (std::uint64_t i = 0; i < iter_size; ++i) {
+    producer_q.enqueue(TraceEvent{i, i * 10, 2});
+  }
+  done = true;
+  consumer.join();
+  EXPECT_EQ(received + consumer_q.dropped(), iter_size);
+}
@@ -0,0 +1,92 @@
+#include "../interprocess/seqlock-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Interprocess;
+
+namespace {
+struct BestBidAsk {
+  std::uint64_t bid;
+  std::uint64_t ask;
+  std::uint64_t bid_size;
+  std::uint64_t ask_size;
+  std::uint64_t update_id;
+};
+} // namespace
+
+TEST(InterprocessSeqlock, AttacherSeesTheNewestValue) {
+  auto writer = Seqlock<BestBidAsk>("AttacherSeesTheNewestValue", true);
+  auto reader = Seqlock<BestBidAsk>("AttacherSeesTheNewestValue");
+  BestBidAsk bba{};
+  EXPECT_FALSE(reader.dequeue(bba));
+  for (std::uint64_t i = 1; i <= 10; ++i) {
+    EXPECT_TRUE(writer.enqueue(BestBidAsk{100 + i, 101 + i, 5, 7, i}));
+  }
+  EXPECT_TRUE(reader.dequeue(bba));
+  EXPECT_EQ(bba.update_id, 10);
+  EXPECT_EQ(bba.ask, 111);
+  EXPECT_FALSE(reader.dequeue(bba));
+  EXPECT_EQ(reader.version(), 10);
+}
+
+TEST(InterprocessSeqlock, AttachRejectsMismatchedSegment) {
+  auto writer = KeyedSeqlock<BestBidAsk>("SeqlockMismatch", true, 16);
+  EXPECT_THROW(KeyedSeqlock<int>("SeqlockMismatch"), std::runtime_error);
+  EXPECT_THROW(KeyedSeqlock<BestBidAsk>("SeqlockMismatch", false, 8),
+               std::runtime_error);
+  EXPECT_THROW(Seqlock<BestBidAsk>("SeqlockMismatch"), std::runtime_error);
+  EXPECT_EQ(KeyedSeqlock<BestBidAsk>("SeqlockMismatch").size(), 16);
+}
+
+TEST(InterprocessSeqlock, KeyedSlotsAcrossProcesses) {
+  constexpr std::size_t instruments = 5000;
+  auto book = KeyedSeqlock<BestBidAsk>("KeyedSlotsAcrossProcesses", true,
+                                       instruments);
+  if (const pid_t pid = fork(); pid == 0) {
+    auto writer = KeyedSeqlock<BestBidAsk>("KeyedSlotsAcrossProcesses");
+    for (std::uint64_t id = 0; id < instruments; id += 2) {
+      writer.store(id, BestBidAsk{id, id + 1, 1, 1, 1});
+    }
+    _exit(0);
+  } else {
+    waitpid(pid, nullptr, 0);
+  }
+  BestBidAsk bba{};
+  for (std::size_t id = 0; id < instruments; ++id) {
+    EXPECT_EQ(book.load(id, bba), id % 2 == 0);
+    if (id % 2 == 0) {
+      EXPECT_EQ(bba.ask, id + 1);
+    }
+  }
+}
+
+TEST(InterprocessSeqlock, ConcurrentReaderNeverSeesTornValues) {
+  constexpr std::uint64_t iter_size = 20'000'000;
+  auto writer = Seqlock<BestBidAsk>("SeqlockConcurrent", true);
+  auto reader = Seqlock<BestBidAsk>("SeqlockConcurrent");
+  std::atomic<bool> done = false;
+  std::thread thread_reader([&] {
+    std::uint64_t prev = 0;
+    BestBidAsk bba{};
+    while (!done.load(std::memory_order_relaxed)) {
+      if (!reader.dequeue(bba))
+        continue;
+      EXPECT_EQ(bba.bid + 1, bba.ask);
+      EXPECT_EQ(bba.update_id, bba.bid);
+      EXPECT_GT(bba.update_id, prev);
+      prev = bba.update_id;
+    }
+  });
+  for (std::uint64_t i = 1; i <= iter_size; ++i) {
+    writer.enqueue(BestBidAsk{i, i + 1, i, i, i});
+  }
+  done = true;
+  thread_reader.join();
+}
@@ -4,8 +4,15 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <deque>
 #include <format>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 using namespace RingBuffer;
 
@@ -81,6 +88,260 @@ TEST(InterprocessSpscQueue, SingleThreadProduceAndConsume) {
   }
 }
 
+TEST(InterprocessSpscQueue, AttachReadsGeometryFromHeader) {
+  constexpr int sz = 171;
+  auto q_con = SpscQueueImpl("AttachReadsGeometryFromHeader", true, sz,
+                             {.prefault = true, .lock_pages = true});
+  const auto &header = q_con.header();
+  EXPECT_EQ(header.magic, Interprocess::SegmentHeader::MAGIC);
+  EXPECT_EQ(header.queue_size, sz);
+  EXPECT_GT(header.creation_epoch_ns, 0);
+
+  auto q_prd = SpscQueueImpl("AttachReadsGeometryFromHeader");
+  EXPECT_EQ(q_prd.header().queue_size, sz);
+  EXPECT_EQ(q_prd.header().creation_epoch_ns, header.creation_epoch_ns);
+  for (int i = 0; i < INT16_MAX; ++i) {
+    EXPECT_TRUE(q_prd.enqueue(std::to_string(i)));
+    std::string received;
+    EXPECT_TRUE(q_con.dequeue(received));
+    EXPECT_EQ(received, std::to_string(i));
+  }
+}
+
+TEST(InterprocessSpscQueue, AttachRejectsMismatchedOrMissingSegment) {
+  auto q_con = SpscQueueImpl("AttachRejectsMismatchedSegment", true, 1024);
+  EXPECT_THROW(SpscQueueImpl("AttachRejectsMismatchedSegment", false, 2048),
+               std::runtime_error);
+  EXPECT_NO_THROW(SpscQueueImpl("AttachRejectsMismatchedSegment", false, 1024));
+  EXPECT_ANY_THROW(SpscQueueImpl("AttachRejectsMissingSegment"));
+}
+
+template <typename Queue> void expect_in_order_across_wraps(const int size) {
+  const std::string name = "InOrderAcrossWraps" + std::to_string(size);
+  auto q_con = Queue(name, true, size);
+  auto q_prd = Queue(name);
+  std::mt19937 rng(size);
+  std::uint64_t sent = 0;
+  std::uint64_t received = 0;
+  std::string buffer;
+  while (received < INT16_MAX) {
+    // Random bursts on both sides, so that records wrap at every offset and
+    // against every head position
+    for (int i = rng() % 40; i > 0; --i) {
+      std::string payload(sizeof(sent) + rng() % (size / 4), 'x');
+      std::memcpy(payload.data(), &sent, sizeof(sent));
+      if (!q_prd.enqueue(payload))
+        break;
+      ++sent;
+    }
+    for (int i = rng() % 40; i > 0 && q_con.dequeue(buffer); --i) {
+      std::uint64_t id;
+      std::memcpy(&id, buffer.data(), sizeof(id));
+      ASSERT_EQ(id, received++);
+    }
+  }
+}
+
+TEST(InterprocessSpscQueue, WrappingRecordsNeverOverrunHead) {
+  for (int size = 64; size < 600; size += 7) {
+    expect_in_order_across_wraps<Interprocess::SpscQueue>(size);
+    expect_in_order_across_wraps<Interprocess::SpscQueueBeta>(size);
+  }
+}
+
+TEST(InterprocessSpscQueue, AlignedRecordsRoundTripAcrossWraps) {
+  for (const int alignment : {8, 64}) {
+    const std::string name = "AlignedRecords" + std::to_string(alignment);
+    // Rounded down to a multiple of the alignment
+    auto q_con = Interprocess::SpscQueue(name, true, 1000,
+                                         {.record_alignment = alignment});
+    EXPECT_EQ(q_con.header().queue_size, 1000 - 1000 % alignment);
+    auto q_prd = Interprocess::SpscQueue(name);
+    EXPECT_EQ(q_prd.record_alignment(), alignment);
+
+    std::string received;
+    EXPECT_FALSE(q_con.dequeue(received));
+    std::deque<std::string> in_flight;
+    auto consume_one = [&] {
+      EXPECT_TRUE(q_con.dequeue(received));
+      EXPECT_EQ(received, in_flight.front());
+      in_flight.pop_front();
+    };
+    for (int i = 0; i < INT16_MAX; ++i) {
+      // Varying sizes, so that records hit the end of the ring at every offset
+      const auto payload = std::string(i % 97, 'a' + i % 26);
+      while (!q_prd.enqueue(payload)) {
+        consume_one();
+      }
+      in_flight.push_back(payload);
+      if (i % 2 == 1)
+        consume_one();
+    }
+    while (!in_flight.empty()) {
+      consume_one();
+    }
+    EXPECT_FALSE(q_con.dequeue(received));
+    EXPECT_EQ(q_con.head(), q_con.tail());
+  }
+}
+
+TEST(InterprocessSpscQueue, AlignedRecordsFillTheQueueAndKeepOrder) {
+  auto q_con = Interprocess::SpscQueue("AlignedRecordsFill", true, 64 * 8,
+                                       {.record_alignment = 64});
+  auto q_prd = Interprocess::SpscQueue("AlignedRecordsFill");
+  // One record per cache line, one line stays free to tell full from empty
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_TRUE(q_prd.enqueue(std::to_string(i)));
+  }
+  EXPECT_FALSE(q_prd.enqueue(std::string("7")));
+  std::string received;
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_TRUE(q_con.dequeue(received));
+    EXPECT_EQ(received, std::to_string(i));
+  }
+  EXPECT_FALSE(q_con.dequeue(received));
+}
+
+TEST(InterprocessSpscQueue, AlignedRecordsRejectBadGeometry) {
+  EXPECT_THROW(Interprocess::SpscQueue("AlignedRecordsBad", true, 1024,
+                                       {.record_alignment = 16}),
+               std::invalid_argument);
+  EXPECT_THROW(Interprocess::SpscQueue("AlignedRecordsBad", true, 100,
+                                       {.record_alignment = 64}),
+               std::invalid_argument);
+  auto q = Interprocess::SpscQueue("AlignedRecordsBeta", true, 1024,
+                                   {.record_alignment = 8});
+  EXPECT_THROW(Interprocess::SpscQueueBeta("AlignedRecordsBeta"),
+               std::runtime_error);
+}
+
+TEST(InterprocessSpscQueue, ConcurrentProduceAndConsumeAlignedRecords) {
+  constexpr int iter_size = 20'000'000;
+  auto q_con = Interprocess::SpscQueue("ConcurrentAlignedRecords", true, 1024,
+                                       {.record_alignment = 64});
+  auto q_prd = Interprocess::SpscQueue("ConcurrentAlignedRecords");
+  std::thread thread_consumer([&] {
+    int dequeue_count = 0;
+    std::string received;
+    while (dequeue_count < iter_size) {
+      if (q_con.dequeue(received)) {
+        EXPECT_EQ(received, std::to_string(dequeue_count));
+        ++dequeue_count;
+      }
+    }
+  });
+  for (int i = 0; i < iter_size;) {
+    if (q_prd.enqueue(std::to_string(i)))
+      ++i;
+  }
+  thread_consumer.join();
+}
+
+TEST(InterprocessSpscQueue, CopyKernelsMatchMemcpy) {
+  std::vector<char> src(70'000);
+  for (std::size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<char>(i * 131 + 7);
+  }
+  for (const auto kernel :
+       {Interprocess::CopyKernel::Memcpy, Interprocess::CopyKernel::Avx2,
+        Interprocess::CopyKernel::Avx512, Interprocess::CopyKernel::Streaming,
+        Interprocess::CopyKernel::Auto}) {
+    const auto copy = Interprocess::copy_function(kernel);
+    for (const std::size_t n : {0, 1, 31, 32, 33, 63, 64, 65, 127, 128, 129,
+                                255, 256, 257, 4096, 65'536 + 17}) {
+      // Misaligned source and destination, guarded on both sides
+      for (const std::size_t misalign : {0, 1, 8, 31}) {
+        std::vector<char> dst(n + 128, '\x5a');
+        copy(dst.data() + 64 + misalign, src.data() + misalign, n);
+        EXPECT_EQ(std::memcmp(dst.data() + 64 + misalign,
+                              src.data() + misalign, n),
+                  0);
+        for (std::size_t i = 0; i < 64 + misalign; ++i) {
+          ASSERT_EQ(dst[i], '\x5a');
+        }
+        for (std::size_t i = 64 + misalign + n; i < dst.size(); ++i) {
+          ASSERT_EQ(dst[i], '\x5a');
+        }
+      }
+    }
+  }
+}
+
+TEST(InterprocessSpscQueue, CopyKernelsRoundTripThroughQueue) {
+  const Interprocess::CopyOptions copy = {
+      .kernel = Interprocess::CopyKernel::Auto,
+      .streaming_threshold = 1024,
+      .prefetch_next = true};
+  for (const int alignment : {1, 64}) {
+    auto q_con = Interprocess::SpscQueue(
+        "CopyKernelsRoundTrip", true, 1 << 16,
+        {.record_alignment = alignment, .copy = copy});
+    auto q_prd =
+        Interprocess::SpscQueue("CopyKernelsRoundTrip", false, 0, {.copy = copy});
+    for (int i = 0; i < 2000; ++i) {
+      // Straddles the streaming threshold
+      const auto payload = std::string(i * 7 % 5000, 'a' + i % 26);
+      EXPECT_TRUE(q_prd.enqueue(payload));
+      std::string received;
+      EXPECT_TRUE(q_con.dequeue(received));
+      EXPECT_EQ(received, payload);
+    }
+  }
+}
+
+TEST(InterprocessSpscQueue, EnqueueGatherWritesFragmentsAsOneRecord) {
+  const std::string header = "HDR|";
+  const std::vector<char> body(300, 'b');
+  const std::array<std::byte, 3> trailer = {std::byte{'|'}, std::byte{'T'},
+                                            std::byte{'\0'}};
+  const std::span<const std::byte> fragments[] = {
+      std::as_bytes(std::span(header)), std::as_bytes(std::span(body)), {},
+      trailer};
+  const auto expected = header + std::string(body.begin(), body.end()) +
+                        std::string("|T\0", 3);
+  for (const int alignment : {1, 8}) {
+    auto q_con = Interprocess::SpscQueue("EnqueueGather", true, 1024,
+                                         {.record_alignment = alignment});
+    auto q_prd = Interprocess::SpscQueue("EnqueueGather");
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_TRUE(q_prd.enqueue_gather(fragments));
+      std::string received;
+      EXPECT_TRUE(q_con.dequeue(received));
+      EXPECT_EQ(received, expected);
+    }
+    // Fragments count once towards the free space check
+    while (q_prd.enqueue_gather(fragments)) {
+    }
+    EXPECT_FALSE(q_prd.enqueue_gather(fragments));
+  }
+}
+
+TEST(InterprocessSpscQueue, EnqueueAcceptsByteSequences) {
+  auto q_con = Interprocess::SpscQueue("EnqueueByteSequences", true, 1024);
+  auto q_prd = Interprocess::SpscQueue("EnqueueByteSequences");
+  using namespace std::string_view_literals;
+  EXPECT_TRUE(q_prd.enqueue("string_view"sv));
+  EXPECT_TRUE(q_prd.enqueue(std::as_bytes(std::span("byte span"sv))));
+  EXPECT_TRUE(q_prd.enqueue(std::vector<unsigned char>{'v', 'e', 'c'}));
+  // Through the interface too
+  IRingBuffer<Interprocess::SpscQueue, std::string> &q = q_prd;
+  EXPECT_TRUE(q.enqueue("interface"sv));
+  // C strings as before, without their terminating NUL
+  EXPECT_TRUE(q_prd.enqueue("literal"));
+  const char *c_str = "c string";
+  EXPECT_TRUE(q_prd.enqueue(c_str));
+  static_assert(!Interprocess::ByteSequence<const int (&)[4]>);
+  static_assert(!Interprocess::ByteSequence<std::vector<int>>);
+  static_assert(!Interprocess::ByteSequence<std::nullptr_t>);
+
+  for (const auto expected : {"string_view", "byte span", "vec", "interface",
+                              "literal", "c string"}) {
+    std::string received;
+    EXPECT_TRUE(q_con.dequeue(received));
+    EXPECT_EQ(received, expected);
+  }
+}
+
 void common_consumer(const int qsz_bytes, const std::size_t iter_size,
                      const std::vector<std::string> &payloads,
                      const std::string &queue_name) {
@@ -112,6 +373,180 @@ void common_producer(const int qsz_bytes, const std::size_t iter_size,
   }
 }
 
+TEST(InterprocessSpscQueue, ConsumeUpToSweepsRecordsInPlace) {
+  for (const int alignment : {1, 8, 64}) {
+    const std::string name = "ConsumeUpTo" + std::to_string(alignment);
+    auto q_con = Interprocess::SpscQueue(name, true, 1024,
+                                         {.record_alignment = alignment});
+    auto q_prd = Interprocess::SpscQueue(name);
+
+    int next_in = 0;
+    int next_out = 0;
+    auto expect_next = [&](const std::span<const std::byte> msg) {
+      const auto payload = std::string_view(
+          reinterpret_cast<const char *>(msg.data()), msg.size());
+      EXPECT_EQ(payload, std::string(next_out % 97, 'a' + next_out % 26));
+      ++next_out;
+    };
+    EXPECT_EQ(q_con.consume_all(expect_next), 0);
+    for (int round = 0; round < 1000; ++round) {
+      // Varying sizes, so that sweeps cross the end of the ring everywhere
+      while (q_prd.enqueue(std::string(next_in % 97, 'a' + next_in % 26)))
+        ++next_in;
+      const int published = next_in - next_out;
+      EXPECT_EQ(q_con.consume_up_to(1, expect_next), 1);
+      EXPECT_EQ(q_con.consume_all(expect_next), published - 1);
+    }
+    EXPECT_EQ(next_out, next_in);
+    EXPECT_EQ(q_con.head(), q_con.tail());
+    EXPECT_EQ(q_con.get_used_bytes(), 0);
+  }
+
+  auto q_con = SpscQueueImpl("ConsumeUpToBeta", true, 256);
+  auto q_prd = SpscQueueImpl("ConsumeUpToBeta");
+  int received = 0;
+  for (int round = 0; round < 1000; ++round) {
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_TRUE(q_prd.enqueue(std::to_string(round * 10 + i)));
+    }
+    EXPECT_EQ(q_con.consume_all([&](const std::span<const std::byte> msg) {
+      EXPECT_EQ(std::string_view(reinterpret_cast<const char *>(msg.data()),
+                                 msg.size()),
+                std::to_string(received++));
+    }), 10);
+  }
+}
+
+namespace {
+// Sweeps q_con while fn throws on "2", then checks that "0" and "1" were
+// released and "2" is handed out again
+template <typename Queue> void expect_sweep_keeps_throwing_message(
+    Queue &q_con, Queue &q_prd) {
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(q_prd.enqueue(std::to_string(i)));
+  }
+  std::vector<std::string> taken;
+  EXPECT_THROW(q_con.consume_all([&](const std::span<const std::byte> msg) {
+    std::string payload(reinterpret_cast<const char *>(msg.data()),
+                        msg.size());
+    if (payload == "2")
+      throw std::runtime_error("stop");
+    taken.push_back(std::move(payload));
+  }), std::runtime_error);
+  EXPECT_EQ(taken, (std::vector<std::string>{"0", "1"}));
+  std::string msg;
+  EXPECT_TRUE(q_con.dequeue(msg));
+  EXPECT_EQ(msg, "2");
+  EXPECT_EQ(q_con.consume_all([](std::span<const std::byte>) {}), 2);
+}
+} // namespace
+
+TEST(InterprocessSpscQueue, ConsumeUpToKeepsTheMessageFnThrewOn) {
+  for (const int alignment : {1, 8, 64}) {
+    const std::string name = "ConsumeUpToThrows" + std::to_string(alignment);
+    auto q_con = Interprocess::SpscQueue(
+        name, true, 1024,
+        {.record_alignment = alignment, .stats = true,
+         .sojourn_sample_every = 1});
+    auto q_prd = Interprocess::SpscQueue(name);
+    expect_sweep_keeps_throwing_message(q_con, q_prd);
+    EXPECT_EQ(q_con.stats()->consumer.messages, 5);
+    EXPECT_EQ(q_con.sojourn()->histogram.count(), 5);
+  }
+  auto q_con = SpscQueueImpl("ConsumeUpToThrowsBeta", true, 256);
+  auto q_prd = SpscQueueImpl("ConsumeUpToThrowsBeta");
+  expect_sweep_keeps_throwing_message(q_con, q_prd);
+}
+
+TEST(InterprocessSpscQueue, StatsTrackBothEndpoints) {
+  for (const int alignment : {1, 64}) {
+    const std::string name = "StatsTrack" + std::to_string(alignment);
+    auto q_con = Interprocess::SpscQueue(
+        name, true, 1024, {.record_alignment = alignment, .stats = true});
+    auto q_prd = Interprocess::SpscQueue(name);
+    ASSERT_NE(q_prd.stats(), nullptr);
+    const auto &stats = *q_con.stats();
+
+    std::string msg;
+    EXPECT_FALSE(q_con.dequeue(msg));
+    EXPECT_EQ(stats.consumer.stalls, 1);
+    int sent = 0;
+    while (q_prd.enqueue(std::string(20, 'x')))
+      ++sent;
+    EXPECT_EQ(stats.producer.messages, sent);
+    EXPECT_EQ(stats.producer.bytes, sent * 20);
+    EXPECT_EQ(stats.producer.stalls, 1);
+    EXPECT_GT(stats.producer.high_water, 1024 / 2);
+    EXPECT_LE(stats.producer.high_water, 1024);
+    EXPECT_EQ(stats.producer.pid, Interprocess::current_pid());
+    EXPECT_GT(stats.producer.last_active_ns, 0);
+
+    EXPECT_TRUE(q_con.dequeue(msg));
+    EXPECT_EQ(q_con.consume_all([](std::span<const std::byte>) {}), sent - 1);
+    EXPECT_EQ(stats.consumer.messages, sent);
+    EXPECT_EQ(stats.consumer.bytes, sent * 20);
+    EXPECT_EQ(stats.consumer.high_water, 0);
+  }
+
+  auto q_plain = Interprocess::SpscQueue("StatsOff", true, 1024);
+  EXPECT_EQ(q_plain.stats(), nullptr);
+  EXPECT_EQ(Interprocess::SpscQueue("StatsOff").stats(), nullptr);
+}
+
+TEST(InterprocessSpscQueue, SojournSamplingIsSharedByBothEndpoints) {
+  for (const int alignment : {1, 64}) {
+    const std::string name = "Sojourn" + std::to_string(alignment);
+    auto q_con = Interprocess::SpscQueue(
+        name, true, 4096,
+        {.record_alignment = alignment, .stats = true,
+         .sojourn_sample_every = 3});
+    auto q_prd = Interprocess::SpscQueue(name);
+    ASSERT_NE(q_prd.sojourn(), nullptr);
+    ASSERT_NE(q_prd.stats(), nullptr);
+    EXPECT_EQ(q_prd.sojourn()->every, 4);
+
+    std::string msg;
+    for (int i = 0; i < 40; ++i) {
+      ASSERT_TRUE(q_prd.enqueue(std::to_string(i)));
+    }
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_TRUE(q_con.dequeue(msg));
+      EXPECT_EQ(msg, std::to_string(i));
+    }
+    EXPECT_EQ(q_con.consume_all([](std::span<const std::byte>) {}), 30);
+    const auto &histogram = q_con.sojourn()->histogram;
+    EXPECT_EQ(histogram.count(), 10);
+    EXPECT_GT(histogram.max_ticks(), 0);
+    EXPECT_EQ(q_con.sojourn()->dropped_samples(), 0);
+    // Sampling does not disturb the stats region in front of it
+    EXPECT_EQ(q_con.stats()->consumer.messages, 40);
+  }
+
+  // Fill the queue with the smallest records it can hold, every one of them
+  // keeps its stamp
+  for (const int alignment : {1, 8}) {
+    const std::string name = "SojournDeep" + std::to_string(alignment);
+    auto q_con = Interprocess::SpscQueue(
+        name, true, 512,
+        {.record_alignment = alignment, .sojourn_sample_every = 1});
+    auto q_prd = Interprocess::SpscQueue(name);
+    EXPECT_EQ(q_prd.header().header_size, q_con.header().header_size);
+    std::uint64_t sent = 0;
+    for (int round = 0; round < 3; ++round) {
+      while (q_prd.enqueue(std::string()))
+        ++sent;
+      q_con.consume_all([](std::span<const std::byte>) {});
+    }
+    EXPECT_GE(sent, 3 * (512 / 8 - 1));
+    EXPECT_EQ(q_con.sojourn()->histogram.count(), sent);
+    EXPECT_EQ(q_con.sojourn()->dropped_samples(), 0);
+  }
+
+  auto q_plain = Interprocess::SpscQueue("SojournOff", true, 1024);
+  EXPECT_EQ(q_plain.sojourn(), nullptr);
+  EXPECT_EQ(Interprocess::SpscQueue("SojournOff").sojourn(), nullptr);
+}
+
 TEST(InterprocessSpscQueue, ConcurrentProduceAndConsume) {
   std::vector<std::string> dummy_payloads = {
       "0xDeadBeef",
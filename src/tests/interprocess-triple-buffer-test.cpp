@@ -0,0 +1,126 @@
+#include "../interprocess/triple-buffer-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace RingBuffer::Interprocess;
+
+namespace {
+struct BookSnapshot {
+  std::uint64_t generation;
+  std::uint64_t levels[4096];
+};
+} // namespace
+
+TEST(InterprocessTripleBuffer, SnapshotsCrossProcesses) {
+  auto reader = TripleBuffer("SnapshotsCrossProcesses", true, false,
+                             sizeof(BookSnapshot));
+  EXPECT_FALSE(reader.refresh());
+  EXPECT_TRUE(reader.front().empty());
+  if (const pid_t pid = fork(); pid == 0) {
+    auto writer = TripleBuffer("SnapshotsCrossProcesses", false, true);
+    for (std::uint64_t gen = 1; gen <= 5; ++gen) {
+      auto &book = writer.back_as<BookSnapshot>();
+      book.generation = gen;
+      for (auto &level : book.levels) {
+        level = gen;
+      }
+      writer.publish(sizeof(BookSnapshot));
+    }
+    _exit(0);
+  } else {
+    waitpid(pid, nullptr, 0);
+  }
+  EXPECT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.front().size(), sizeof(BookSnapshot));
+  const auto &book = reader.front_as<BookSnapshot>();
+  EXPECT_EQ(book.generation, 5);
+  EXPECT_EQ(book.levels[4095], 5);
+  EXPECT_FALSE(reader.refresh());
+}
+
+TEST(InterprocessTripleBuffer, WriterReattachesToItsOwnBuffer) {
+  auto reader = TripleBuffer("WriterReattaches", true, false, 64);
+  {
+    auto writer = TripleBuffer("WriterReattaches", false, true);
+    writer.back()[0] = std::byte{1};
+    writer.publish(1);
+  }
+  EXPECT_TRUE(reader.refresh());
+  const auto *held = reader.front().data();
+  {
+    auto writer = TripleBuffer("WriterReattaches", false, true);
+    EXPECT_NE(writer.back().data(), held);
+    writer.back()[0] = std::byte{2};
+    writer.publish(1);
+  }
+  EXPECT_EQ(reader.front()[0], std::byte{1});
+  EXPECT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.front()[0], std::byte{2});
+  EXPECT_THROW(reader.publish(1), std::logic_error);
+  EXPECT_THROW(TripleBuffer("WriterReattaches", false, true, 128),
+               std::runtime_error);
+}
+
+TEST(InterprocessTripleBuffer, WriterKilledWhilePublishing) {
+  auto reader = TripleBuffer("WriterKilled", true, false, 64);
+  for (int round = 0; round < 20; ++round) {
+    if (const pid_t pid = fork(); pid == 0) {
+      auto writer = TripleBuffer("WriterKilled", false, true);
+      for (std::uint8_t gen = 0;; ++gen) {
+        writer.back()[0] = std::byte{gen};
+        writer.publish(1);
+      }
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      kill(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+    }
+    reader.refresh();
+    // Whatever instruction the writer died at, the next one gets a buffer
+    // the reader does not hold
+    auto writer = TripleBuffer("WriterKilled", false, true);
+    ASSERT_NE(writer.back().data(), reader.front().data());
+    writer.back()[0] = std::byte{0xff};
+    writer.publish(1);
+    EXPECT_TRUE(reader.refresh());
+    EXPECT_EQ(reader.front()[0], std::byte{0xff});
+    ASSERT_NE(writer.back().data(), reader.front().data());
+  }
+}
+
+TEST(InterprocessTripleBuffer, ConcurrentWriterAndReader) {
+  constexpr std::uint64_t iter_size = 1'000'000;
+  auto writer =
+      TripleBuffer("TripleBufferConcurrent", true, true, sizeof(BookSnapshot));
+  auto reader = TripleBuffer("TripleBufferConcurrent", false, false);
+  std::atomic<bool> done = false;
+  std::thread thread_reader([&] {
+    std::uint64_t prev = 0;
+    while (!done.load(std::memory_order_relaxed)) {
+      if (!reader.refresh())
+        continue;
+      const auto &book = reader.front_as<BookSnapshot>();
+      EXPECT_EQ(book.levels[0], book.generation);
+      EXPECT_EQ(book.levels[4095], book.generation);
+      EXPECT_GT(book.generation, prev);
+      prev = book.generation;
+    }
+  });
+  for (std::uint64_t gen = 1; gen <= iter_size; ++gen) {
+    auto &book = writer.back_as<BookSnapshot>();
+    book.generation = gen;
+    book.levels[0] = gen;
+    book.levels[4095] = gen;
+    writer.publish(sizeof(BookSnapshot));
+  }
+  done = true;
+  thread_reader.join();
+}
@@ -0,0 +1,201 @@
+#include "../intraprocess/byte-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+namespace {
+std::string as_string(const std::span<const std::byte> msg) {
+  return {reinterpret_cast<const char *>(msg.data()), msg.size()};
+}
+} // namespace
+
+TEST(IntraprocessByteQueue, RoundTripsMessagesAcrossWraps) {
+  ByteQueue q(1000);
+  EXPECT_EQ(q.capacity(), 1024);
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> length(0, 300);
+  std::uint64_t written = 0;
+  std::uint64_t read = 0;
+  std::vector<std::string> sent;
+  std::string msg;
+  while (read < 5000) {
+    // Fill until full, then drain a random number of messages
+    while (true) {
+      std::string next(length(rng), static_cast<char>('a' + written % 26));
+      if (!q.enqueue(next))
+        break;
+      sent.push_back(std::move(next));
+      ++written;
+    }
+    EXPECT_GT(sent.size(), 0);
+    const auto to_read =
+        std::uniform_int_distribution<std::size_t>(1, sent.size())(rng);
+    for (std::size_t i = 0; i < to_read; ++i) {
+      ASSERT_TRUE(q.dequeue(msg));
+      ASSERT_EQ(msg, sent.front());
+      sent.erase(sent.begin());
+      ++read;
+    }
+  }
+}
+
+TEST(IntraprocessByteQueue, ReserveAndCommitWriteInPlace) {
+  ByteQueue q(256);
+  std::byte *dst = q.reserve(64);
+  ASSERT_NE(dst, nullptr);
+  // Nothing is visible before commit()
+  std::span<const std::byte> msg;
+  EXPECT_FALSE(q.peek(msg));
+  std::memcpy(dst, "hello", 5);
+  // The producer may publish less than it reserved, but not more
+  EXPECT_THROW(q.commit(65), std::length_error);
+  q.commit(5);
+  // A record is committed once, and a failed reserve() leaves nothing to
+  // commit
+  EXPECT_THROW(q.commit(0), std::logic_error);
+  ASSERT_TRUE(q.peek(msg));
+  EXPECT_EQ(as_string(msg), "hello");
+  // peek() keeps returning the same message until release()
+  ASSERT_TRUE(q.peek(msg));
+  EXPECT_EQ(as_string(msg), "hello");
+  q.release();
+  EXPECT_FALSE(q.peek(msg));
+  EXPECT_EQ(q.used_bytes(), 0);
+
+  while (q.reserve(q.max_message_size()) != nullptr) {
+    q.commit(q.max_message_size());
+  }
+  EXPECT_THROW(q.commit(0), std::logic_error);
+}
+
+TEST(IntraprocessByteQueue, FullAndEmpty) {
+  ByteQueue q(64);
+  // A record takes 8 bytes of header plus the payload rounded up to 8, and
+  // at most half the ring
+  EXPECT_EQ(q.max_message_size(), 24);
+  EXPECT_THROW(q.reserve(25), std::length_error);
+  EXPECT_FALSE(q.enqueue(std::string(25, 'x')));
+  EXPECT_TRUE(q.enqueue(std::string(24, 'x')));
+  EXPECT_TRUE(q.enqueue(std::string()));
+  EXPECT_TRUE(q.enqueue(std::string(8, 'y')));
+  EXPECT_EQ(q.used_bytes(), 32 + 8 + 16);
+  EXPECT_FALSE(q.enqueue(std::string(1, 'z')));
+  EXPECT_TRUE(q.enqueue(std::string()));
+  EXPECT_FALSE(q.enqueue(std::string()));
+
+  std::string msg;
+  EXPECT_TRUE(q.dequeue(msg));
+  EXPECT_EQ(msg, std::string(24, 'x'));
+  EXPECT_TRUE(q.dequeue(msg));
+  EXPECT_EQ(msg, "");
+  // The next record does not fit before the end and wraps to offset 0
+  EXPECT_TRUE(q.enqueue(std::string(16, 'w')));
+  EXPECT_TRUE(q.dequeue(msg));
+  EXPECT_EQ(msg, std::string(8, 'y'));
+  EXPECT_TRUE(q.dequeue(msg));
+  EXPECT_EQ(msg, "");
+  EXPECT_TRUE(q.dequeue(msg));
+  EXPECT_EQ(msg, std::string(16, 'w'));
+  EXPECT_FALSE(q.dequeue(msg));
+}
+
+TEST(IntraprocessByteQueue, LargestMessageFitsAtEveryOffset) {
+  ByteQueue q(256);
+  const std::string largest(q.max_message_size(), 'L');
+  std::string msg;
+  for (std::size_t shift = 0; shift < q.capacity(); shift += 8) {
+    // An empty ring whose tail sits at another offset each time
+    if (shift > 0) {
+      ASSERT_TRUE(q.enqueue(std::string()));
+      ASSERT_TRUE(q.dequeue(msg));
+    }
+    ASSERT_TRUE(q.enqueue(largest));
+    ASSERT_TRUE(q.dequeue(msg));
+    ASSERT_EQ(msg, largest);
+  }
+}
+
+TEST(IntraprocessByteQueue, HugePagesFallBackWhenNoneAreReserved) {
+  ByteQueue q(4096, {.huge_pages = true});
+  EXPECT_EQ(q.capacity(), 4096);
+  EXPECT_TRUE(q.enqueue(std::string("over huge pages")));
+  std::string msg;
+  EXPECT_TRUE(q.dequeue(msg));
+  EXPECT_EQ(msg, "over huge pages");
+}
+
+TEST(IntraprocessByteQueue, GatherAndConsumeAll) {
+  ByteQueue q(256);
+  const std::string part1 = "head-";
+  const std::string part2 = "payload";
+  const std::span<const std::byte> fragments[] = {std::as_bytes(std::span(part1)),
+                                                  std::as_bytes(std::span(part2))};
+  EXPECT_TRUE(q.enqueue_gather(fragments));
+  EXPECT_TRUE(q.enqueue(std::string("second")));
+  EXPECT_TRUE(q.enqueue(std::string("third")));
+  std::vector<std::string> received;
+  auto collect = [&](const std::span<const std::byte> msg) {
+    received.push_back(as_string(msg));
+  };
+  EXPECT_EQ(q.consume_up_to(1, collect), 1);
+  EXPECT_EQ(q.consume_all(collect), 2);
+  EXPECT_EQ(q.consume_all(collect), 0);
+  EXPECT_EQ(received,
+            (std::vector<std::string>{"head-payload", "second", "third"}));
+  EXPECT_EQ(q.used_bytes(), 0);
+}
+
+TEST(IntraprocessByteQueue, ConsumeUpToKeepsTheMessageFnThrewOn) {
+  ByteQueue q(256);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(q.enqueue(std::to_string(i)));
+  }
+  std::vector<std::string> taken;
+  EXPECT_THROW(q.consume_all([&](const std::span<const std::byte> msg) {
+    if (as_string(msg) == "2")
+      throw std::runtime_error("stop");
+    taken.push_back(as_string(msg));
+  }), std::runtime_error);
+  EXPECT_EQ(taken, (std::vector<std::string>{"0", "1"}));
+  std::string msg;
+  EXPECT_TRUE(q.dequeue(msg));
+  EXPECT_EQ(msg, "2");
+  EXPECT_EQ(q.consume_all([](std::span<const std::byte>) {}), 2);
+  EXPECT_EQ(q.used_bytes(), 0);
+}
+
+TEST(IntraprocessByteQueue, ConcurrentReserveCommitPeekRelease) {
+  constexpr std::uint64_t iterations = 200'000;
+  ByteQueue q(4096);
+  std::thread producer([&] {
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+      // Variable length messages carrying their sequence number
+      const std::size_t length = sizeof(i) + i % 97;
+      std::byte *dst;
+      while ((dst = q.reserve(length)) == nullptr) {
+      }
+      std::memcpy(dst, &i, sizeof(i));
+      q.commit(length);
+    }
+  });
+  std::span<const std::byte> msg;
+  for (std::uint64_t i = 0; i < iterations; ++i) {
+    while (!q.peek(msg)) {
+    }
+    std::uint64_t id;
+    ASSERT_EQ(msg.size(), sizeof(id) + i % 97);
+    std::memcpy(&id, msg.data(), sizeof(id));
+    ASSERT_EQ(id, i);
+    q.release();
+  }
+  producer.join();
+}
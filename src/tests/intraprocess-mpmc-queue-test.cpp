@@ -0,0 +1,160 @@
+#include "../intraprocess/mpmc-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+namespace {
+struct Counted {
+  static inline std::atomic<int> alive{0};
+  int value = 0;
+
+  Counted() { ++alive; }
+  explicit Counted(const int v) : value(v) { ++alive; }
+  Counted(const Counted &other) : value(other.value) { ++alive; }
+  Counted &operator=(const Counted &) = default;
+  ~Counted() { --alive; }
+};
+} // namespace
+
+TEST(IntraprocessMpmcQueue, FifoAndPositions) {
+  MpmcQueue<int> q;
+  int item;
+  EXPECT_FALSE(q.dequeue(item));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(q.enqueue(i));
+  }
+  EXPECT_EQ(q.tail(), 10);
+  EXPECT_EQ(q.head(), 0);
+  EXPECT_EQ(q.size_approx(), 10);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(q.dequeue(item));
+    EXPECT_EQ(item, i);
+  }
+  EXPECT_EQ(q.head(), 4);
+  std::vector<int> rest;
+  EXPECT_EQ(q.consume_all([&](const int v) { rest.push_back(v); }), 6);
+  EXPECT_EQ(rest, (std::vector<int>{4, 5, 6, 7, 8, 9}));
+  EXPECT_FALSE(q.dequeue(item));
+}
+
+TEST(IntraprocessMpmcQueue, GrowsPastItsPoolAndFreesEverything) {
+  {
+    MpmcQueue<Counted> q({.pooled_nodes = 16});
+    // Past the pool, nodes come from the heap and enqueue() still succeeds
+    for (int i = 0; i < 1000; ++i) {
+      ASSERT_TRUE(q.enqueue(Counted(i)));
+    }
+    Counted item;
+    for (int i = 0; i < 600; ++i) {
+      ASSERT_TRUE(q.dequeue(item));
+      ASSERT_EQ(item.value, i);
+    }
+    // 400 left in the queue, plus item
+    EXPECT_EQ(Counted::alive, 401);
+  }
+  // Remaining elements, retired and pooled nodes all released
+  EXPECT_EQ(Counted::alive, 0);
+}
+
+TEST(IntraprocessMpmcQueue, MoveOnlyElementsWithoutPool) {
+  MpmcQueue<std::unique_ptr<int>> q({.pooled_nodes = 0});
+  EXPECT_TRUE(q.enqueue(std::make_unique<int>(7)));
+  std::unique_ptr<int> item;
+  ASSERT_TRUE(q.dequeue(item));
+  EXPECT_EQ(*item, 7);
+}
+
+TEST(IntraprocessHazardDomain, ProtectedNodesOutliveTheirRetirement) {
+  static int reclaimed;
+  reclaimed = 0;
+  const auto count = [](void *, void *) { ++reclaimed; };
+  using Domain = Detail::HazardDomain<1>;
+  {
+    Domain domain;
+    int nodes[Domain::SCAN_THRESHOLD];
+    std::atomic<int *> shared{&nodes[0]};
+    std::atomic<bool> protected_{false};
+    std::atomic<bool> release{false};
+    std::thread reader_thread([&] {
+      Domain::Guard guard(domain);
+      EXPECT_EQ(guard.protect(0, shared), &nodes[0]);
+      protected_ = true;
+      while (!release) {
+        std::this_thread::yield();
+      }
+    });
+    while (!protected_) {
+      std::this_thread::yield();
+    }
+    {
+      Domain::Guard guard(domain);
+      // The last retire() triggers a scan, which must skip nodes[0]
+      for (int &node : nodes) {
+        guard.retire(&node, count, nullptr);
+      }
+    }
+    EXPECT_EQ(reclaimed, Domain::SCAN_THRESHOLD - 1);
+    EXPECT_EQ(domain.retired_approx(), 1);
+    release = true;
+    reader_thread.join();
+  }
+  EXPECT_EQ(reclaimed, Domain::SCAN_THRESHOLD);
+}
+
+TEST(IntraprocessMpmcQueue, ConcurrentProducersAndConsumers) {
+  constexpr int producers = 3;
+  constexpr int consumers = 3;
+  constexpr int per_producer = 100'000;
+  MpmcQueue<std::uint64_t> q({.pooled_nodes = 1024});
+  std::atomic<int> consumed{0};
+  std::vector<std::vector<std::uint64_t>> seen(consumers);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (std::uint64_t i = 0; i < per_producer; ++i) {
+        q.enqueue(static_cast<std::uint64_t>(p) << 32 | i);
+      }
+    });
+  }
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&, c] {
+      std::uint64_t item;
+      while (consumed.load() < producers * per_producer) {
+        if (q.dequeue(item)) {
+          seen[c].push_back(item);
+          ++consumed;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::vector<std::uint64_t> count(producers, 0);
+  for (const auto &items : seen) {
+    // Each consumer sees every producer's elements in order
+    std::vector<std::int64_t> last(producers, -1);
+    for (const std::uint64_t item : items) {
+      const auto p = item >> 32;
+      const auto i = static_cast<std::int64_t>(item & 0xffffffff);
+      ASSERT_GT(i, last[p]);
+      last[p] = i;
+      ++count[p];
+    }
+  }
+  for (const auto n : count) {
+    EXPECT_EQ(n, per_producer);
+  }
+  std::uint64_t item;
+  EXPECT_FALSE(q.dequeue(item));
+}
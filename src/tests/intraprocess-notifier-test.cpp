@@ -0,0 +1,71 @@
+#include "../intraprocess/notifier-impl.h"
+#include "../intraprocess/spsc-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <poll.h>
+
+#include <thread>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+namespace {
+bool readable(const int fd) {
+  pollfd pfd{fd, POLLIN, 0};
+  return poll(&pfd, 1, 0) == 1;
+}
+} // namespace
+
+TEST(IntraprocessNotifier, SignalsOnlyAWaitingConsumer) {
+  Notifier notifier;
+  // Nobody waits, so no syscall and nothing to read
+  notifier.notify();
+  EXPECT_FALSE(readable(notifier.fd()));
+
+  notifier.prepare_wait();
+  notifier.notify();
+  EXPECT_TRUE(readable(notifier.fd()));
+  // Once per prepare_wait()
+  notifier.acknowledge();
+  notifier.notify();
+  EXPECT_FALSE(readable(notifier.fd()));
+
+  notifier.prepare_wait();
+  notifier.cancel_wait();
+  notifier.notify();
+  EXPECT_FALSE(readable(notifier.fd()));
+  EXPECT_FALSE(notifier.wait(0));
+}
+
+TEST(IntraprocessNotifier, SleepingConsumerMissesNoMessage) {
+  constexpr int iterations = 100'000;
+  SpscQueue<int> q(64);
+  Notifier notifier;
+  std::thread producer([&] {
+    for (int i = 0; i < iterations; ++i) {
+      while (!q.enqueue(i)) {
+        std::this_thread::yield();
+      }
+      notifier.notify();
+    }
+  });
+  int expected = 0;
+  int sleeps = 0;
+  auto check = [&](const int &item) { EXPECT_EQ(item, expected++); };
+  while (expected < iterations) {
+    if (q.consume_all(check) > 0)
+      continue;
+    notifier.prepare_wait();
+    if (q.consume_all(check) > 0) {
+      notifier.cancel_wait();
+      continue;
+    }
+    // A lost wakeup would block here forever
+    ASSERT_TRUE(notifier.wait(10'000));
+    ++sleeps;
+  }
+  producer.join();
+  EXPECT_EQ(expected, iterations);
+  EXPECT_GT(sleeps, 0);
+}
@@ -0,0 +1,144 @@
+#include "../intraprocess/object-pool-impl.h"
+#include "../intraprocess/spsc-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+namespace {
+struct Message {
+  static inline std::atomic<int> alive{0};
+  std::uint64_t id;
+  char payload[100];
+
+  explicit Message(const std::uint64_t i) : id(i), payload{} { ++alive; }
+  ~Message() { --alive; }
+};
+} // namespace
+
+TEST(IntraprocessObjectPool, CreatesUpToCapacityOnCacheLines) {
+  ObjectPool<Message> pool(8);
+  EXPECT_EQ(pool.stride() % 64, 0);
+  EXPECT_GE(pool.stride(), sizeof(Message));
+  std::vector<Message *> messages;
+  for (std::uint64_t i = 0; i < 8; ++i) {
+    Message *msg = pool.create(i);
+    ASSERT_NE(msg, nullptr);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(msg) % 64, 0);
+    EXPECT_TRUE(pool.owns(msg));
+    messages.push_back(msg);
+  }
+  EXPECT_EQ(pool.create(99), nullptr);
+  EXPECT_EQ(Message::alive, 8);
+  const Message outsider(0);
+  EXPECT_FALSE(pool.owns(&outsider));
+
+  pool.destroy(messages[3]);
+  EXPECT_EQ(Message::alive, 8);
+  // The slot just freed is reused first
+  Message *again = pool.create(42);
+  EXPECT_EQ(again, messages[3]);
+  EXPECT_EQ(again->id, 42);
+  messages[3] = again;
+  for (Message *msg : messages) {
+    pool.destroy(msg);
+  }
+  EXPECT_EQ(Message::alive, 1);
+}
+
+TEST(IntraprocessObjectPool, ThrowingConstructorKeepsTheSlot) {
+  struct Picky {
+    explicit Picky(const bool fail) {
+      if (fail)
+        throw std::runtime_error("refused");
+    }
+  };
+  ObjectPool<Picky> pool(2);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_THROW(pool.create(true), std::runtime_error);
+  }
+  ObjectPool<Picky>::Cache cache(pool, 1);
+  EXPECT_THROW(cache.create(true), std::runtime_error);
+  // Neither call lost a slot
+  Picky *first = cache.create(false);
+  Picky *second = pool.create(false);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  EXPECT_EQ(pool.create(false), nullptr);
+  pool.destroy(first);
+  pool.destroy(second);
+}
+
+TEST(IntraprocessObjectPool, CachesMoveSlotsInBatches) {
+  ObjectPool<Message> pool(64, {.huge_pages = true});
+  std::vector<Message *> messages;
+  {
+    ObjectPool<Message>::Cache producer(pool, 16);
+    ObjectPool<Message>::Cache consumer(pool, 16);
+    // The producer's cache holds a batch of 16, the shared stack the rest
+    for (std::uint64_t i = 0; i < 64; ++i) {
+      Message *msg = producer.create(i);
+      ASSERT_NE(msg, nullptr);
+      messages.push_back(msg);
+    }
+    EXPECT_EQ(producer.create(64), nullptr);
+    EXPECT_EQ(pool.create(64), nullptr);
+    for (Message *msg : messages) {
+      consumer.destroy(msg);
+    }
+    // Spilled back in batches of 16, at most 2 * 16 - 1 stay cached
+    EXPECT_LT(consumer.cached(), 32);
+    EXPECT_EQ(Message::alive, 0);
+  }
+  // Destroying a cache hands its slots back
+  std::set<Message *> distinct;
+  for (std::uint64_t i = 0; i < 64; ++i) {
+    Message *msg = pool.create(i);
+    ASSERT_NE(msg, nullptr);
+    distinct.insert(msg);
+  }
+  EXPECT_EQ(distinct.size(), 64);
+  for (Message *msg : distinct) {
+    pool.destroy(msg);
+  }
+}
+
+TEST(IntraprocessObjectPool, ConcurrentProducerConsumerChurn) {
+  constexpr std::uint64_t iterations = 1'000'000;
+  ObjectPool<Message> pool(256);
+  SpscQueue<Message *> q(128);
+  std::thread producer([&] {
+    ObjectPool<Message>::Cache cache(pool);
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+      Message *msg;
+      while ((msg = cache.create(i)) == nullptr) {
+        std::this_thread::yield();
+      }
+      while (!q.enqueue(msg)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  {
+    ObjectPool<Message>::Cache cache(pool);
+    Message *msg;
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+      while (!q.dequeue(msg)) {
+        std::this_thread::yield();
+      }
+      ASSERT_EQ(msg->id, i);
+      cache.destroy(msg);
+    }
+  }
+  producer.join();
+  EXPECT_EQ(Message::alive, 0);
+}
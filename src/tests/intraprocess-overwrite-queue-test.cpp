@@ -0,0 +1,98 @@
+#include "../intraprocess/overwrite-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+namespace {
+struct TraceEvent {
+  std::uint64_t id;
+  std::uint64_t timestamp_ns;
+  std::uint32_t kind;
+};
+} // namespace
+
+TEST(IntraprocessOverwriteQueue, BehavesLikeAQueueUntilFull) {
+  OverwriteQueue<int> q(100);
+  EXPECT_EQ(q.capacity(), 128);
+  int item;
+  EXPECT_FALSE(q.dequeue(item));
+  for (int i = 0; i < 128; ++i) {
+    EXPECT_TRUE(q.enqueue(i));
+  }
+  for (int i = 0; i < 128; ++i) {
+    EXPECT_TRUE(q.dequeue(item));
+    EXPECT_EQ(item, i);
+  }
+  EXPECT_FALSE(q.dequeue(item));
+  EXPECT_EQ(q.dropped(), 0);
+}
+
+TEST(IntraprocessOverwriteQueue, ConsumeAllFallsBackToDequeue) {
+  OverwriteQueue<int> q(16);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(q.enqueue(i));
+  }
+  int expected = 0;
+  auto expect_next = [&](const int &item) { EXPECT_EQ(item, expected++); };
+  EXPECT_EQ(q.consume_up_to(4, expect_next), 4);
+  EXPECT_EQ(q.consume_all(expect_next), 6);
+  EXPECT_EQ(q.consume_all(expect_next), 0);
+}
+
+TEST(IntraprocessOverwriteQueue, OverwritesOldestAndCountsTheGap) {
+  OverwriteQueue<TraceEvent> q(16);
+  TraceEvent event{};
+  // Never full, the producer never waits
+  for (std::uint64_t i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(q.enqueue(TraceEvent{i, i * 10, 1}));
+  }
+  // Only the newest 16 survive
+  for (std::uint64_t i = 1000 - 16; i < 1000; ++i) {
+    EXPECT_TRUE(q.dequeue(event));
+    EXPECT_EQ(event.id, i);
+  }
+  EXPECT_FALSE(q.dequeue(event));
+  EXPECT_EQ(q.dropped(), 1000 - 16);
+
+  // Catching up again after a second gap
+  for (std::uint64_t i = 1000; i < 1020; ++i) {
+    q.enqueue(TraceEvent{i, i * 10, 1});
+  }
+  EXPECT_TRUE(q.dequeue(event));
+  EXPECT_EQ(event.id, 1020 - 16);
+  EXPECT_EQ(q.dropped(), 1000 - 16 + 4);
+}
+
+TEST(IntraprocessOverwriteQueue, ConcurrentConsumerSeesOrderedMessagesAndGaps) {
+  constexpr std::uint64_t iter_size = 20'000'000;
+  OverwriteQueue<TraceEvent> q(1024);
+  std::atomic<bool> done = false;
+  std::uint64_t received = 0;
+  std::thread consumer([&] {
+    TraceEvent event{};
+    while (true) {
+      // Read before dequeue(), so that nothing is left once it is set
+      const bool finished = done.load();
+      if (!q.dequeue(event)) {
+        if (finished)
+          break;
+        continue;
+      }
+      // Every message is either delivered in order or counted as dropped
+      EXPECT_EQ(event.id, received + q.dropped());
+      EXPECT_EQ(event.timestamp_ns, event.id * 10);
+      ++received;
+    }
+  });
+  for (std::uint64_t i = 0; i < iter_size; ++i) {
+    q.enqueue(TraceEvent{i, i * 10, 2});
+  }
+  done = true;
+  consumer.join();
+  EXPECT_EQ(received + q.dropped(), iter_size);
+}
@@ -0,0 +1,136 @@
+#include "../intraprocess/policy-queue-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+using namespace RingBuffer::Intraprocess::QueuePolicy;
+
+template<typename Queue>
+class IntraprocessPolicyQueue : public testing::Test {};
+
+using Combinations = testing::Types<
+    PolicyQueue<int>,
+    PolicyQueue<int, HeapStorage, WrapIndex<true>, StandaloneFences>,
+    PolicyQueue<int, InlineStorage<64>, MaskIndex<>, AcquireRelease,
+                SpinWait<16>>,
+    PolicyQueue<int, HugePageStorage, MaskIndex<true>, StandaloneFences,
+                YieldWait<4>, CountingStats>,
+    PolicyQueue<int, HeapStorage, MaskIndex<>, AcquireRelease, NoWait,
+                SojournSampling<8>>>;
+TYPED_TEST_SUITE(IntraprocessPolicyQueue, Combinations);
+
+TYPED_TEST(IntraprocessPolicyQueue, KeepsOrderAcrossWraps) {
+  // 64 is a power of two, so every index policy ends up with capacity 64
+  auto q = std::make_unique<TypeParam>(64);
+  EXPECT_EQ(q->capacity(), 64);
+  int item;
+  EXPECT_FALSE(q->dequeue(item));
+  int next_in = 0;
+  int next_out = 0;
+  for (int round = 0; round < 50; ++round) {
+    while (q->enqueue(next_in)) {
+      ++next_in;
+    }
+    EXPECT_EQ(q->size_approx(), 64);
+    for (int i = 0; i < 10 + round % 30; ++i) {
+      ASSERT_TRUE(q->dequeue(item));
+      ASSERT_EQ(item, next_out++);
+    }
+    EXPECT_EQ(q->consume_up_to(5, [&](const int &val) {
+      EXPECT_EQ(val, next_out++);
+    }), 5);
+  }
+  q->consume_all([&](const int &val) { EXPECT_EQ(val, next_out++); });
+  EXPECT_EQ(next_out, next_in);
+  EXPECT_EQ(q->size_approx(), 0);
+  EXPECT_EQ(q->head(), q->tail());
+}
+
+TYPED_TEST(IntraprocessPolicyQueue, ConcurrentProduceAndConsume) {
+  constexpr int iterations = 100'000;
+  auto q = std::make_unique<TypeParam>(64);
+  std::thread producer([&] {
+    for (int i = 0; i < iterations; ++i) {
+      while (!q->enqueue(i)) {
+      }
+    }
+  });
+  int item;
+  for (int i = 0; i < iterations; ++i) {
+    while (!q->dequeue(item)) {
+    }
+    ASSERT_EQ(item, i);
+  }
+  producer.join();
+}
+
+TEST(IntraprocessPolicyQueue, WrapIndexKeepsTheExactCapacity) {
+  PolicyQueue<std::string> wrapped(10);
+  EXPECT_EQ(wrapped.capacity(), 10);
+  PolicyQueue<std::string, HeapStorage, MaskIndex<>> masked(10);
+  EXPECT_EQ(masked.capacity(), 16);
+  EXPECT_THROW((PolicyQueue<int, InlineStorage<8>>(8)), std::length_error);
+}
+
+TEST(IntraprocessPolicyQueue, CountingStatsTrackCallsAndEmptyStatsAreFree) {
+  PolicyQueue<int, HeapStorage, WrapIndex<>, AcquireRelease, NoWait,
+              CountingStats>
+      q(2);
+  int item;
+  EXPECT_FALSE(q.dequeue(item));
+  EXPECT_TRUE(q.enqueue(1));
+  EXPECT_TRUE(q.enqueue(2));
+  EXPECT_FALSE(q.enqueue(3));
+  EXPECT_TRUE(q.dequeue(item));
+  EXPECT_EQ(q.consume_all([](int &) {}), 1);
+  EXPECT_EQ(q.stats().enqueued(), 2);
+  EXPECT_EQ(q.stats().full(), 1);
+  EXPECT_EQ(q.stats().dequeued(), 2);
+  EXPECT_EQ(q.stats().empty(), 1);
+  // NoStats takes no space, the defaults carry no policy state at all
+  static_assert(sizeof(PolicyQueue<int>) ==
+                sizeof(PolicyQueue<int, HeapStorage, MaskIndex<true>,
+                                   StandaloneFences, SpinWait<100>>));
+}
+
+TEST(IntraprocessPolicyQueue, SojournSamplingRecordsEveryNthMessage) {
+  // 3 is rounded up to 4
+  PolicyQueue<int, HeapStorage, MaskIndex<true>, AcquireRelease, NoWait,
+              SojournSampling<3>>
+      q(64);
+  int item;
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_TRUE(q.enqueue(i));
+    }
+    for (int i = 0; i < 5; ++i) {
+      ASSERT_TRUE(q.dequeue(item));
+    }
+    EXPECT_EQ(q.consume_all([](int &) {}), 5);
+  }
+  EXPECT_EQ(q.stats().sojourn().count(), 25);
+  EXPECT_EQ(q.stats().dropped_samples(), 0);
+  EXPECT_GT(q.stats().sojourn().max_ticks(), 0);
+  EXPECT_LE(q.stats().sojourn().ticks_at(50),
+            q.stats().sojourn().max_ticks());
+
+  // The stamp ring is sized from the capacity, so even a producer a full
+  // queue ahead keeps the stamps of the oldest messages
+  PolicyQueue<int, HeapStorage, WrapIndex<>, AcquireRelease, NoWait,
+              SojournSampling<1>>
+      deep(200);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 200; ++i) {
+      ASSERT_TRUE(deep.enqueue(i));
+    }
+    EXPECT_FALSE(deep.enqueue(0));
+    EXPECT_EQ(deep.consume_all([](int &) {}), 200);
+  }
+  EXPECT_EQ(deep.stats().sojourn().count(), 600);
+  EXPECT_EQ(deep.stats().dropped_samples(), 0);
+}
@@ -0,0 +1,103 @@
+#include "../intraprocess/seqlock-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+namespace {
+// Every field holds the same value, a torn read would mix two of them
+struct Quote {
+  std::uint64_t fields[9];
+
+  static Quote of(const std::uint64_t value) {
+    Quote quote{};
+    for (auto &field : quote.fields) {
+      field = value;
+    }
+    return quote;
+  }
+
+  [[nodiscard]] bool consistent() const {
+    for (const auto field : fields) {
+      if (field != fields[0])
+        return false;
+    }
+    return true;
+  }
+};
+} // namespace
+
+TEST(IntraprocessSeqlock, DequeueReturnsOnlyTheNewestValueOnce) {
+  Seqlock<int> channel;
+  int value = -1;
+  EXPECT_FALSE(channel.dequeue(value));
+  EXPECT_FALSE(channel.load(value));
+  for (int i = 1; i <= 100; ++i) {
+    // Never full, the writer never waits
+    EXPECT_TRUE(channel.enqueue(i));
+  }
+  EXPECT_EQ(channel.version(), 100);
+  EXPECT_TRUE(channel.dequeue(value));
+  EXPECT_EQ(value, 100);
+  EXPECT_FALSE(channel.dequeue(value));
+  EXPECT_TRUE(channel.load(value));
+  EXPECT_EQ(value, 100);
+
+  // Independent readers keep their own cursors
+  std::uint64_t reader_a = 0, reader_b = 0;
+  EXPECT_TRUE(channel.load_if_newer(value, reader_a));
+  EXPECT_FALSE(channel.load_if_newer(value, reader_a));
+  EXPECT_TRUE(channel.enqueue(101));
+  EXPECT_TRUE(channel.load_if_newer(value, reader_a));
+  EXPECT_TRUE(channel.load_if_newer(value, reader_b));
+  EXPECT_EQ(value, 101);
+  EXPECT_TRUE(channel.dequeue(value));
+}
+
+TEST(IntraprocessSeqlock, KeyedSlotsAreIndependent) {
+  KeyedSeqlock<Quote> book(4096);
+  EXPECT_EQ(book.size(), 4096);
+  Quote quote{};
+  EXPECT_FALSE(book.load(7, quote));
+  book.store(7, Quote::of(70));
+  book.store(4095, Quote::of(40950));
+  EXPECT_TRUE(book.load(7, quote));
+  EXPECT_EQ(quote.fields[8], 70);
+  EXPECT_TRUE(book.load(4095, quote));
+  EXPECT_EQ(quote.fields[0], 40950);
+  EXPECT_FALSE(book.load(8, quote));
+  EXPECT_EQ(book.version(7), 1);
+  EXPECT_THROW(book.store(4096, quote), std::out_of_range);
+}
+
+TEST(IntraprocessSeqlock, ConcurrentReadersNeverSeeTornValues) {
+  constexpr std::uint64_t iter_size = 20'000'000;
+  Seqlock<Quote> channel;
+  std::atomic<bool> done = false;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; ++i) {
+    readers.emplace_back([&] {
+      std::uint64_t last_version = 0;
+      std::uint64_t prev = 0;
+      Quote quote{};
+      while (!done.load(std::memory_order_relaxed)) {
+        if (!channel.load_if_newer(quote, last_version))
+          continue;
+        EXPECT_TRUE(quote.consistent());
+        EXPECT_GT(quote.fields[0], prev);
+        prev = quote.fields[0];
+      }
+    });
+  }
+  for (std::uint64_t i = 1; i <= iter_size; ++i) {
+    channel.enqueue(Quote::of(i));
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
@@ -3,7 +3,11 @@
 
 #include <gtest/gtest.h>
 
+#include <set>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
 using namespace RingBuffer;
 using namespace RingBuffer::Intraprocess;
@@ -250,6 +254,101 @@ TEST(IntreprocessSpscQueue, SPSCDoesNotForceStdMove) {
   }
 }
 
+TEST(IntreprocessSpscQueue, ConsumeUpToDrainsInPlaceAcrossWraps) {
+  constexpr std::size_t sz = 10;
+  SpscQueueImpl<int> rb(sz);
+  int next_in = 0;
+  int next_out = 0;
+  auto expect_next = [&](const int &val) { EXPECT_EQ(val, next_out++); };
+  EXPECT_EQ(rb.consume_all(expect_next), 0);
+  for (int round = 0; round < 100; ++round) {
+    while (rb.enqueue(next_in))
+      ++next_in;
+    EXPECT_EQ(rb.consume_up_to(3, expect_next), 3);
+    EXPECT_EQ(rb.consume_up_to(0, expect_next), 0);
+    EXPECT_EQ(rb.consume_all(expect_next), sz - 3);
+    EXPECT_EQ(rb.consume_all(expect_next), 0);
+    // Leave a partial queue behind so that the next round wraps
+    for (int i = 0; i < round % 7; ++i) {
+      EXPECT_TRUE(rb.enqueue(next_in++));
+    }
+    EXPECT_EQ(rb.consume_all(expect_next), round % 7);
+  }
+  EXPECT_EQ(next_out, next_in);
+  EXPECT_EQ(rb.head(), rb.tail());
+}
+
+TEST(IntreprocessSpscQueue, ConsumeUpToReleasesWhatFnFinishedBeforeThrowing) {
+  SpscQueue<std::string> rb(8);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(rb.enqueue(std::to_string(i)));
+  }
+  std::vector<std::string> taken;
+  EXPECT_THROW(rb.consume_all([&](std::string &val) {
+    if (val == "2")
+      throw std::runtime_error("stop");
+    taken.push_back(std::move(val));
+  }), std::runtime_error);
+  EXPECT_EQ(taken, (std::vector<std::string>{"0", "1"}));
+  // The moved-from elements are gone, the one fn threw on comes back
+  std::string val;
+  EXPECT_TRUE(rb.dequeue(val));
+  EXPECT_EQ(val, "2");
+  EXPECT_EQ(rb.size_approx(), 2);
+}
+
+TEST(IntreprocessSpscQueue, ConsumeAllHandsOutElementsByReference) {
+  SpscQueue<TestClassNotCopyable<int> > rb(4);
+  for (int i = 0; i < 4; ++i) {
+    auto t = TestClassNotCopyable<int>(1);
+    t.set(0, i);
+    EXPECT_TRUE(rb.enqueue(std::move(t)));
+  }
+  int expected = 0;
+  EXPECT_EQ(rb.consume_all([&](TestClassNotCopyable<int> &ele) {
+    // Elements may be moved out of the ring
+    const auto taken = std::move(ele);
+    EXPECT_EQ(taken.get(0), expected++);
+  }), 4);
+  TestClassNotCopyable<int> ele;
+  EXPECT_FALSE(rb.dequeue(ele));
+}
+
+template<typename Queue>
+void expect_swap_recycles_strings() {
+  constexpr std::size_t sz = 4;
+  Queue rb(sz);
+  std::string out;
+  std::set<const char *> storage;
+  auto round_trip = [&](const int i) {
+    // Longer than any small string buffer, so every string owns heap storage
+    const std::string msg(100, static_cast<char>('a' + i % 26));
+    EXPECT_TRUE(rb.enqueue_with([&](std::string &slot) { slot.assign(msg); }));
+    EXPECT_TRUE(rb.dequeue_swap(out));
+    EXPECT_EQ(out, msg);
+  };
+  // Every slot and the consumer's string allocate once...
+  for (int i = 0; i < 2 * static_cast<int>(sz + 1); ++i) {
+    round_trip(i);
+    storage.insert(out.data());
+  }
+  // ...then the same buffers go around forever
+  for (int i = 0; i < 1000; ++i) {
+    round_trip(i);
+    EXPECT_TRUE(storage.contains(out.data()));
+  }
+  EXPECT_FALSE(rb.dequeue_swap(out));
+  for (std::size_t i = 0; i < sz; ++i) {
+    EXPECT_TRUE(rb.enqueue_with([](std::string &slot) { slot = "x"; }));
+  }
+  EXPECT_FALSE(rb.enqueue_with([](std::string &) { FAIL(); }));
+}
+
+TEST(IntreprocessSpscQueue, DequeueSwapHandsStorageBackToTheProducer) {
+  expect_swap_recycles_strings<SpscQueue<std::string> >();
+  expect_swap_recycles_strings<SpscQueueBeta<std::string> >();
+}
+
 TEST(IntreprocessSpscQueue, SPSCConcurrentProduceAndConsume) {
   // large iter_size takes time to complete, but it can expose rare race condition!
   constexpr std::uint64_t iter_size = 5'735'955'187;
@@ -0,0 +1,62 @@
+#include "../intraprocess/triple-buffer-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer::Intraprocess;
+
+TEST(IntraprocessTripleBuffer, ReaderGetsTheNewestSnapshotByReference) {
+  TripleBuffer<std::vector<int>> snapshots(1000, 0);
+  EXPECT_FALSE(snapshots.refresh());
+  EXPECT_EQ(snapshots.front().size(), 1000);
+
+  for (int i = 1; i <= 3; ++i) {
+    auto &back = snapshots.back();
+    EXPECT_EQ(back.size(), 1000);
+    back.assign(1000, i);
+    snapshots.publish();
+  }
+  EXPECT_TRUE(snapshots.has_fresh());
+  EXPECT_TRUE(snapshots.refresh());
+  const auto *front = &snapshots.front();
+  EXPECT_EQ(front->front(), 3);
+  EXPECT_FALSE(snapshots.refresh());
+
+  // Writing more snapshots never touches the buffer the reader holds
+  for (int i = 4; i <= 10; ++i) {
+    snapshots.back().assign(1000, i);
+    snapshots.publish();
+    EXPECT_NE(&snapshots.back(), front);
+    EXPECT_EQ(front->back(), 3);
+  }
+  EXPECT_TRUE(snapshots.refresh());
+  EXPECT_EQ(snapshots.front()[999], 10);
+}
+
+TEST(IntraprocessTripleBuffer, ConcurrentWriterAndReader) {
+  constexpr int iter_size = 2'000'000;
+  constexpr int width = 64;
+  TripleBuffer<std::vector<int>> snapshots(width, 0);
+  std::atomic<bool> done = false;
+  std::thread reader([&] {
+    int prev = 0;
+    while (!done.load(std::memory_order_relaxed)) {
+      if (!snapshots.refresh())
+        continue;
+      const auto &front = snapshots.front();
+      // A torn snapshot would mix two generations
+      EXPECT_EQ(front.front(), front.back());
+      EXPECT_GT(front.front(), prev);
+      prev = front.front();
+    }
+  });
+  for (int i = 1; i <= iter_size; ++i) {
+    snapshots.back().assign(width, i);
+    snapshots.publish();
+  }
+  done = true;
+  reader.join();
+}
@@ -0,0 +1,129 @@
+#include "../intraprocess/work-stealing-deque-impl.h"
+#include "../intraprocess/work-stealing-pool-impl.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+namespace {
+std::uint64_t parallel_sum(WorkStealingPool &pool,
+                           const std::vector<std::uint64_t> &values,
+                           const std::size_t lo, const std::size_t hi) {
+  if (hi - lo <= 1000)
+    return std::accumulate(values.begin() + lo, values.begin() + hi,
+                           std::uint64_t{0});
+  const std::size_t mid = lo + (hi - lo) / 2;
+  std::uint64_t left = 0;
+  WorkStealingPool::TaskGroup group(pool);
+  group.run([&] { left = parallel_sum(pool, values, lo, mid); });
+  const std::uint64_t right = parallel_sum(pool, values, mid, hi);
+  group.wait();
+  return left + right;
+}
+} // namespace
+
+TEST(IntraprocessWorkStealingDeque, OwnerIsLifoThievesAreFifo) {
+  WorkStealingDeque<int> deque(4);
+  int value;
+  EXPECT_FALSE(deque.pop(value));
+  EXPECT_FALSE(deque.steal(value));
+  for (int i = 0; i < 100; ++i) {
+    deque.push(i);
+  }
+  // Grew from 4 slots on demand
+  EXPECT_GE(deque.capacity(), 100);
+  EXPECT_EQ(deque.size_approx(), 100);
+  EXPECT_TRUE(deque.steal(value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(deque.pop(value));
+  EXPECT_EQ(value, 99);
+  for (int i = 1; i < 99; ++i) {
+    EXPECT_TRUE(deque.steal(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(deque.pop(value));
+  EXPECT_FALSE(deque.steal(value));
+}
+
+TEST(IntraprocessWorkStealingDeque, ConcurrentEveryElementTakenExactlyOnce) {
+  constexpr int items = 200'000;
+  constexpr int thieves = 3;
+  WorkStealingDeque<int> deque(8);
+  std::vector<std::atomic<int>> taken(items);
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thieves; ++t) {
+    threads.emplace_back([&] {
+      int value;
+      while (!done.load(std::memory_order_acquire) || deque.size_approx() > 0) {
+        if (deque.steal(value))
+          taken[value].fetch_add(1);
+      }
+    });
+  }
+  int value;
+  for (int i = 0; i < items; ++i) {
+    deque.push(i);
+    // Keep the deque short so that owner and thieves fight over the last
+    // element
+    if (i % 3 == 0 && deque.pop(value))
+      taken[value].fetch_add(1);
+  }
+  while (deque.pop(value)) {
+    taken[value].fetch_add(1);
+  }
+  done.store(true, std::memory_order_release);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < items; ++i) {
+    ASSERT_EQ(taken[i].load(), 1) << "element " << i;
+  }
+}
+
+TEST(IntraprocessWorkStealingPool, ForkJoinSum) {
+  WorkStealingPool pool(4);
+  EXPECT_EQ(pool.thread_count(), 4);
+  std::vector<std::uint64_t> values(1'000'000);
+  std::iota(values.begin(), values.end(), 1);
+  EXPECT_EQ(parallel_sum(pool, values, 0, values.size()),
+            values.size() * (values.size() + 1) / 2);
+}
+
+TEST(IntraprocessWorkStealingPool, ManyTasksFromOutsideThePool) {
+  WorkStealingPool pool(3);
+  std::atomic<int> ran{0};
+  {
+    WorkStealingPool::TaskGroup group(pool);
+    for (int i = 0; i < 10'000; ++i) {
+      group.run([&] { ran.fetch_add(1, std::memory_order_relaxed); });
+    }
+    group.wait();
+  }
+  EXPECT_EQ(ran.load(), 10'000);
+}
+
+TEST(IntraprocessWorkStealingPool, WaitRethrowsTaskExceptions) {
+  WorkStealingPool pool(2);
+  WorkStealingPool::TaskGroup group(pool);
+  std::atomic<int> ran{0};
+  for (int i = 0; i < 100; ++i) {
+    group.run([&, i] {
+      ran.fetch_add(1);
+      if (i == 42)
+        throw std::runtime_error("task 42");
+    });
+  }
+  EXPECT_THROW(group.wait(), std::runtime_error);
+  // The other tasks still ran
+  EXPECT_EQ(ran.load(), 100);
+}
@@ -0,0 +1,144 @@
+#include "../intraprocess/spsc-queue-impl.h"
+#include "../ringbuffer-async.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace RingBuffer;
+using namespace RingBuffer::Intraprocess;
+
+namespace {
+Task produce(SpscQueue<int> &q, const int count) {
+  for (int i = 0; i < count; ++i) {
+    co_await async_enqueue(q, i);
+  }
+}
+
+Task consume(SpscQueue<int> &q, const int count, int &received) {
+  int item;
+  for (int i = 0; i < count; ++i) {
+    co_await async_dequeue(q, item);
+    EXPECT_EQ(item, i);
+    ++received;
+  }
+}
+
+Task forward(SpscQueue<std::string> &in, SpscQueue<std::string> &out,
+             const int count) {
+  std::string msg;
+  for (int i = 0; i < count; ++i) {
+    co_await async_dequeue(in, msg);
+    co_await async_enqueue(out, msg + "!");
+  }
+}
+
+Task hold(SpscQueue<int> &q, const std::shared_ptr<int> token) {
+  int item;
+  co_await async_dequeue(q, item);
+  *token += item;
+}
+
+Task fail() {
+  co_await std::suspend_never{};
+  throw std::runtime_error("task failed");
+}
+} // namespace
+
+TEST(RingBufferAsync, FastPathDoesNotSuspend) {
+  SpscQueue<int> q(16);
+  Scheduler sched;
+  int received = 0;
+  // The consumer runs first, so it has to wait for the producer once
+  sched.spawn(consume(q, 10, received));
+  sched.spawn(produce(q, 10));
+  sched.run();
+  EXPECT_EQ(received, 10);
+  EXPECT_EQ(sched.suspensions(), 1);
+  EXPECT_EQ(sched.live_tasks(), 0);
+}
+
+TEST(RingBufferAsync, TasksTakeTurnsOnATinyQueue) {
+  SpscQueue<int> q(2);
+  Scheduler sched;
+  int received = 0;
+  sched.spawn(produce(q, 10'000));
+  sched.spawn(consume(q, 10'000, received));
+  sched.run();
+  EXPECT_EQ(received, 10'000);
+  EXPECT_GT(sched.suspensions(), 0);
+}
+
+TEST(RingBufferAsync, ThousandsOfTasksShareOneThread) {
+  constexpr int pipelines = 1000;
+  constexpr int count = 20;
+  std::vector<std::unique_ptr<SpscQueue<std::string>>> queues;
+  Scheduler sched;
+  // source -> forward -> sink, all on one thread
+  for (int p = 0; p < pipelines; ++p) {
+    queues.push_back(std::make_unique<SpscQueue<std::string>>(1));
+    queues.push_back(std::make_unique<SpscQueue<std::string>>(1));
+    sched.spawn(forward(*queues[2 * p], *queues[2 * p + 1], count));
+  }
+  for (int i = 0; i < count; ++i) {
+    for (int p = 0; p < pipelines; ++p) {
+      while (!queues[2 * p]->enqueue(std::to_string(i))) {
+        sched.run_once();
+      }
+    }
+    sched.run_once();
+    std::string msg;
+    for (int p = 0; p < pipelines; ++p) {
+      while (!queues[2 * p + 1]->dequeue(msg)) {
+        sched.run_once();
+      }
+      EXPECT_EQ(msg, std::to_string(i) + "!");
+    }
+  }
+  sched.run();
+  EXPECT_EQ(sched.live_tasks(), 0);
+}
+
+TEST(RingBufferAsync, PeerOnAnotherThread) {
+  SpscQueue<int> q(8);
+  Scheduler sched;
+  int received = 0;
+  sched.spawn(consume(q, 100'000, received));
+  std::thread producer([&] {
+    for (int i = 0; i < 100'000; ++i) {
+      while (!q.enqueue(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  sched.run();
+  producer.join();
+  EXPECT_EQ(received, 100'000);
+}
+
+TEST(RingBufferAsync, RunRethrowsWhatEscapesATask) {
+  Scheduler sched;
+  sched.spawn(fail());
+  EXPECT_THROW(sched.run(), std::runtime_error);
+  EXPECT_EQ(sched.live_tasks(), 0);
+  // A task that was never spawned is destroyed with its Task
+  const Task unspawned = fail();
+}
+
+TEST(RingBufferAsync, SchedulerDestroysUnfinishedTasks) {
+  SpscQueue<int> q(8);
+  const auto token = std::make_shared<int>(0);
+  {
+    Scheduler sched;
+    sched.spawn(hold(q, token));
+    sched.spawn(hold(q, token));
+    sched.run_once(); // both park on the empty queue
+    sched.spawn(hold(q, token)); // never resumed
+    EXPECT_EQ(token.use_count(), 4);
+  }
+  EXPECT_EQ(token.use_count(), 1);
+}
@@ -0,0 +1,321 @@
+#include "../detail/sojourn.h"
+#include "../interprocess/segment-header.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/* A read-only "top" for the toolkit's shared memory segments. Lists every
+ * segment in /dev/shm that starts with a SegmentHeader, and for segments
+ * created with SegmentOptions::stats shows occupancy, rates, stalls and how
+ * long ago each endpoint was last active, and for segments created with
+ * SegmentOptions::sojourn_sample_every the sampled time messages spent in
+ * the queue:
+ *
+ *   queue-top [--interval-ms 1000] [--once] [NAME_FILTER]
+ *
+ * Segments are mapped PROT_READ and only the header, the stats lines and the
+ * sojourn histogram are read, never a queue's head, tail or payload, so
+ * watching a production channel costs it nothing but the occasional reload of
+ * a stats line.
+ * Rates are the difference between two samples interval-ms apart; --once
+ * prints a single table after one interval, otherwise the table refreshes
+ * until Ctrl-C.
+ */
+
+using namespace RingBuffer::Interprocess;
+
+namespace {
+volatile std::sig_atomic_t interrupted = 0;
+
+void handle_interrupt(int) { interrupted = 1; }
+
+struct Options {
+  std::uint64_t interval_ms = 1000;
+  bool once = false;
+  std::string filter;
+};
+
+struct Sample {
+  std::string name;
+  SegmentHeader header;
+  bool has_stats = false;
+  SegmentStats stats;
+  // Sojourn percentiles in ns, count 0 without sampling
+  std::uint64_t sojourn_count = 0;
+  std::uint64_t sojourn_p50 = 0;
+  std::uint64_t sojourn_p99 = 0;
+  std::uint64_t sojourn_max = 0;
+};
+
+const char *kind_name(const SegmentKind kind) {
+  switch (kind) {
+  case SegmentKind::SpscQueue:
+    return "spsc";
+  case SegmentKind::BroadcastQueue:
+    return "broadcast";
+  case SegmentKind::MpscQueue:
+    return "mpsc";
+  case SegmentKind::Seqlock:
+    return "seqlock";
+  case SegmentKind::TripleBuffer:
+    return "triple";
+  case SegmentKind::OverwriteQueue:
+    return "overwrite";
+  case SegmentKind::Notifier:
+    return "notifier";
+  case SegmentKind::BlobArena:
+    return "blob-arena";
+  }
+  return "?";
+}
+
+/// Maps the control area of the file read-only, copies the header, the
+/// stats and the sojourn percentiles and unmaps it again.
+/// @return false if the file is not a complete toolkit segment
+bool read_segment(const std::filesystem::path &path, Sample &sample) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st {};
+  bool ok = false;
+  if (fstat(fd, &st) == 0 &&
+      static_cast<std::size_t>(st.st_size) >= sizeof(SegmentHeader)) {
+    const auto size = static_cast<std::size_t>(st.st_size);
+    // The header page holds the stats of every kind that has any, only the
+    // sojourn log may reach beyond it, but never beyond header_size
+    std::size_t length = std::min(size, page_size());
+    void *addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED) {
+      // Any kind will do, as long as its owner finished publishing it
+      std::memcpy(&sample.header, addr, sizeof(SegmentHeader));
+      ok = sample.header.magic == SegmentHeader::MAGIC &&
+           sample.header.version == SegmentHeader::VERSION;
+      const bool spsc = ok && sample.header.kind == SegmentKind::SpscQueue;
+      const std::uint64_t stats_offset = sample.header.params[1];
+      const std::uint64_t sojourn_offset = sample.header.params[2];
+      if (spsc && sojourn_offset != 0 &&
+          sample.header.header_size > length &&
+          sample.header.header_size <= size) {
+        munmap(addr, length);
+        length = sample.header.header_size;
+        addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+      }
+      if (addr == MAP_FAILED) {
+        close(fd);
+        return false;
+      }
+      const auto base = static_cast<const char *>(addr);
+      sample.has_stats = spsc && stats_offset != 0 &&
+                         stats_offset + sizeof(SegmentStats) <= length;
+      if (sample.has_stats)
+        std::memcpy(&sample.stats, base + stats_offset, sizeof(SegmentStats));
+      if (spsc && sojourn_offset != 0 &&
+          sojourn_offset + sizeof(RingBuffer::Detail::SojournLog) <= length) {
+        const auto &histogram =
+            reinterpret_cast<const RingBuffer::Detail::SojournLog *>(
+                base + sojourn_offset)
+                ->histogram;
+        sample.sojourn_count = histogram.count();
+        sample.sojourn_p50 = histogram.ns_at(50);
+        sample.sojourn_p99 = histogram.ns_at(99);
+        sample.sojourn_max = histogram.max_ns();
+      }
+      munmap(addr, length);
+    }
+  }
+  close(fd);
+  return ok;
+}
+
+std::vector<Sample> take_samples(const Options &opts) {
+  std::vector<Sample> samples;
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator("/dev/shm", ec)) {
+    const std::string name = entry.path().filename().string();
+    if (!entry.is_regular_file(ec) ||
+        (!opts.filter.empty() && name.find(opts.filter) == std::string::npos))
+      continue;
+    Sample sample;
+    sample.name = name;
+    if (read_segment(entry.path(), sample))
+      samples.push_back(sample);
+  }
+  return samples;
+}
+
+std::string human_bytes(double bytes) {
+  const char *units[] = {"B", "K", "M", "G", "T"};
+  int unit = 0;
+  while (bytes >= 1024 && unit < 4) {
+    bytes /= 1024;
+    ++unit;
+  }
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << bytes
+      << units[unit];
+  return out.str();
+}
+
+std::string ago(const std::int64_t then_ns, const std::int64_t now_ns) {
+  if (then_ns == 0)
+    return "never";
+  const double secs = (now_ns - then_ns) / 1e9;
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(secs < 10 ? 1 : 0)
+      << std::max(secs, 0.0) << "s";
+  return out.str();
+}
+
+std::string ns_column(const Sample &sample, const std::uint64_t ns) {
+  if (sample.sojourn_count == 0)
+    return "-";
+  std::ostringstream out;
+  if (ns < 10'000)
+    out << ns << "ns";
+  else if (ns < 10'000'000)
+    out << ns / 1000 << "us";
+  else
+    out << ns / 1'000'000 << "ms";
+  return out.str();
+}
+
+std::string pid_column(const std::uint64_t pid) {
+  if (pid == 0)
+    return "-";
+  return std::to_string(pid) + (process_alive(pid) ? "" : "!");
+}
+
+void print_table(const std::vector<Sample> &before,
+                 const std::vector<Sample> &after, const double secs) {
+  const std::int64_t now = coarse_epoch_ns();
+  std::cout << std::left << std::setw(28) << "NAME" << std::setw(11) << "KIND"
+            << std::right << std::setw(8) << "SIZE" << std::setw(9)
+            << "INFLIGHT" << std::setw(7) << "FILL%" << std::setw(7)
+            << "HIGH%" << std::setw(11) << "MSG/S" << std::setw(9) << "B/S"
+            << std::setw(10) << "FULL/S" << std::setw(8) << "P-IDLE"
+            << std::setw(8) << "C-IDLE" << std::setw(10) << "P-PID"
+            << std::setw(10) << "C-PID" << std::setw(9) << "SOJ-P50"
+            << std::setw(9) << "SOJ-P99" << std::setw(9) << "SOJ-MAX"
+            << "\n";
+  for (const auto &cur : after) {
+    std::cout << std::left << std::setw(28) << cur.name.substr(0, 27)
+              << std::setw(11) << kind_name(cur.header.kind) << std::right
+              << std::setw(8) << human_bytes(cur.header.queue_size);
+    if (!cur.has_stats) {
+      std::cout << std::setw(9) << "-";
+      if (cur.sojourn_count > 0) {
+        for (const int width : {7, 7, 11, 9, 10, 8, 8, 10, 10}) {
+          std::cout << std::setw(width) << "-";
+        }
+        std::cout << std::setw(9) << ns_column(cur, cur.sojourn_p50)
+                  << std::setw(9) << ns_column(cur, cur.sojourn_p99)
+                  << std::setw(9) << ns_column(cur, cur.sojourn_max);
+      }
+      std::cout << "\n";
+      continue;
+    }
+    const Sample *prev = nullptr;
+    for (const auto &old : before) {
+      if (old.name == cur.name && old.has_stats &&
+          old.header.creation_epoch_ns == cur.header.creation_epoch_ns)
+        prev = &old;
+    }
+    const auto &p = cur.stats.producer;
+    const auto &c = cur.stats.consumer;
+    const double size = static_cast<double>(cur.header.queue_size);
+    const std::uint64_t in_flight =
+        p.messages > c.messages ? p.messages - c.messages : 0;
+    const double fill =
+        p.bytes > c.bytes ? 100.0 * (p.bytes - c.bytes) / size : 0;
+    std::cout << std::setw(9) << in_flight << std::fixed
+              << std::setprecision(1) << std::setw(7) << fill << std::setw(7)
+              << 100.0 * p.high_water / size;
+    if (prev != nullptr && secs > 0) {
+      const auto &pp = prev->stats.producer;
+      std::cout << std::setprecision(0) << std::setw(11)
+                << (c.messages - prev->stats.consumer.messages) / secs
+                << std::setw(9)
+                << human_bytes((c.bytes - prev->stats.consumer.bytes) / secs)
+                << std::setw(10) << (p.stalls - pp.stalls) / secs;
+    } else {
+      std::cout << std::setw(11) << "-" << std::setw(9) << "-"
+                << std::setw(10) << "-";
+    }
+    std::cout << std::setw(8) << ago(p.last_active_ns, now) << std::setw(8)
+              << ago(c.last_active_ns, now) << std::setw(10)
+              << pid_column(p.pid) << std::setw(10) << pid_column(c.pid)
+              << std::setw(9) << ns_column(cur, cur.sojourn_p50)
+              << std::setw(9) << ns_column(cur, cur.sojourn_p99)
+              << std::setw(9) << ns_column(cur, cur.sojourn_max) << "\n";
+  }
+  std::cout << std::flush;
+}
+
+Options parse_options(const int argc, char *argv[]) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--interval-ms" && i + 1 < argc) {
+      opts.interval_ms = std::stoull(argv[++i]);
+    } else if (arg == "--once") {
+      opts.once = true;
+    } else if (!arg.starts_with("-") && opts.filter.empty()) {
+      opts.filter = arg;
+    } else {
+      throw std::invalid_argument("Unknown option " + std::string(arg));
+    }
+  }
+  return opts;
+}
+} // namespace
+
+int main(const int argc, char *argv[]) {
+  Options opts;
+  try {
+    opts = parse_options(argc, argv);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n"
+              << "usage: queue-top [--interval-ms 1000] [--once] "
+                 "[NAME_FILTER]\n";
+    return EXIT_FAILURE;
+  }
+  std::signal(SIGINT, handle_interrupt);
+  std::signal(SIGTERM, handle_interrupt);
+
+  using namespace std::chrono;
+  auto before = take_samples(opts);
+  auto t_before = steady_clock::now();
+  while (!interrupted) {
+    std::this_thread::sleep_for(milliseconds(opts.interval_ms));
+    auto after = take_samples(opts);
+    const auto t_after = steady_clock::now();
+    if (!opts.once)
+      std::cout << "\033[H\033[2J";
+    print_table(before, after,
+                duration<double>(t_after - t_before).count());
+    if (opts.once)
+      break;
+    before = std::move(after);
+    t_before = t_after;
+  }
+  return 0;
+}